@@ -1,15 +1,25 @@
 out vec4 frag_color;
 in vec2 tex_coord;
 
-uniform vec4 d_rect;
-uniform float border_size;
-uniform vec3 inner_color;
-uniform vec4 subrect;
+flat in vec4 f_d_rect;
+flat in vec4 f_subrect;
+flat in vec3 f_inner_color;
+flat in float f_border_size;
+flat in uvec2 f_subroutines_index;
+flat in uint f_layer;
+
+// per quad parameters, either from the uniforms or from the instance being drawn
+vec4 d_rect;
+float border_size;
+vec3 inner_color;
+vec4 subrect;
+uvec2 subroutines_index;
+
 uniform float gamma;
-uniform uvec2 subroutines_index;
 
 uniform sampler2D texture_sampler;
 uniform sampler2D secondary_texture_sampler;
+uniform sampler2DArray glyph_sampler;
 
 vec4 gamma_correct(vec4 colour) {
 	return vec4(pow(colour.rgb, vec3(1.f / gamma)), colour.a);
@@ -197,6 +207,25 @@ vec4 corners(vec2 tc) {
 	return texture(texture_sampler, vec2(xout, yout) / border_size);
 }
 
+// svg atlas pages hold premultiplied alpha: filter first, then un-premultiply for the straight alpha blend
+//layout(index = 27) subroutine(font_function_class)
+vec4 atlas_sprite(vec2 tc) {
+	vec4 color = texture(texture_sampler, vec2(tc.x * subrect.y + subrect.x, tc.y * subrect.a + subrect.z));
+	return color.a > 0.0 ? vec4(color.rgb / color.a, color.a) : vec4(0.0);
+}
+
+//layout(index = 28) subroutine(font_function_class)
+vec4 glyph(vec2 tc) {
+	return vec4(inner_color, texture(glyph_sampler, vec3(tc.x * subrect.y + subrect.x, tc.y * subrect.a + subrect.z, float(f_layer))).r);
+}
+
+//layout(index = 29) subroutine(font_function_class)
+vec4 sdf_glyph(vec2 tc) {
+	// 0.5 is the outline, border_size is the width of one screen pixel in the distance field
+	float distance = texture(glyph_sampler, vec3(tc.x * subrect.y + subrect.x, tc.y * subrect.a + subrect.z, float(f_layer))).r;
+	return vec4(inner_color, smoothstep(0.5 - border_size * 0.5, 0.5 + border_size * 0.5, distance));
+}
+
 //layout(index = 18) subroutine(font_function_class)
 vec4 transparent_color(vec2 tc) {
 	return vec4(inner_color, 0.5);
@@ -260,6 +289,9 @@ case 23: return stripchart(tc);
 case 24: return triangle_strip(tc);
 case 25: return fixed_size_repeat_border(tc);
 case 26: return corners(tc);
+case 27: return atlas_sprite(tc);
+case 28: return glyph(tc);
+case 29: return sdf_glyph(tc);
 default: break;
 	}
 	return vec4(0.f, 0.f, 1.f, 1.f);
@@ -278,5 +310,10 @@ default: break;
 }
 
 void main() {
+	d_rect = f_d_rect;
+	border_size = f_border_size;
+	inner_color = f_inner_color;
+	subrect = f_subrect;
+	subroutines_index = f_subroutines_index;
 	frag_color = gamma_correct(coloring_function(font_function(tex_coord)));
 }
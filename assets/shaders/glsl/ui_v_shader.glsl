@@ -1,6 +1,20 @@
 layout (location = 0) in vec2 vertex_position; //0
 layout (location = 1) in vec2 v_tex_coord; //1
+// per instance attributes, only read when drawing a batch of quads
+layout (location = 2) in vec4 instance_d_rect;
+layout (location = 3) in vec4 instance_subrect;
+layout (location = 4) in vec4 instance_inner_color; // .a holds the border size
+layout (location = 5) in vec4 instance_tex_transform;
+layout (location = 6) in vec2 instance_tex_offset;
+layout (location = 7) in uvec2 instance_subroutines;
+layout (location = 8) in uint instance_layer;
 out vec2 tex_coord;
+flat out vec4 f_d_rect;
+flat out vec4 f_subrect;
+flat out vec3 f_inner_color;
+flat out float f_border_size;
+flat out uvec2 f_subroutines_index;
+flat out uint f_layer;
 
 uniform float screen_width;
 uniform float screen_height;
@@ -10,13 +24,37 @@ uniform float screen_height;
 // d_rect.z - width
 // d_rect.w - height
 uniform vec4 d_rect;
+uniform float border_size;
+uniform vec3 inner_color;
+uniform vec4 subrect;
+uniform uvec2 subroutines_index;
+// 0 - single quad described by the uniforms above
+// 1 - batch of quads described by the instance attributes
+uniform uint instanced;
 
 void main() {
+	if(instanced != 0u) {
+		f_d_rect = instance_d_rect;
+		f_subrect = instance_subrect;
+		f_inner_color = instance_inner_color.rgb;
+		f_border_size = instance_inner_color.a;
+		f_subroutines_index = instance_subroutines;
+		f_layer = instance_layer;
+		// the instance carries the rotation/flip as an affine map from the unit square to texture coordinates
+		tex_coord = mat2(instance_tex_transform.xy, instance_tex_transform.zw) * vertex_position + instance_tex_offset;
+	} else {
+		f_d_rect = d_rect;
+		f_subrect = subrect;
+		f_inner_color = inner_color;
+		f_border_size = border_size;
+		f_subroutines_index = subroutines_index;
+		f_layer = 0u;
+		tex_coord = v_tex_coord;
+	}
 	// Transform the d_rect rectangle to screen space coordinates
 	// vertex_position is used to flip and/or rotate the coordinates
 	gl_Position = vec4(
-		-1.0 + (2.0 * ((vertex_position.x * d_rect.z)  + d_rect.x) / screen_width),
-		 1.0 - (2.0 * ((vertex_position.y * d_rect.w)  + d_rect.y) / screen_height),
+		-1.0 + (2.0 * ((vertex_position.x * f_d_rect.z)  + f_d_rect.x) / screen_width),
+		 1.0 - (2.0 * ((vertex_position.y * f_d_rect.w)  + f_d_rect.y) / screen_height),
 		0.0, 1.0);
-	tex_coord = v_tex_coord;
 }
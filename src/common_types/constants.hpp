@@ -686,6 +686,9 @@ inline constexpr uint32_t stripchart = 23;
 inline constexpr uint32_t triangle_strip = 24;
 inline constexpr uint32_t border_repeat = 25;
 inline constexpr uint32_t corner_repeat = 26;
+inline constexpr uint32_t atlas_sprite = 27;
+inline constexpr uint32_t glyph = 28;
+inline constexpr uint32_t sdf_glyph = 29;
 } // namespace parameters
 }
 
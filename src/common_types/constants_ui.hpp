@@ -26,6 +26,18 @@ enum class alignment : uint8_t {
 
 namespace ui{
 
+// parts of the game / ui state that elements read in on_update
+// producers mark topics dirty and the update pass only visits subtrees that read one of them
+using update_mask = uint64_t;
+namespace update_topic {
+inline constexpr update_mask game_tick = 0x01;   // anything advanced by the game tick
+inline constexpr update_mask commands = 0x02;    // anything changed by an executed command
+inline constexpr update_mask scene = 0x04;       // the active scene
+inline constexpr update_mask selection = 0x08;   // selection made on the map
+inline constexpr update_mask ui_settings = 0x10; // scale, locale and fonts
+inline constexpr update_mask all = ~update_mask(0);
+}
+
 enum class mouse_probe_type {
 	click, tooltip, scroll
 };
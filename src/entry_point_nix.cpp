@@ -4,6 +4,12 @@ static sys::state game_state;
 
 int main(int argc, char* argv[]) {
 	add_root(game_state.common_fs, NATIVE("."));
+	// packed assets, when present, are searched before the loose files
+	add_archive_root(game_state.common_fs, NATIVE("assets.pak"));
+#ifndef NDEBUG
+	// assets are edited while debug builds run, keep the cached directory listings current
+	watch_for_changes(game_state.common_fs);
+#endif
 
 
 	//No args provided.
@@ -20,6 +26,7 @@ int main(int argc, char* argv[]) {
 
 		window::create_window(game_state, window::creation_parameters{ 1024, 780, window::window_state::maximized, game_state.user_settings.prefer_fullscreen });
 		game_state.quit_signaled.store(true, std::memory_order_release);
+		game_state.wake_game_loop();
 
 		update_thread.join();
 
@@ -31,6 +31,8 @@ int WINAPI wWinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPWSTR
 		// do everything here: create a window, read messages
 
 		add_root(game_state.common_fs, NATIVE("."));
+		// packed assets, when present, are searched before the loose files
+		add_archive_root(game_state.common_fs, NATIVE("assets.pak"));
 
 		int num_params = 0;
 		auto parsed_cmd = CommandLineToArgvW(GetCommandLineW(), &num_params);
@@ -59,6 +61,7 @@ int WINAPI wWinMain(HINSTANCE /*hInstance*/, HINSTANCE /*hPrevInstance*/, LPWSTR
 		// entire game runs during this line
 		window::create_window(game_state, window::creation_parameters{ 1024, 780, window::window_state::maximized, game_state.user_settings.prefer_fullscreen });
 		game_state.quit_signaled.store(true, std::memory_order_release);
+		game_state.wake_game_loop();
 
 		update_thread.join();
 
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "simple_fs.hpp"
+#include "asset_archive_format.hpp"
+#include "zstd.h"
+
+namespace simple_fs {
+
+inline constexpr native_char archive_extension[] = NATIVE(".pak"); // roots ending in this are mounted as archives by restore_state
+
+// a mounted archive: the index is read in place from a single mapping of the whole file
+class asset_archive {
+	file mapping;
+	archive_format::entry const* entries = nullptr;
+	char const* paths = nullptr;
+	uint32_t count = 0;
+
+public:
+	explicit asset_archive(file&& f) : mapping(std::move(f)) {
+		auto contents = view_contents(mapping);
+		if(contents.file_size < sizeof(archive_format::header))
+			return;
+		archive_format::header head;
+		std::memcpy(&head, contents.data, sizeof(head));
+		if(head.magic != archive_format::magic || head.version != archive_format::version)
+			return;
+		if(sizeof(head) + uint64_t(head.entry_count) * sizeof(archive_format::entry) + head.path_bytes > contents.file_size)
+			return;
+		entries = reinterpret_cast<archive_format::entry const*>(contents.data + sizeof(head));
+		paths = contents.data + sizeof(head) + sizeof(archive_format::entry) * head.entry_count;
+		for(uint32_t i = 0; i < head.entry_count; ++i) {
+			if(uint64_t(entries[i].path_offset) + entries[i].path_size > head.path_bytes || entries[i].data_offset + entries[i].stored_size > contents.file_size)
+				return;
+		}
+		count = head.entry_count;
+	}
+
+	bool valid() const {
+		return entries != nullptr && count != 0;
+	}
+	uint32_t entry_count() const {
+		return count;
+	}
+	archive_format::entry const& entry(uint32_t i) const {
+		return entries[i];
+	}
+	std::string_view path(uint32_t i) const {
+		return std::string_view(paths + entries[i].path_offset, entries[i].path_size);
+	}
+	// index of the first entry whose path is not less than key
+	uint32_t lower_bound(std::string_view key) const {
+		uint32_t first = 0;
+		uint32_t length = count;
+		while(length > 0) {
+			auto half = length / 2;
+			if(path(first + half) < key) {
+				first += half + 1;
+				length -= half + 1;
+			} else {
+				length = half;
+			}
+		}
+		return first;
+	}
+	std::optional<uint32_t> find(std::string_view key) const {
+		auto i = lower_bound(key);
+		if(i < count && path(i) == key)
+			return i;
+		return std::nullopt;
+	}
+	char const* stored_data(uint32_t i) const {
+		return view_contents(mapping).data + entries[i].data_offset;
+	}
+	bool verify(uint32_t i) const; // rehashes the contents against the stored hash
+};
+
+// archive paths for a directory relative to a root: "" for the root itself, otherwise "a/b/"
+inline std::string archive_directory_key(native_string_view relative_directory) {
+	auto key = native_to_utf8(relative_directory);
+	std::replace(key.begin(), key.end(), '\\', '/');
+	auto start = key.find_first_not_of('/');
+	if(start == std::string::npos)
+		return std::string();
+	key.erase(0, start);
+	if(key.back() != '/')
+		key += '/';
+	return key;
+}
+inline std::string archive_key(native_string_view relative_directory, native_string_view file_name) {
+	return archive_directory_key(relative_directory) + native_to_utf8(file_name);
+}
+
+// calls fn(name, entry) for every file directly inside the directory; entries below a directory are contiguous in the sorted index
+template<typename F>
+void for_each_archived_file(asset_archive const& archive, std::string_view directory_key, F&& fn) {
+	for(auto i = archive.lower_bound(directory_key); i < archive.entry_count(); ++i) {
+		auto p = archive.path(i);
+		if(!p.starts_with(directory_key))
+			break;
+		auto name = p.substr(directory_key.size());
+		if(name.find('/') == std::string_view::npos)
+			fn(name, i);
+	}
+}
+// calls fn(name) once for every directory directly inside the directory
+template<typename F>
+void for_each_archived_directory(asset_archive const& archive, std::string_view directory_key, F&& fn) {
+	std::string_view last;
+	for(auto i = archive.lower_bound(directory_key); i < archive.entry_count(); ++i) {
+		auto p = archive.path(i);
+		if(!p.starts_with(directory_key))
+			break;
+		auto rest = p.substr(directory_key.size());
+		auto slash = rest.find('/');
+		if(slash != std::string_view::npos && rest.substr(0, slash) != last) {
+			last = rest.substr(0, slash);
+			fn(last);
+		}
+	}
+}
+
+// points into the mapping unless the entry is compressed; the file keeps the archive alive
+inline std::optional<file> open_archived_file(std::shared_ptr<asset_archive const> const& archive, uint32_t i, native_string const& full_path) {
+	auto& e = archive->entry(i);
+	file_contents contents;
+	contents.file_size = e.size;
+	std::unique_ptr<char[]> decompressed;
+	if((e.flags & archive_format::flag_zstd) != 0) {
+		decompressed = std::make_unique<char[]>(e.size);
+		auto written = ZSTD_decompress(decompressed.get(), e.size, archive->stored_data(i), e.stored_size);
+		if(ZSTD_isError(written) || written != e.size)
+			return std::optional<file>{};
+		contents.data = decompressed.get();
+	} else {
+		contents.data = archive->stored_data(i);
+	}
+	return std::optional<file>(file(contents, std::move(decompressed), archive, full_path));
+}
+
+inline bool asset_archive::verify(uint32_t i) const {
+	auto& e = entries[i];
+	if((e.flags & archive_format::flag_zstd) == 0)
+		return archive_content_hash(stored_data(i), e.size) == e.content_hash;
+	auto decompressed = std::make_unique<char[]>(e.size);
+	auto written = ZSTD_decompress(decompressed.get(), e.size, stored_data(i), e.stored_size);
+	return !ZSTD_isError(written) && written == e.size && archive_content_hash(decompressed.get(), e.size) == e.content_hash;
+}
+
+} // namespace simple_fs
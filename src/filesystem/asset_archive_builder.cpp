@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cstring>
+#include "asset_archive_format.hpp"
+#include "zstd.h"
+
+namespace simple_fs {
+
+std::vector<char> build_archive(std::vector<archive_input>& inputs, int32_t compression_level) {
+	std::stable_sort(inputs.begin(), inputs.end(), [](archive_input const& a, archive_input const& b) { return a.path < b.path; });
+	// keep the last of each run of equal paths
+	std::vector<archive_input*> unique_inputs;
+	for(size_t i = 0; i < inputs.size(); ++i) {
+		if(i + 1 < inputs.size() && inputs[i + 1].path == inputs[i].path)
+			continue;
+		unique_inputs.push_back(&inputs[i]);
+	}
+
+	archive_format::header head;
+	head.entry_count = uint32_t(unique_inputs.size());
+	std::vector<archive_format::entry> entries(unique_inputs.size());
+	std::string paths;
+	for(size_t i = 0; i < unique_inputs.size(); ++i) {
+		entries[i].path_offset = uint32_t(paths.size());
+		entries[i].path_size = uint32_t(unique_inputs[i]->path.size());
+		paths += unique_inputs[i]->path;
+	}
+	head.path_bytes = uint32_t(paths.size());
+
+	size_t data_start = sizeof(archive_format::header) + sizeof(archive_format::entry) * entries.size() + paths.size();
+	data_start = (data_start + 7) & ~size_t(7);
+
+	std::vector<char> result(data_start);
+	std::vector<char> compressed;
+	for(size_t i = 0; i < unique_inputs.size(); ++i) {
+		auto& contents = unique_inputs[i]->contents;
+		auto& e = entries[i];
+		e.size = uint32_t(contents.size());
+		e.content_hash = archive_content_hash(contents.data(), contents.size());
+		e.data_offset = result.size();
+
+		bool stored_compressed = false;
+		if(compression_level > 0 && !contents.empty()) {
+			compressed.resize(ZSTD_compressBound(contents.size()));
+			auto written = ZSTD_compress(compressed.data(), compressed.size(), contents.data(), contents.size(), compression_level);
+			if(!ZSTD_isError(written) && written < contents.size()) {
+				result.insert(result.end(), compressed.data(), compressed.data() + written);
+				e.stored_size = uint32_t(written);
+				e.flags |= archive_format::flag_zstd;
+				stored_compressed = true;
+			}
+		}
+		if(!stored_compressed) {
+			result.insert(result.end(), contents.begin(), contents.end());
+			e.stored_size = e.size;
+		}
+		result.resize((result.size() + 7) & ~size_t(7));
+	}
+
+	std::memcpy(result.data(), &head, sizeof(head));
+	std::memcpy(result.data() + sizeof(head), entries.data(), sizeof(archive_format::entry) * entries.size());
+	std::memcpy(result.data() + sizeof(head) + sizeof(archive_format::entry) * entries.size(), paths.data(), paths.size());
+	return result;
+}
+
+} // namespace simple_fs
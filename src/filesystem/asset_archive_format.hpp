@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "blake2.h"
+
+namespace simple_fs {
+
+// a packed archive is one file made of:
+//   header
+//   entry table, sorted by path (plain byte order)
+//   path strings, utf8, '/' separated, relative to the root the archive is mounted as, no leading separator
+//   entry data, each entry either stored as is or as a single zstd frame
+namespace archive_format {
+
+inline constexpr uint32_t magic = 0x4B415042; // "BPAK"
+inline constexpr uint32_t version = 1;
+inline constexpr uint32_t flag_zstd = 0x01;
+
+struct header {
+	uint32_t magic = archive_format::magic;
+	uint32_t version = archive_format::version;
+	uint32_t entry_count = 0;
+	uint32_t path_bytes = 0;
+};
+
+struct entry {
+	uint64_t data_offset = 0; // from the start of the archive
+	uint64_t content_hash = 0; // blake2b of the uncompressed contents
+	uint32_t path_offset = 0; // into the path strings
+	uint32_t path_size = 0;
+	uint32_t stored_size = 0;
+	uint32_t size = 0; // uncompressed
+	uint32_t flags = 0;
+	uint32_t padding = 0;
+};
+
+static_assert(sizeof(header) == 16);
+static_assert(sizeof(entry) == 40);
+
+} // namespace archive_format
+
+struct archive_input {
+	std::string path; // in archive form, see above
+	std::vector<char> contents;
+};
+
+// compression_level 0 stores every entry as is; otherwise an entry is only kept compressed when that saves space
+// the inputs are sorted in place; for duplicate paths the last one wins
+std::vector<char> build_archive(std::vector<archive_input>& inputs, int32_t compression_level);
+
+inline uint64_t archive_content_hash(char const* data, size_t size) {
+	uint64_t result = 0;
+	blake2b(&result, sizeof(result), data, size, nullptr, 0);
+	return result;
+}
+
+} // namespace simple_fs
@@ -35,6 +35,8 @@ void reset(file_system& fs);
 void add_root(file_system& fs, native_string_view root_path);
 // will be added relative to the location that the executable file exists in (but it is stored as an absolute path)
 void add_relative_root(file_system& fs, native_string_view root_path);
+// mounts a packed archive (see asset_archive_format.hpp) as the next root; files in it are found in its index instead of on disk
+bool add_archive_root(file_system& fs, native_string_view archive_path);
 directory get_root(file_system const& fs);
 
 // functions for saving and restoring its state
@@ -50,6 +52,11 @@ std::optional<unopened_file> peek_file(directory const& dir, native_string_view
 void add_ignore_path(file_system& fs, native_string_view replaced_path);
 std::vector<native_string> list_roots(file_system const& fs);
 bool is_ignored_path(file_system const& fs, native_string_view path);
+// directories under the roots are listed once and lookups in them are then answered from memory
+// watching drops a cached listing when its directory changes on disk; returns false where that is not supported
+bool watch_for_changes(file_system& fs);
+// directory reads, stats and failed opens answered from the cache instead
+uint64_t syscalls_avoided(file_system const& fs);
 
 directory open_directory(directory const& dir, native_string_view directory_name);
 native_string get_full_name(directory const& f);
@@ -60,6 +67,12 @@ native_string get_mod_save_dir_name(const simple_fs::file_system& fs);
 // write_file will clear an existing file, if it exists, will create a new file if it does not
 void write_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
 void append_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
+// writes to a temporary name and then renames it over file_name, so readers never see a partially written file
+void replace_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
+// sets the modification time of a file to now, so trim_directory treats it as recently used
+void touch_file(directory const& dir, native_string_view file_name);
+// deletes the least recently modified files of an unrooted directory until the rest fit in max_total_size bytes
+void trim_directory(directory const& dir, uint64_t max_total_size);
 
 
 // unopened file functions
@@ -78,6 +91,7 @@ directory get_or_create_gamerules_directory();
 directory get_or_create_oos_directory();
 directory get_or_create_scenario_directory();
 directory get_or_create_settings_directory();
+directory get_or_create_cache_directory();
 directory get_or_create_data_dumps_directory();
 directory get_or_create_root_documents();
 
@@ -1,5 +1,6 @@
 #include <dirent.h>
 #include <fcntl.h>
+#include <sys/inotify.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -8,6 +9,7 @@
 #include <locale>
 
 #include "simple_fs.hpp"
+#include "asset_archive.hpp"
 #include "text.hpp"
 
 namespace simple_fs {
@@ -37,6 +39,8 @@ file::file(file&& other) noexcept {
 #endif
 	content = other.content;
 	absolute_path = std::move(other.absolute_path);
+	decompressed = std::move(other.decompressed);
+	archive = std::move(other.archive);
 
 	other.file_descriptor = -1;
 #if defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE) || defined(_BSD_SOURCE) || defined(_SVID_SOURCE)
@@ -54,6 +58,8 @@ void file::operator=(file&& other) noexcept {
 #endif
 	content = other.content;
 	absolute_path = std::move(other.absolute_path);
+	decompressed = std::move(other.decompressed);
+	archive = std::move(other.archive);
 
 	other.file_descriptor = -1;
 #if defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE) || defined(_BSD_SOURCE) || defined(_SVID_SOURCE)
@@ -106,7 +112,12 @@ file::file(int file_descriptor, native_string const& full_path) : file_descripto
 	}
 }
 
+file::file(file_contents content, std::unique_ptr<char[]> decompressed, std::shared_ptr<asset_archive const> archive, native_string const& full_path)
+		: absolute_path(full_path), content(content), decompressed(std::move(decompressed)), archive(std::move(archive)) { }
+
 std::optional<file> open_file(unopened_file const& f) {
+	if(f.archive)
+		return open_archived_file(f.archive, f.archive_entry, f.absolute_path);
 	std::optional<file> result(file{f.absolute_path});
 	if(!result->content.data) {
 		result = std::optional<file>{};
@@ -114,13 +125,37 @@ std::optional<file> open_file(unopened_file const& f) {
 	return result;
 }
 
+directory_cache::~directory_cache() {
+	if(watch_descriptor != -1)
+		close(watch_descriptor);
+}
+
 void reset(file_system& fs) {
 	fs.ordered_roots.clear();
+	fs.root_archives.clear();
 	fs.ignored_paths.clear();
+	std::unique_lock lock(fs.cache.lock);
+	fs.cache.listings.clear();
+	for(auto const& w : fs.cache.watched)
+		inotify_rm_watch(fs.cache.watch_descriptor, w.first);
+	fs.cache.watched.clear();
 }
 
 void add_root(file_system& fs, native_string_view root_path) {
 	fs.ordered_roots.emplace_back(root_path);
+	fs.root_archives.emplace_back();
+}
+
+bool add_archive_root(file_system& fs, native_string_view archive_path) {
+	auto opened = open_file(unopened_file(archive_path, archive_path));
+	if(!opened)
+		return false;
+	auto archive = std::make_shared<asset_archive const>(std::move(*opened));
+	if(!archive->valid())
+		return false;
+	fs.ordered_roots.emplace_back(archive_path);
+	fs.root_archives.push_back(std::move(archive));
+	return true;
 }
 
 void add_relative_root(file_system& fs, native_string_view root_path) {
@@ -146,6 +181,7 @@ void add_relative_root(file_system& fs, native_string_view root_path) {
 	}
 
 	fs.ordered_roots.push_back(native_string(module_name) + native_string(root_path));
+	fs.root_archives.emplace_back();
 }
 
 directory get_root(file_system const& fs) {
@@ -173,7 +209,9 @@ void restore_state(file_system& fs, native_string_view data) {
 		auto end = break_position;
 		while(position < end) {
 			auto next_semicolon = std::find(position, end, NATIVE(';'));
-			fs.ordered_roots.emplace_back(position, next_semicolon);
+			auto root = native_string_view(position, size_t(next_semicolon - position));
+			if(!root.ends_with(archive_extension) || !add_archive_root(fs, root))
+				add_root(fs, root);
 			position = next_semicolon + 1;
 		}
 	}
@@ -197,6 +235,108 @@ bool contains_non_ascii(native_char const* str) {
 	}
 	return false;
 }
+
+native_string_view extension_of(native_string_view name) {
+	auto dot = name.rfind(NATIVE('.'));
+	if(dot == native_string_view::npos || dot == 0)
+		return native_string_view{};
+	return name.substr(dot);
+}
+
+std::shared_ptr<cached_directory const> read_directory(native_string const& path) {
+	auto result = std::make_shared<cached_directory>();
+	result->read_calls = 1;
+	DIR* d = opendir(path.c_str());
+	if(d) {
+		result->exists = true;
+		result->read_calls += 2;
+		struct dirent* dir_ent = nullptr;
+		while((dir_ent = readdir(d)) != nullptr) {
+			++result->read_calls;
+			if(impl::contains_non_ascii(dir_ent->d_name))
+				result->unresolved.emplace_back(dir_ent->d_name);
+			else if(dir_ent->d_type == DT_REG)
+				result->files.emplace_back(dir_ent->d_name);
+			else if(dir_ent->d_type == DT_DIR && dir_ent->d_name[0] != NATIVE('.'))
+				result->subdirectories.emplace_back(dir_ent->d_name);
+			else if(dir_ent->d_type != DT_DIR)
+				result->unresolved.emplace_back(dir_ent->d_name);
+		}
+		closedir(d);
+	}
+	std::sort(result->files.begin(), result->files.end());
+	std::sort(result->subdirectories.begin(), result->subdirectories.end());
+	std::sort(result->unresolved.begin(), result->unresolved.end());
+	return result;
+}
+
+// drops the listings that inotify reported as changed
+void drain_watch_events(directory_cache& cache) {
+	alignas(inotify_event) char buffer[4096];
+	while(true) {
+		auto length = read(cache.watch_descriptor, buffer, sizeof(buffer));
+		if(length <= 0)
+			return;
+		std::unique_lock lock(cache.lock);
+		for(ssize_t position = 0; position < length;) {
+			auto const* e = reinterpret_cast<inotify_event const*>(buffer + position);
+			position += ssize_t(sizeof(inotify_event) + e->len);
+			if((e->mask & IN_Q_OVERFLOW) != 0) {
+				cache.listings.clear();
+				continue;
+			}
+			auto it = cache.watched.find(e->wd);
+			if(it == cache.watched.end())
+				continue;
+			cache.listings.erase(it->second);
+			// a child that was cached as missing may exist now
+			if(e->len > 0)
+				cache.listings.erase(it->second + NATIVE("/") + e->name);
+			if((e->mask & IN_IGNORED) != 0)
+				cache.watched.erase(it);
+		}
+	}
+}
+
+std::shared_ptr<cached_directory const> cached_listing(directory_cache& cache, native_string const& path, bool& from_cache) {
+	if(cache.watch_descriptor != -1)
+		drain_watch_events(cache);
+	{
+		std::shared_lock lock(cache.lock);
+		if(auto it = cache.listings.find(path); it != cache.listings.end()) {
+			from_cache = true;
+			return it->second;
+		}
+	}
+	from_cache = false;
+	auto listing = read_directory(path);
+	std::unique_lock lock(cache.lock);
+	auto [it, inserted] = cache.listings.try_emplace(path, listing);
+	if(inserted && listing->exists && cache.watch_descriptor != -1) {
+		int w = inotify_add_watch(cache.watch_descriptor, path.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+		if(w != -1)
+			cache.watched.insert_or_assign(w, path);
+	}
+	return it->second;
+}
+
+// looks a file name, which may contain a relative path, up in the cached listing of its directory
+// returns false when the listing can not tell, found is set otherwise
+// a hit only counts as an avoided call for callers that would not touch the file on disk anyway
+bool cached_lookup(directory_cache& cache, native_string const& dir_path, native_string_view file_name, bool hit_avoids_call, bool& found) {
+	auto separator = file_name.rfind(NATIVE('/'));
+	auto name = separator == native_string_view::npos ? file_name : file_name.substr(separator + 1);
+	bool from_cache = false;
+	auto listing = separator == native_string_view::npos
+		? cached_listing(cache, dir_path, from_cache)
+		: cached_listing(cache, dir_path + NATIVE('/') + native_string(file_name.substr(0, separator)), from_cache);
+	if(std::binary_search(listing->unresolved.begin(), listing->unresolved.end(), name))
+		return false;
+	found = std::binary_search(listing->files.begin(), listing->files.end(), name);
+	if(from_cache && (!found || hit_avoids_call))
+		cache.syscalls_avoided.fetch_add(1, std::memory_order::relaxed);
+	return true;
+}
 } // namespace impl
 
 std::vector<unopened_file> list_files(directory const& dir, native_char const* extension) {
@@ -207,35 +347,34 @@ std::vector<unopened_file> list_files(directory const& dir, native_char const* e
 			if(simple_fs::is_ignored_path(*dir.parent_system, appended_path + NATIVE("/"))) {
 				continue;
 			}
-
-			DIR* d = opendir(appended_path.c_str());
-			if(d) {
-				struct dirent* dir_ent = nullptr;
-				while((dir_ent = readdir(d)) != nullptr) {
-					// Check if it's a file. Not POSIX standard but included in Linux
-					if(dir_ent->d_type != DT_REG)
-						continue;
-
-					// Check if the file is of the right extension
-					if(extension && extension[0] != 0) {
-						char* dot = strrchr(dir_ent->d_name, '.');
-						if(!dot || dot == dir_ent->d_name)
-							continue;
-						if(strcmp(dot, extension))
-							continue;
-					}
-
-					if(impl::contains_non_ascii(dir_ent->d_name))
-						continue;
-
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				for_each_archived_file(*archive, archive_directory_key(dir.relative_path), [&](std::string_view name, uint32_t entry) {
+					auto native_name = utf8_to_native(name);
+					if(extension && extension[0] != 0 && (native_name.size() <= strlen(extension) || !native_string_view(native_name).ends_with(extension)))
+						return;
 					auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
-							[n = dir_ent->d_name](auto const& f) { return f.file_name.compare(n) == 0; });
+							[&](auto const& f) { return f.file_name == native_name; });
 					if(search_result == accumulated_results.end()) {
-						accumulated_results.emplace_back(
-								dir.parent_system->ordered_roots[i] + dir.relative_path + NATIVE("/") + dir_ent->d_name, dir_ent->d_name);
+						accumulated_results.emplace_back(appended_path + NATIVE("/") + native_name, native_name, archive, entry);
 					}
+				});
+				continue;
+			}
+
+			bool from_cache = false;
+			auto listing = impl::cached_listing(dir.parent_system->cache, appended_path, from_cache);
+			if(from_cache)
+				dir.parent_system->cache.syscalls_avoided.fetch_add(listing->read_calls, std::memory_order::relaxed);
+			for(auto const& name : listing->files) {
+				// Check if the file is of the right extension
+				if(extension && extension[0] != 0 && impl::extension_of(name) != extension)
+					continue;
+
+				auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
+						[&name](auto const& f) { return f.file_name == name; });
+				if(search_result == accumulated_results.end()) {
+					accumulated_results.emplace_back(appended_path + NATIVE("/") + name, name);
 				}
-				closedir(d);
 			}
 		}
 	} else {
@@ -280,27 +419,28 @@ std::vector<directory> list_subdirectories(directory const& dir) {
 			if(simple_fs::is_ignored_path(*dir.parent_system, appended_path + NATIVE("/"))) {
 				continue;
 			}
-			DIR* d = opendir(appended_path.c_str());
-			if(d) {
-				struct dirent* dir_ent = nullptr;
-				while((dir_ent = readdir(d)) != nullptr) {
-					// Check if it's a directory. Not POSIX standard but included in Linux
-					if(dir_ent->d_type != DT_DIR)
-						continue;
-
-					if(impl::contains_non_ascii(dir_ent->d_name))
-						continue;
-
-					native_string const rel_name = dir.relative_path + NATIVE("/") + dir_ent->d_name;
-					if(dir_ent->d_name[0] != NATIVE('.')) {
-						auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
-								[&rel_name](auto const& s) { return s.relative_path.compare(rel_name) == 0; });
-						if(search_result == accumulated_results.end()) {
-							accumulated_results.emplace_back(dir.parent_system, rel_name);
-						}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				for_each_archived_directory(*archive, archive_directory_key(dir.relative_path), [&](std::string_view name) {
+					native_string const rel_name = dir.relative_path + NATIVE("/") + utf8_to_native(name);
+					auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
+							[&rel_name](auto const& s) { return s.relative_path.compare(rel_name) == 0; });
+					if(search_result == accumulated_results.end()) {
+						accumulated_results.emplace_back(dir.parent_system, rel_name);
 					}
+				});
+				continue;
+			}
+			bool from_cache = false;
+			auto listing = impl::cached_listing(dir.parent_system->cache, appended_path, from_cache);
+			if(from_cache)
+				dir.parent_system->cache.syscalls_avoided.fetch_add(listing->read_calls, std::memory_order::relaxed);
+			for(auto const& name : listing->subdirectories) {
+				native_string const rel_name = dir.relative_path + NATIVE("/") + name;
+				auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
+						[&rel_name](auto const& s) { return s.relative_path.compare(rel_name) == 0; });
+				if(search_result == accumulated_results.end()) {
+					accumulated_results.emplace_back(dir.parent_system, rel_name);
 				}
-				closedir(d);
 			}
 		}
 	} else {
@@ -360,6 +500,14 @@ std::optional<file> open_file(directory const& dir, native_string_view file_name
 			if(simple_fs::is_ignored_path(*dir.parent_system, full_path)) {
 				continue;
 			}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				if(auto entry = archive->find(archive_key(dir.relative_path, file_name)))
+					return open_archived_file(archive, *entry, full_path);
+				continue;
+			}
+			if(bool found = false; impl::cached_lookup(dir.parent_system->cache, dir_path, file_name, false, found) && !found) {
+				continue;
+			}
 			int file_descriptor = open(full_path.c_str(), O_RDONLY | O_NONBLOCK);
 			if(file_descriptor != -1) {
 				return std::optional<file>(file(file_descriptor, full_path));
@@ -384,6 +532,14 @@ std::optional<file> open_file(directory const& dir, std::vector<native_string_vi
 				if(simple_fs::is_ignored_path(*dir.parent_system, full_path)) {
 					continue;
 				}
+				if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+					if(auto entry = archive->find(archive_key(dir.relative_path, file_name)))
+						return open_archived_file(archive, *entry, full_path);
+					continue;
+				}
+				if(bool found = false; impl::cached_lookup(dir.parent_system->cache, dir_path, file_name, false, found) && !found) {
+					continue;
+				}
 				int file_descriptor = open(full_path.c_str(), O_RDONLY | O_NONBLOCK);
 				if(file_descriptor != -1) {
 					return std::optional<file>(file(file_descriptor, full_path));
@@ -405,10 +561,21 @@ std::optional<file> open_file(directory const& dir, std::vector<native_string_vi
 std::optional<unopened_file> peek_file(directory const& dir, native_string_view file_name) {
 	if(dir.parent_system) {
 		for(size_t i = dir.parent_system->ordered_roots.size(); i-- > 0;) {
-			native_string full_path = dir.parent_system->ordered_roots[i] + dir.relative_path + NATIVE('/') + native_string(file_name);
+			native_string dir_path = dir.parent_system->ordered_roots[i] + dir.relative_path;
+			native_string full_path = dir_path + NATIVE('/') + native_string(file_name);
 			if(simple_fs::is_ignored_path(*dir.parent_system, full_path)) {
 				continue;
 			}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				if(auto entry = archive->find(archive_key(dir.relative_path, file_name)))
+					return std::optional<unopened_file>(unopened_file(full_path, file_name, archive, *entry));
+				continue;
+			}
+			if(bool found = false; impl::cached_lookup(dir.parent_system->cache, dir_path, file_name, true, found)) {
+				if(found)
+					return std::optional<unopened_file>(unopened_file(full_path, file_name));
+				continue;
+			}
 			struct stat stat_buf;
 			int result = stat(full_path.c_str(), &stat_buf);
 			if(result != -1 && S_ISREG(stat_buf.st_mode)) {
@@ -434,6 +601,22 @@ std::vector<native_string> list_roots(file_system const& fs) {
 	return fs.ordered_roots;
 }
 
+bool watch_for_changes(file_system& fs) {
+	std::unique_lock lock(fs.cache.lock);
+	if(fs.cache.watch_descriptor != -1)
+		return true;
+	fs.cache.watch_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(fs.cache.watch_descriptor == -1)
+		return false;
+	// listings read before this point are not watched
+	fs.cache.listings.clear();
+	return true;
+}
+
+uint64_t syscalls_avoided(file_system const& fs) {
+	return fs.cache.syscalls_avoided.load(std::memory_order::relaxed);
+}
+
 bool is_ignored_path(file_system const& fs, native_string_view path) {
 	for(auto const& replace_path : fs.ignored_paths) {
 		if(path.starts_with(replace_path))
@@ -509,6 +692,61 @@ void append_file(directory const& dir, native_string_view file_name, char const*
 	}
 }
 
+void replace_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size) {
+	if(dir.parent_system)
+		std::abort();
+
+	static std::atomic<uint32_t> temporary_count = 0;
+	native_string temporary_name = native_string(file_name) + NATIVE('.') + std::to_string(getpid()) + NATIVE('.')
+		+ std::to_string(temporary_count.fetch_add(1, std::memory_order::relaxed)) + NATIVE(".tmp");
+	write_file(dir, temporary_name, file_data, file_size);
+
+	native_string temporary_path = dir.relative_path + NATIVE('/') + temporary_name;
+	native_string full_path = dir.relative_path + NATIVE('/') + native_string(file_name);
+	if(rename(temporary_path.c_str(), full_path.c_str()) != 0)
+		unlink(temporary_path.c_str());
+}
+
+void touch_file(directory const& dir, native_string_view file_name) {
+	if(dir.parent_system)
+		std::abort();
+
+	native_string full_path = dir.relative_path + NATIVE('/') + native_string(file_name);
+	utimensat(AT_FDCWD, full_path.c_str(), nullptr, 0);
+}
+
+void trim_directory(directory const& dir, uint64_t max_total_size) {
+	if(dir.parent_system)
+		std::abort();
+	if(dir.relative_path.empty()) // the directory could not be created; never list the working directory or drive root instead
+		return;
+
+	struct entry {
+		native_string path;
+		int64_t modified = 0;
+		uint64_t size = 0;
+	};
+	std::vector<entry> entries;
+	DIR* d = opendir(dir.relative_path.c_str());
+	if(!d)
+		return;
+	while(auto dir_ent = readdir(d)) {
+		native_string path = dir.relative_path + NATIVE('/') + dir_ent->d_name;
+		struct stat stat_buf;
+		if(stat(path.c_str(), &stat_buf) == 0 && S_ISREG(stat_buf.st_mode))
+			entries.push_back(entry{ std::move(path), int64_t(stat_buf.st_mtime), uint64_t(stat_buf.st_size) });
+	}
+	closedir(d);
+
+	std::sort(entries.begin(), entries.end(), [](entry const& a, entry const& b) { return a.modified > b.modified; });
+	uint64_t total_size = 0;
+	for(auto& e : entries) {
+		total_size += e.size;
+		if(total_size > max_total_size)
+			unlink(e.path.c_str());
+	}
+}
+
 file_contents view_contents(file const& f) {
 	return f.content;
 }
@@ -536,6 +774,13 @@ directory get_or_create_settings_directory() {
 	return directory(nullptr, path);
 }
 
+directory get_or_create_cache_directory() {
+	native_string path = native_string(getenv("HOME")) + "/.local/share/" + NATIVE_PROGRAM_NAME + "/cache/";
+	make_directories(path);
+
+	return directory(nullptr, path);
+}
+
 directory get_or_create_save_game_directory(native_string mod_dir) {
 	native_string path = native_string(getenv("HOME")) + "/.local/share/" + NATIVE_PROGRAM_NAME +  "/saves/";
 	if(mod_dir.length() > 0) {
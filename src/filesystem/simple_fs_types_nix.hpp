@@ -1,15 +1,45 @@
 #pragma once
 #include "native_types_nix.hpp"
 #include "unordered_dense.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 
 // this file should contain the four class definitions of the types
 // required for simple fs: file_system, directory, unopened_file, and file
 // all in the namespace simple_fs, all classes
 
 namespace simple_fs {
+class asset_archive;
+
+// what one directory under a root contained when it was read
+struct cached_directory {
+	std::vector<native_string> files; // regular files with ascii names, sorted
+	std::vector<native_string> subdirectories; // ascii names not starting with '.', sorted
+	std::vector<native_string> unresolved; // links, entries of unknown type and non ascii names: still looked up on disk, sorted
+	uint32_t read_calls = 0; // opendir, readdir and closedir calls it took to read
+	bool exists = false;
+};
+
+// listings of the directories under the roots, keyed by root + relative path and filled on first use
+struct directory_cache {
+	std::shared_mutex lock;
+	ankerl::unordered_dense::map<native_string, std::shared_ptr<cached_directory const>> listings;
+	ankerl::unordered_dense::map<int, native_string> watched; // inotify watch -> key in listings
+	std::atomic<uint64_t> syscalls_avoided = 0;
+	int watch_descriptor = -1;
+
+	directory_cache() = default;
+	directory_cache(directory_cache const&) = delete;
+	~directory_cache();
+};
+
 class file_system {
 	std::vector<native_string> ordered_roots;
+	std::vector<std::shared_ptr<asset_archive const>> root_archives; // parallel to ordered_roots, null where the root is a directory
 	std::vector<native_string> ignored_paths;
+	mutable directory_cache cache;
 
 	void operator=(file_system const& other) = delete;
 	void operator=(file_system&& other) = delete;
@@ -21,6 +51,7 @@ public:
 	friend void add_root(file_system& fs, native_string_view root_path);
 	// will be added relative to the location that the executable file exists in
 	friend void add_relative_root(file_system& fs, native_string_view root_path);
+	friend bool add_archive_root(file_system& fs, native_string_view archive_path);
 	friend directory get_root(file_system const& fs);
 	friend native_string extract_state(file_system const& fs);
 	friend void restore_state(file_system& fs, native_string_view data);
@@ -30,6 +61,8 @@ public:
 	friend void add_ignore_path(file_system& fs, native_string_view replaced_path);
 	friend std::vector<native_string> list_roots(file_system const& fs);
 	friend bool is_ignored_path(file_system const& fs, native_string_view path);
+	friend bool watch_for_changes(file_system& fs);
+	friend uint64_t syscalls_avoided(file_system const& fs);
 };
 
 class directory {
@@ -49,6 +82,9 @@ public:
 	friend std::optional<unopened_file> peek_file(directory const& dir, native_string_view file_name);
 	friend void write_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
 	friend void append_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
+	friend void replace_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
+	friend void touch_file(directory const& dir, native_string_view file_name);
+	friend void trim_directory(directory const& dir, uint64_t max_total_size);
 	friend directory open_directory(directory const& dir, native_string_view directory_name);
 	friend native_string get_full_name(directory const& dir);
 	friend native_string get_dir_name(directory const& dir);
@@ -57,10 +93,14 @@ public:
 class unopened_file {
 	native_string absolute_path;
 	native_string file_name;
+	std::shared_ptr<asset_archive const> archive; // set when the file is an entry of a mounted archive
+	uint32_t archive_entry = 0;
 
 public:
 	unopened_file(native_string_view absolute_path, native_string_view file_name)
 			: absolute_path(absolute_path), file_name(file_name) { }
+	unopened_file(native_string_view absolute_path, native_string_view file_name, std::shared_ptr<asset_archive const> archive, uint32_t archive_entry)
+			: absolute_path(absolute_path), file_name(file_name), archive(std::move(archive)), archive_entry(archive_entry) { }
 
 	friend std::optional<file> open_file(unopened_file const& f);
 	friend std::optional<file> open_file(directory const& dir, std::vector<native_string_view> file_names);
@@ -79,9 +119,12 @@ class file {
 
 	native_string absolute_path;
 	file_contents content;
+	std::unique_ptr<char[]> decompressed; // contents of a compressed archive entry
+	std::shared_ptr<asset_archive const> archive; // keeps the mapping that content points into alive
 
 	file(native_string const& full_path);
 	file(int file_descriptor, native_string const& full_path);
+	file(file_contents content, std::unique_ptr<char[]> decompressed, std::shared_ptr<asset_archive const> archive, native_string const& full_path);
 
 public:
 	file(file const& other) = delete;
@@ -94,6 +137,7 @@ public:
 	friend std::optional<file> open_file(directory const& dir, std::vector<native_string_view> file_names);
 	friend std::optional<file> open_file(unopened_file const& f);
 	friend class std::optional<file>;
+	friend std::optional<file> open_archived_file(std::shared_ptr<asset_archive const> const& archive, uint32_t i, native_string const& full_path);
 	friend file_contents view_contents(file const& f);
 	friend native_string get_full_name(file const& f);
 };
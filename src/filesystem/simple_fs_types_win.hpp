@@ -1,6 +1,7 @@
 #pragma once
 #include "native_types_win.hpp"
 #include "unordered_dense.h"
+#include <memory>
 
 #ifndef UNICODE
 #define UNICODE
@@ -15,8 +16,11 @@
 // all in the namespace simple_fs, all classes
 
 namespace simple_fs {
+class asset_archive;
+
 class file_system {
 	std::vector<native_string> ordered_roots;
+	std::vector<std::shared_ptr<asset_archive const>> root_archives; // parallel to ordered_roots, null where the root is a directory
 	std::vector<native_string> ignored_paths;
 
 	void operator=(file_system const& other) = delete;
@@ -30,6 +34,7 @@ public:
 	friend void add_root(file_system& fs, native_string_view root_path);
 	// will be added relative to the location that the executable file exists in
 	friend void add_relative_root(file_system& fs, native_string_view root_path);
+	friend bool add_archive_root(file_system& fs, native_string_view archive_path);
 	friend directory get_root(file_system const& fs);
 	friend native_string extract_state(file_system const& fs);
 	friend void restore_state(file_system& fs, native_string_view data);
@@ -59,6 +64,9 @@ public:
 	friend std::optional<unopened_file> peek_file(directory const& dir, native_string_view file_name);
 	friend void write_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
 	friend void append_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
+	friend void replace_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size);
+	friend void touch_file(directory const& dir, native_string_view file_name);
+	friend void trim_directory(directory const& dir, uint64_t max_total_size);
 	friend directory open_directory(directory const& dir, native_string_view directory_name);
 	friend native_string get_full_name(directory const& f);
 	friend native_string get_dir_name(directory const& dir);
@@ -67,10 +75,14 @@ public:
 class unopened_file {
 	native_string file_name;
 	native_string absolute_path;
+	std::shared_ptr<asset_archive const> archive; // set when the file is an entry of a mounted archive
+	uint32_t archive_entry = 0;
 
 public:
 	unopened_file(native_string_view absolute_path, native_string_view file_name)
 			: file_name(file_name), absolute_path(absolute_path) { }
+	unopened_file(native_string_view absolute_path, native_string_view file_name, std::shared_ptr<asset_archive const> archive, uint32_t archive_entry)
+			: file_name(file_name), absolute_path(absolute_path), archive(std::move(archive)), archive_entry(archive_entry) { }
 
 	friend std::optional<file> open_file(unopened_file const& f);
 	friend std::optional<file> open_file(directory const& dir, std::vector<native_string_view> file_names);
@@ -86,9 +98,12 @@ public:
 
 	native_string absolute_path;
 	file_contents content;
+	std::unique_ptr<char[]> decompressed; // contents of a compressed archive entry
+	std::shared_ptr<asset_archive const> archive; // keeps the mapping that content points into alive
 
 	file(native_string const& full_path);
 	file(HANDLE file_handle, native_string const& full_path);
+	file(file_contents content, std::unique_ptr<char[]> decompressed, std::shared_ptr<asset_archive const> archive, native_string const& full_path);
 
 	file(file const& other) = delete;
 	file(file&& other) noexcept;
@@ -1,5 +1,6 @@
 #include "simple_fs.hpp"
 #include "simple_fs_types_win.hpp"
+#include "asset_archive.hpp"
 #include "text.hpp"
 
 #ifndef UNICODE
@@ -11,6 +12,7 @@
 #include "Windows.h"
 #include "Memoryapi.h"
 #include "Shlobj.h"
+#include <atomic>
 #include <cstdlib>
 
 #pragma comment(lib, "Shlwapi.lib")
@@ -33,6 +35,8 @@ file::file(file&& other) noexcept : absolute_path(std::move(other.absolute_path)
 	other.mapping_handle = nullptr;
 	other.file_handle = INVALID_HANDLE_VALUE;
 	content = other.content;
+	decompressed = std::move(other.decompressed);
+	archive = std::move(other.archive);
 }
 void file::operator=(file&& other) noexcept {
 	mapping_handle = other.mapping_handle;
@@ -41,6 +45,8 @@ void file::operator=(file&& other) noexcept {
 	other.file_handle = INVALID_HANDLE_VALUE;
 	content = other.content;
 	absolute_path = std::move(other.absolute_path);
+	decompressed = std::move(other.decompressed);
+	archive = std::move(other.archive);
 }
 
 file::file(native_string const& full_path) {
@@ -72,7 +78,12 @@ file::file(HANDLE file_handle, native_string const& full_path) : file_handle(fil
 	}
 }
 
+file::file(file_contents content, std::unique_ptr<char[]> decompressed, std::shared_ptr<asset_archive const> archive, native_string const& full_path)
+		: absolute_path(full_path), content(content), decompressed(std::move(decompressed)), archive(std::move(archive)) { }
+
 std::optional<file> open_file(unopened_file const& f) {
+	if(f.archive)
+		return open_archived_file(f.archive, f.archive_entry, f.absolute_path);
 	std::optional<file> result(file{f.absolute_path});
 	if(!result->content.data) {
 		result = std::optional<file>{};
@@ -82,11 +93,25 @@ std::optional<file> open_file(unopened_file const& f) {
 
 void reset(file_system& fs) {
 	fs.ordered_roots.clear();
+	fs.root_archives.clear();
 	fs.ignored_paths.clear();
 }
 
 void add_root(file_system& fs, native_string_view root_path) {
 	fs.ordered_roots.emplace_back(root_path);
+	fs.root_archives.emplace_back();
+}
+
+bool add_archive_root(file_system& fs, native_string_view archive_path) {
+	auto opened = open_file(unopened_file(archive_path, archive_path));
+	if(!opened)
+		return false;
+	auto archive = std::make_shared<asset_archive const>(std::move(*opened));
+	if(!archive->valid())
+		return false;
+	fs.ordered_roots.emplace_back(archive_path);
+	fs.root_archives.push_back(std::move(archive));
+	return true;
 }
 
 void add_relative_root(file_system& fs, native_string_view root_path) {
@@ -98,6 +123,7 @@ void add_relative_root(file_system& fs, native_string_view root_path) {
 	}
 
 	fs.ordered_roots.push_back(native_string(module_name) + native_string(root_path));
+	fs.root_archives.emplace_back();
 }
 
 directory get_root(file_system const& fs) {
@@ -125,7 +151,9 @@ void restore_state(file_system& fs, native_string_view data) {
 		auto end = break_position;
 		while(position < end) {
 			auto next_semicolon = std::find(position, end, NATIVE(';'));
-			fs.ordered_roots.emplace_back(position, next_semicolon);
+			auto root = native_string_view(position, size_t(next_semicolon - position));
+			if(!root.ends_with(archive_extension) || !add_archive_root(fs, root))
+				add_root(fs, root);
 			position = next_semicolon + 1;
 		}
 	}
@@ -161,6 +189,19 @@ std::vector<unopened_file> list_files(directory const& dir, native_char const* e
 			if(simple_fs::is_ignored_path(*dir.parent_system, appended_path)) {
 				continue;
 			}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				for_each_archived_file(*archive, archive_directory_key(dir.relative_path), [&](std::string_view name, uint32_t entry) {
+					auto native_name = utf8_to_native(name);
+					if(extension && extension[0] != 0 && (native_name.size() <= wcslen(extension) || !native_string_view(native_name).ends_with(extension)))
+						return;
+					auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
+							[&](auto const& f) { return f.file_name == native_name; });
+					if(search_result == accumulated_results.end()) {
+						accumulated_results.emplace_back(dir_path + NATIVE("\\") + native_name, native_name, archive, entry);
+					}
+				});
+				continue;
+			}
 
 			WIN32_FIND_DATAW find_result;
 			auto find_handle = FindFirstFileExW(appended_path.c_str(), FindExInfoBasic, &find_result, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
@@ -209,6 +250,17 @@ std::vector<directory> list_subdirectories(directory const& dir) {
 			if(simple_fs::is_ignored_path(*dir.parent_system, appended_path)) {
 				continue;
 			}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				for_each_archived_directory(*archive, archive_directory_key(dir.relative_path), [&](std::string_view name) {
+					native_string const rel_name = dir.relative_path + NATIVE("\\") + utf8_to_native(name);
+					auto search_result = std::find_if(accumulated_results.begin(), accumulated_results.end(),
+							[&rel_name](auto const& s) { return s.relative_path.compare(rel_name) == 0; });
+					if(search_result == accumulated_results.end()) {
+						accumulated_results.emplace_back(dir.parent_system, rel_name);
+					}
+				});
+				continue;
+			}
 			WIN32_FIND_DATAW find_result;
 			auto find_handle = FindFirstFileExW(appended_path.c_str(), FindExInfoBasic, &find_result, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
 			if(find_handle != INVALID_HANDLE_VALUE) {
@@ -299,6 +351,11 @@ std::optional<file> open_file(directory const& dir, native_string_view file_name
 			if(simple_fs::is_ignored_path(*dir.parent_system, full_path)) {
 				continue;
 			}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				if(auto entry = archive->find(archive_key(dir.relative_path, file_name)))
+					return open_archived_file(archive, *entry, full_path);
+				continue;
+			}
 			HANDLE file_handle = CreateFileW(full_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
 					FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
 			if(file_handle != INVALID_HANDLE_VALUE) {
@@ -325,6 +382,11 @@ std::optional<file> open_file(directory const& dir, std::vector<native_string_vi
 				if(simple_fs::is_ignored_path(*dir.parent_system, full_path)) {
 					continue;
 				}
+				if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+					if(auto entry = archive->find(archive_key(dir.relative_path, file_name)))
+						return open_archived_file(archive, *entry, full_path);
+					continue;
+				}
 				HANDLE file_handle = CreateFileW(full_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
 						FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
 				if(file_handle != INVALID_HANDLE_VALUE) {
@@ -353,6 +415,11 @@ std::optional<unopened_file> peek_file(directory const& dir, native_string_view
 			if(simple_fs::is_ignored_path(*dir.parent_system, full_path)) {
 				continue;
 			}
+			if(auto& archive = dir.parent_system->root_archives[i]; archive) {
+				if(auto entry = archive->find(archive_key(dir.relative_path, file_name)))
+					return std::optional<unopened_file>(unopened_file(full_path, file_name, archive, *entry));
+				continue;
+			}
 			DWORD dwAttrib = GetFileAttributesW(full_path.c_str());
 			if(dwAttrib != INVALID_FILE_ATTRIBUTES && !(dwAttrib & FILE_ATTRIBUTE_DIRECTORY)) {
 				return std::optional<unopened_file>(unopened_file(full_path, file_name));
@@ -376,6 +443,15 @@ std::vector<native_string> list_roots(file_system const& fs) {
 	return fs.ordered_roots;
 }
 
+// listings are not cached on windows, FindFirstFileExW already batches the directory reads
+bool watch_for_changes(file_system& fs) {
+	return false;
+}
+
+uint64_t syscalls_avoided(file_system const& fs) {
+	return 0;
+}
+
 bool is_ignored_path(file_system const& fs, native_string_view path) {
 	for(auto const& replace_path : fs.ignored_paths) {
 		if(path.starts_with(replace_path))
@@ -428,6 +504,72 @@ void append_file(directory const& dir, native_string_view file_name, char const*
 	}
 }
 
+void replace_file(directory const& dir, native_string_view file_name, char const* file_data, uint32_t file_size) {
+	if(dir.parent_system)
+		std::abort();
+
+	static std::atomic<uint32_t> temporary_count = 0;
+	native_string temporary_name = native_string(file_name) + NATIVE('.') + std::to_wstring(GetCurrentProcessId()) + NATIVE('.')
+		+ std::to_wstring(temporary_count.fetch_add(1, std::memory_order::relaxed)) + NATIVE(".tmp");
+	write_file(dir, temporary_name, file_data, file_size);
+
+	native_string temporary_path = dir.relative_path + NATIVE('\\') + temporary_name;
+	native_string full_path = dir.relative_path + NATIVE('\\') + native_string(file_name);
+	// fails while another thread has the old file mapped; the old file is then kept
+	if(!MoveFileExW(temporary_path.c_str(), full_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+		DeleteFileW(temporary_path.c_str());
+}
+
+void touch_file(directory const& dir, native_string_view file_name) {
+	if(dir.parent_system)
+		std::abort();
+
+	native_string full_path = dir.relative_path + NATIVE('\\') + native_string(file_name);
+	HANDLE file_handle = CreateFileW(full_path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file_handle != INVALID_HANDLE_VALUE) {
+		FILETIME now;
+		GetSystemTimeAsFileTime(&now);
+		SetFileTime(file_handle, nullptr, nullptr, &now);
+		CloseHandle(file_handle);
+	}
+}
+
+void trim_directory(directory const& dir, uint64_t max_total_size) {
+	if(dir.parent_system)
+		std::abort();
+	if(dir.relative_path.empty()) // the directory could not be created; never list the working directory or drive root instead
+		return;
+
+	struct entry {
+		native_string path;
+		uint64_t modified = 0;
+		uint64_t size = 0;
+	};
+	std::vector<entry> entries;
+	native_string search_path = dir.relative_path + NATIVE("\\*");
+	WIN32_FIND_DATAW find_result;
+	auto find_handle = FindFirstFileExW(search_path.c_str(), FindExInfoBasic, &find_result, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if(find_handle == INVALID_HANDLE_VALUE)
+		return;
+	do {
+		if(!(find_result.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			entries.push_back(entry{ dir.relative_path + NATIVE("\\") + find_result.cFileName,
+				(uint64_t(find_result.ftLastWriteTime.dwHighDateTime) << 32) | uint64_t(find_result.ftLastWriteTime.dwLowDateTime),
+				(uint64_t(find_result.nFileSizeHigh) << 32) | uint64_t(find_result.nFileSizeLow) });
+		}
+	} while(FindNextFileW(find_handle, &find_result) != 0);
+	FindClose(find_handle);
+
+	std::sort(entries.begin(), entries.end(), [](entry const& a, entry const& b) { return a.modified > b.modified; });
+	uint64_t total_size = 0;
+	for(auto& e : entries) {
+		total_size += e.size;
+		if(total_size > max_total_size)
+			DeleteFileW(e.path.c_str());
+	}
+}
+
 file_contents view_contents(file const& f) {
 	return f.content;
 }
@@ -445,6 +587,21 @@ directory get_or_create_settings_directory() {
 	return directory(nullptr, base_path);
 }
 
+directory get_or_create_cache_directory() {
+	wchar_t* local_path_out = nullptr;
+	native_string base_path;
+	if(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &local_path_out) == S_OK) {
+		base_path = native_string(local_path_out) + NATIVE("\\") + NATIVE_PROGRAM_NAME;
+	}
+	CoTaskMemFree(local_path_out);
+	if(base_path.length() > 0) {
+		CreateDirectoryW(base_path.c_str(), nullptr);
+		base_path += NATIVE("\\cache");
+		CreateDirectoryW(base_path.c_str(), nullptr);
+	}
+	return directory(nullptr, base_path);
+}
+
 directory get_or_create_save_game_directory(native_string mod_dir) {
 	wchar_t* local_path_out = nullptr;
 	native_string base_path;
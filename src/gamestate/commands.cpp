@@ -1,6 +1,7 @@
 #include "commands.hpp"
 #include "system_state.hpp"
 #include "game_scene.hpp"
+#include <thread>
 
 namespace command {
 
@@ -8,15 +9,26 @@ bool is_console_command(command_type t) {
 	return uint8_t(t) == 255;
 }
 
-void add_to_command_queue(sys::state& state, command_data& p) {
-#ifndef NDEBUG
-	assert(command::can_perform_command(state, p));
-#endif
-	bool b = state.incoming_commands.try_push(p);
+command_ring& get_command_queue(sys::state& state) {
+	return state.incoming_commands;
 }
 
+bool payload_size_is_valid(command_type type, uint32_t payload_size) {
+	if(auto it = command_type_handlers.find(type); it != command_type_handlers.end()) {
+		return it->second.min_payload_size <= payload_size && payload_size <= it->second.max_payload_size;
+	}
+	return false;
+}
 
+void wait_for_command_queue(sys::state& state) {
+	// the queue is full: make sure the game loop is draining it and let it run
+	state.wake_game_loop();
+	std::this_thread::yield();
+}
 
+void notify_command_queued(sys::state& state) {
+	state.wake_game_loop();
+}
 
 bool can_perform_command(sys::state& state, command_data& c) {
 	switch(c.header.type) {
@@ -56,7 +68,7 @@ bool execute_command(sys::state& state, command_data& c) {
 
 
 void execute_pending_commands(sys::state& state) {
-	auto* c = state.incoming_commands.front();
+	auto c = state.incoming_commands.front();
 	bool command_executed = false;
 	while(c) {
 		command_executed = true;
@@ -66,7 +78,7 @@ void execute_pending_commands(sys::state& state) {
 	}
 
 	if(command_executed) {
-		state.game_state_updated.store(true, std::memory_order::release);
+		state.mark_ui_dirty(ui::update_topic::commands);
 	}
 }
 
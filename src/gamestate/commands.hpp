@@ -1,4 +1,5 @@
 #pragma once
+#include <cassert>
 #include "data_ids.hpp"
 #include "common_types.hpp"
 #include "constants_dcon.hpp"
@@ -27,6 +28,38 @@ static ankerl::unordered_dense::map<command::command_type, command::command_type
 	//{command_type::change_nat_focus, command_type_data{ sizeof(command::national_focus_data), sizeof(command::national_focus_data) } },
 };
 
+// false if the payload size is outside of what command_type_handlers allows for the type
+bool payload_size_is_valid(command_type type, uint32_t payload_size);
+command_ring& get_command_queue(sys::state& state);
+// waits for room in the queue and wakes the game loop, so must not be called from the game loop itself
+void wait_for_command_queue(sys::state& state);
+void notify_command_queued(sys::state& state);
+
+// fill receives a pointer to payload_size bytes inside the queue and writes the payload there
+template<typename F>
+void add_to_command_queue(sys::state& state, command_type type, uint32_t payload_size, F&& fill) {
+	if(!payload_size_is_valid(type, payload_size)) {
+		assert(false && "Invalid command payload size");
+		return;
+	}
+	auto& queue = get_command_queue(state);
+	if(!queue.fits(payload_size)) {
+		assert(false && "Command payload larger than the queue");
+		return;
+	}
+	while(!queue.try_push(type, payload_size, fill)) {
+		wait_for_command_queue(state);
+	}
+	notify_command_queued(state);
+}
+template<typename data_type>
+void add_to_command_queue(sys::state& state, command_type type, data_type const& payload) {
+	static_assert(std::is_standard_layout<data_type>::value, "Data type is too complex");
+	add_to_command_queue(state, type, uint32_t(sizeof(data_type)), [&](uint8_t* dest) {
+		std::memcpy(dest, &payload, sizeof(data_type));
+	});
+}
+
 // returns true if the command was performed, false if not
 bool execute_command(sys::state& state, command_data& c);
 void execute_pending_commands(sys::state& state);
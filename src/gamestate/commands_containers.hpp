@@ -1,5 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <cstdlib>
 
 namespace command {
 enum class command_type : uint8_t;
@@ -10,83 +16,123 @@ struct cmd_header {
 	command_type type;
 };
 
+// a command as stored in the queue; the payload points into the queue's memory and is valid until the command is popped
 struct command_data {
 	cmd_header header{};
-	std::vector<uint8_t> payload;
-	command_data() {
-	};
-	command_data(command_type _type) {
-		header.type = _type;
-	};
-	// add data to the payload
-	template<typename data_type>
-	friend command_data& operator << (command_data& msg, data_type& data) {
+	std::span<uint8_t> payload;
 
+	// returns a reference to the payload of the desired type, starting from the start of the payload
+	template<typename data_type>
+	data_type& get_payload() {
 		static_assert(std::is_standard_layout<data_type>::value, "Data type is too complex");
-		size_t curr_size = msg.payload.size();
-		msg.payload.resize(msg.payload.size() + sizeof(data_type));
-
-		std::memcpy(msg.payload.data() + curr_size, &data, sizeof(data_type));
-
-		msg.header.payload_size = (uint32_t)msg.payload.size();
-
-		return msg;
+		uint8_t* ptr = payload.data();
+		return reinterpret_cast<data_type&>(*ptr);
 	}
-	// adds data from pointer to the payload
+	// Checks if the payload of the given type has an additional variable payload of size "expected_size" (in bytes). Returns true if that is the case, false otherwise
 	template<typename data_type>
-	void push_ptr(data_type* ptr, size_t size) {
-		size_t curr_size = payload.size();
-		payload.resize(payload.size() + sizeof(data_type) * size);
-
-		std::memcpy(payload.data() + curr_size, ptr, sizeof(data_type) * size);
-
-		header.payload_size = (uint32_t)payload.size();
+	bool check_variable_size_payload(uint32_t expected_size) {
+		return expected_size == (payload.size() - sizeof(data_type));
 	}
+};
 
+// byte ring of variable length records, any number of threads may push while one thread consumes
+// record layout: commit word, cmd_header, payload; all padded to record_alignment
+// producers reserve space by advancing write_position and publish a record by storing its size in the commit word
+// the consumer zeroes records as it pops them, so a zero commit word always means "not written yet"
+class command_ring {
+public:
+	static constexpr uint32_t record_alignment = 16;
+	static constexpr uint32_t payload_offset = 16;
+
+	explicit command_ring(uint32_t capacity_bytes) {
+		capacity = record_alignment;
+		while(capacity < capacity_bytes)
+			capacity <<= 1;
+		buffer = std::make_unique<uint8_t[]>(capacity);
+	}
 
-	// grab data from the payload
-	template<typename data_type>
-	friend command_data& operator >> (command_data& msg, data_type& data) {
-
-		static_assert(std::is_standard_layout<data_type>::value, "Data type is too complex");
-
-		size_t i = msg.payload.size() - sizeof(data_type);
-		std::memcpy(&data, msg.payload.data() + i, sizeof(data_type));
-		msg.payload.resize(i);
-
-		msg.header.payload_size = (uint32_t)msg.payload.size();
-
-		return msg;
-
-
+	static constexpr uint32_t record_size(uint32_t payload_size) {
+		return payload_offset + (payload_size + record_alignment - 1) / record_alignment * record_alignment;
+	}
+	bool fits(uint32_t payload_size) const {
+		return record_size(payload_size) <= capacity;
+	}
 
+	// writes the record in place, fill receives a pointer to payload_size bytes
+	// returns false without writing anything if there is currently no room
+	template<typename F>
+	bool try_push(command_type type, uint32_t payload_size, F&& fill) {
+		uint32_t size = record_size(payload_size);
+		if(size > capacity)
+			std::abort(); // could never fit
+
+		uint64_t position = write_position.load(std::memory_order::relaxed);
+		uint64_t start = 0;
+		uint32_t skipped = 0;
+		do {
+			// records never wrap around the end of the buffer, the tail is skipped instead
+			uint32_t offset = uint32_t(position & (capacity - 1));
+			skipped = capacity - offset < size ? capacity - offset : 0;
+			start = position + skipped;
+			if(start + size - read_position.load(std::memory_order::acquire) > capacity)
+				return false;
+		} while(!write_position.compare_exchange_weak(position, start + size, std::memory_order::acq_rel, std::memory_order::relaxed));
+
+		if(skipped != 0)
+			commit_word(position).store(skipped | skip_flag, std::memory_order::release);
+
+		uint8_t* record = buffer.get() + (start & (capacity - 1));
+		cmd_header header;
+		header.payload_size = payload_size;
+		header.type = type;
+		std::memcpy(record + sizeof(uint32_t), &header, sizeof(cmd_header));
+		fill(record + payload_offset);
+		commit_word(start).store(size, std::memory_order::release);
+		return true;
 	}
-	// Makes a copy of the data and returns it
-	/*template<typename data_type>
-	data_type copy_payload() const {
 
-		static_assert(std::is_standard_layout<data_type>::value, "Data type is too complex");
-		static_assert(sizeof(data_type) <= MAX_PAYLOAD_SIZE, "data type used is larger than MAX_PAYLOAD_SIZE. Did you forget to add it?");
+	// the oldest published command, if any; only call from the consuming thread
+	std::optional<command_data> front() {
+		while(true) {
+			uint64_t position = read_position.load(std::memory_order::relaxed);
+			uint32_t word = commit_word(position).load(std::memory_order::acquire);
+			if(word == 0)
+				return std::nullopt;
+			if((word & skip_flag) != 0) {
+				release(position, word & ~skip_flag);
+				continue;
+			}
+			uint8_t* record = buffer.get() + (position & (capacity - 1));
+			command_data result;
+			std::memcpy(&result.header, record + sizeof(uint32_t), sizeof(cmd_header));
+			result.payload = std::span<uint8_t>(record + payload_offset, result.header.payload_size);
+			return result;
+		}
+	}
+	// removes the command returned by front
+	void pop() {
+		uint64_t position = read_position.load(std::memory_order::relaxed);
+		uint32_t word = commit_word(position).load(std::memory_order::acquire);
+		if(word == 0)
+			return;
+		release(position, word & ~skip_flag);
+	}
+private:
+	static constexpr uint32_t skip_flag = 0x80000000;
 
-		data_type output{ };
-		std::memcpy(&output, payload.data() + (payload.size() - sizeof(data_type)), sizeof(data_type));
-		return output;
-	}*/
-	// returns a reference to the payload of the desired type, starting from the start of the vector
-	template<typename data_type>
-	data_type& get_payload() {
-		static_assert(std::is_standard_layout<data_type>::value, "Data type is too complex");
-		uint8_t* ptr = payload.data();
-		return reinterpret_cast<data_type&>(*ptr);
+	std::atomic_ref<uint32_t> commit_word(uint64_t position) {
+		return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(buffer.get() + (position & (capacity - 1))));
 	}
-	// Checks if the payload of the given type has an additional variable payload of size "expected_size" (in bytes). Returns true if that is the case, false otherwise
-	template<typename data_type>
-	bool check_variable_size_payload(uint32_t expected_size) {
-		return expected_size == (payload.size() - sizeof(data_type));
+	void release(uint64_t position, uint32_t size) {
+		std::memset(buffer.get() + (position & (capacity - 1)), 0, size);
+		read_position.store(position + size, std::memory_order::release);
 	}
 
+	std::unique_ptr<uint8_t[]> buffer;
+	uint32_t capacity = 0;
+	alignas(64) std::atomic<uint64_t> write_position = 0; // end of the space reserved by producers
+	alignas(64) std::atomic<uint64_t> read_position = 0; // start of the oldest unconsumed record
 };
-static_assert(sizeof(command_data) == sizeof(command_data::header) + sizeof(command_data::payload));
 
 }
 
@@ -38,7 +38,7 @@ void switch_scene(sys::state& state, scene_id ui_scene) {
 		break;
 	}
 	
-	state.game_state_updated.store(true, std::memory_order_release);
+	state.mark_ui_dirty(ui::update_topic::scene);
 }
 
 void do_nothing(sys::state& state) { }
@@ -147,7 +147,7 @@ void handle_drag_stop(sys::state& state, int32_t x, int32_t y, sys::key_modifier
 		state.drag_selecting = false;
 		window::change_cursor(state, window::cursor_type::normal);
 
-		state.game_state_updated.store(true, std::memory_order_release);
+		state.mark_ui_dirty(ui::update_topic::selection);
 	} else {
 		// stop dragging and select units
 		state.drag_selecting = false;
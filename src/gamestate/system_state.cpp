@@ -1,6 +1,11 @@
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <functional>
+#include <new>
 #include <thread>
+#include "oneapi/tbb/task_group.h"
+#include "oneapi/tbb/parallel_for.h"
 #include "system_state.hpp"
 #include "opengl_wrapper.hpp"
 #include "window.hpp"
@@ -12,6 +17,24 @@
 #include "alice_ui.hpp"
 #include "parsers.hpp"
 
+#ifndef NDEBUG
+// debug builds count the heap allocations made by each thread, see state::render
+static thread_local uint64_t heap_allocations = 0;
+
+void* operator new(std::size_t size) {
+	++heap_allocations;
+	if(auto p = std::malloc(size != 0 ? size : 1))
+		return p;
+	throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+#endif
+
 namespace sys {
 
 
@@ -20,15 +43,18 @@ namespace sys {
 //
 
 void state::on_rbutton_down(int32_t x, int32_t y, key_modifiers mod) {
+	ui_state.invalidate_mouse_probe();
 	game_scene::on_rbutton_down(*this, x, y, mod);
 }
 
 void state::on_mbutton_down(int32_t x, int32_t y, key_modifiers mod) {
+	ui_state.invalidate_mouse_probe();
 	// Lose focus on text
 	ui_state.set_focus_target(*this, nullptr);
 }
 
 void state::on_lbutton_down(int32_t x, int32_t y, key_modifiers mod) {
+	ui_state.invalidate_mouse_probe();
 	if(ui_state.current_drag_and_drop_data_type != ui::drag_and_drop_data::none) {
 		if(!current_scene.get_root)
 			return;
@@ -56,6 +82,7 @@ void state::on_mbutton_up(int32_t x, int32_t y, key_modifiers mod) {
 
 }
 void state::on_lbutton_up(int32_t x, int32_t y, key_modifiers mod) {
+	ui_state.invalidate_mouse_probe();
 	game_scene::on_lbutton_up(*this, x, y, mod);
 }
 void state::on_mouse_move(int32_t x, int32_t y, key_modifiers mod) {
@@ -74,6 +101,7 @@ void state::on_mouse_move(int32_t x, int32_t y, key_modifiers mod) {
 		if(new_target_distance > ui_state.target_distance + 5) {
 			ui_state.mouse_sensitive_target->set_visible(*this, false);
 			ui_state.mouse_sensitive_target = nullptr;
+			ui_state.invalidate_mouse_probe();
 		} else {
 			ui_state.target_distance = std::min(ui_state.target_distance, new_target_distance);
 		}
@@ -82,6 +110,7 @@ void state::on_mouse_move(int32_t x, int32_t y, key_modifiers mod) {
 void state::on_mouse_drag(int32_t x, int32_t y, key_modifiers mod) { // called when the left button is held down
 	is_dragging = true;
 	if(ui_state.drag_target) {
+		ui_state.invalidate_mouse_probe();
 		ui_state.drag_target->on_drag(*this, int32_t(mouse_x_position / user_settings.ui_scale),
 			int32_t(mouse_y_position / user_settings.ui_scale), int32_t(x / user_settings.ui_scale),
 			int32_t(y / user_settings.ui_scale), mod);
@@ -89,11 +118,13 @@ void state::on_mouse_drag(int32_t x, int32_t y, key_modifiers mod) { // called w
 }
 void state::on_drag_finished(int32_t x, int32_t y, key_modifiers mod) { // called when the left button is released after one or more drag events
 	if(ui_state.drag_target) {
+		ui_state.invalidate_mouse_probe();
 		ui_state.drag_target->on_drag_finish(*this);
 		ui_state.drag_target = nullptr;
 	}
 }
 void state::on_resize(int32_t x, int32_t y, window::window_state win_state) {
+	ui_state.invalidate_mouse_probe();
 	if(win_state != window::window_state::minimized) {
 		ui_state.for_each_root([&](ui::element_base& elm) {
 			elm.base_data.size.x = int16_t(x / user_settings.ui_scale);
@@ -104,6 +135,7 @@ void state::on_resize(int32_t x, int32_t y, window::window_state win_state) {
 
 
 void state::on_key_down(virtual_key keycode, key_modifiers mod) {
+	ui_state.invalidate_mouse_probe();
 	if(keycode == virtual_key::CONTROL)
 		ui_state.ctrl_held_down = true;
 	if(keycode == virtual_key::SHIFT || keycode == virtual_key::LSHIFT || keycode == virtual_key::RSHIFT)
@@ -124,6 +156,7 @@ void state::on_key_up(virtual_key keycode, key_modifiers mod) {
 
 }
 void state::on_text(char32_t c) { // c is win1250 codepage value
+	ui_state.invalidate_mouse_probe();
 	if(ui_state.edit_target_internal)
 		ui_state.edit_target_internal->on_text(*this, c);
 }
@@ -133,6 +166,7 @@ bool state::filter_tso_mouse_events(int32_t x, int32_t y, uint32_t buttons) {
 	return false;
 }
 void state::pass_edit_command(ui::edit_command command, sys::key_modifiers mod) {
+	ui_state.invalidate_mouse_probe();
 	if(ui_state.edit_target_internal)
 		ui_state.edit_target_internal->on_edit_command(*this, command, mod);
 }
@@ -202,7 +236,21 @@ void state::render() { // called to render the frame may (and should) delay retu
 	//}
 
 
+#ifndef NDEBUG
+	auto const allocations_at_start = heap_allocations;
+#endif
+
+	svg_atlas.new_frame();
+	font_collection.glyphs.new_frame();
+	bool uploaded = svg_render_queue.upload_completed(svg_atlas);
+	auto streamed = open_gl.texture_streaming.upload_pending(open_gl);
+	if(textures_arriving && !streamed)
+		report_texture_memory();
+	textures_arriving = streamed;
+	uploaded = streamed || uploaded;
+
 	auto game_state_was_updated = game_state_updated.exchange(false, std::memory_order::acq_rel);
+	bool quiet_frame = !uploaded && !game_state_was_updated;
 
 	if(game_state_was_updated) {
 		//
@@ -213,10 +261,19 @@ void state::render() { // called to render the frame may (and should) delay retu
 	root_elm->base_data.size.x = ui_state.root->base_data.size.x;
 	root_elm->base_data.size.y = ui_state.root->base_data.size.y;
 
-	auto mouse_probe = root_elm->impl_probe_mouse(*this, int32_t(mouse_x_position / user_settings.ui_scale),
-		int32_t(mouse_y_position / user_settings.ui_scale), ui::mouse_probe_type::click);
-	auto tooltip_probe = root_elm->impl_probe_mouse(*this, int32_t(mouse_x_position / user_settings.ui_scale),
-		int32_t(mouse_y_position / user_settings.ui_scale), ui::mouse_probe_type::tooltip);
+	auto probe_x = int32_t(mouse_x_position / user_settings.ui_scale);
+	auto probe_y = int32_t(mouse_y_position / user_settings.ui_scale);
+	if(ui_state.mouse_probe_invalid || root_elm != ui_state.last_probe_root || probe_x != ui_state.last_probe_x || probe_y != ui_state.last_probe_y) {
+		ui_state.last_mouse_probe = root_elm->impl_probe_mouse(*this, probe_x, probe_y, ui::mouse_probe_type::click);
+		ui_state.last_tooltip_probe = root_elm->impl_probe_mouse(*this, probe_x, probe_y, ui::mouse_probe_type::tooltip);
+		ui_state.last_probe_root = root_elm;
+		ui_state.last_probe_x = probe_x;
+		ui_state.last_probe_y = probe_y;
+		ui_state.mouse_probe_invalid = false;
+		quiet_frame = false;
+	}
+	auto mouse_probe = ui_state.last_mouse_probe;
+	auto tooltip_probe = ui_state.last_tooltip_probe;
 
 	if(!mouse_probe.under_mouse) {
 		mouse_probe = current_scene.recalculate_mouse_probe(*this, mouse_probe, tooltip_probe);
@@ -236,7 +293,15 @@ void state::render() { // called to render the frame may (and should) delay retu
 	}
 
 	if(game_state_was_updated) {
-		root_elm->impl_on_update(*this);
+		ui_state.invalidate_mouse_probe();
+		// a bare game_state_updated signal without topics means everything may have changed
+		auto dirty_topics = dirty_ui_topics.exchange(0, std::memory_order::acq_rel);
+		ui_state.update_pass_topics = dirty_topics != 0 ? dirty_topics : ui::update_topic::all;
+		ui_state.update_elements_visited = 0;
+		ui_state.update_elements_updated = 0;
+		if((root_elm->impl_update_dependencies(*this) & ui_state.update_pass_topics) != 0)
+			root_elm->impl_on_update(*this);
+		ui_state.update_pass_topics = ui::update_topic::all;
 		current_scene.on_game_state_update(*this);
 		ui_state.update_tooltip(*this, tooltip_probe, tooltip_sub_index, int16_t(root_elm->base_data.size.y - 20));
 	} // END game state was updated
@@ -267,6 +332,7 @@ void state::render() { // called to render the frame may (and should) delay retu
 	glUseProgram(open_gl.ui_shader_program);
 	glUniform1i(open_gl.ui_shader_texture_sampler_uniform, 0);
 	glUniform1i(open_gl.ui_shader_secondary_texture_sampler_uniform, 1);
+	glUniform1i(open_gl.ui_shader_glyph_sampler_uniform, 2);
 	glUniform1f(open_gl.ui_shader_screen_width_uniform, float(x_size) / user_settings.ui_scale);
 	glUniform1f(open_gl.ui_shader_screen_height_uniform, float(y_size) / user_settings.ui_scale);
 	glUniform1f(open_gl.ui_shader_gamma_uniform, 1.0f);
@@ -296,6 +362,15 @@ void state::render() { // called to render the frame may (and should) delay retu
 		ui_state.drag_and_drop_image.render(*this, int32_t((x_size / user_settings.ui_scale) / 2) - win_x_size / 2 + 5 + 18, int32_t(y_size / user_settings.ui_scale) - win_y_size + 5);
 	}
 
+	ogl::end_ui_batch(open_gl);
+
+#ifndef NDEBUG
+	// a warm ui already has every layout, glyph and render it draws, so the text and quad paths must not allocate
+	ui_state.render_heap_allocations = uint32_t(heap_allocations - allocations_at_start);
+	assert(!quiet_frame || ui_state.quiet_frames < ui::state::warm_frames || ui_state.render_heap_allocations == 0);
+	ui_state.quiet_frames = quiet_frame ? ui_state.quiet_frames + 1 : 0;
+#endif
+
 	//if(ui_state.fps_counter) {
 	//	if(ui_state.fps_counter->is_visible()) {
 	//		glEndQuery(GL_TIME_ELAPSED);
@@ -304,49 +379,156 @@ void state::render() { // called to render the frame may (and should) delay retu
 
 }
 
+// a bar filled by the share of the files on_create has found so far that are loaded; plain clears, since no shader is set up yet
+static void draw_startup_progress(state& s) {
+	auto total = s.startup_items_total.load(std::memory_order::relaxed);
+	auto loaded = s.startup_items_loaded.load(std::memory_order::relaxed);
+	float fraction = total > 0 ? std::clamp(float(loaded) / float(total), 0.0f, 1.0f) : 0.0f;
+
+	int32_t bar_width = s.x_size / 2;
+	int32_t bar_height = std::max(s.y_size / 100, 4);
+	int32_t bar_x = (s.x_size - bar_width) / 2;
+	int32_t bar_y = (s.y_size - bar_height) / 2;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, s.x_size, s.y_size);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(bar_x, bar_y, bar_width, bar_height);
+	glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(bar_x, bar_y, int32_t(float(bar_width) * fraction), bar_height);
+	glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+}
+
 void state::on_create() {
 	// lua
 
 	// Load late ui defs
+	auto load_start = std::chrono::steady_clock::now();
 	auto root = get_root(common_fs);
 	auto assets = simple_fs::open_directory(root, NATIVE("assets"));
 
-	auto uitemplates = simple_fs::open_file(assets, NATIVE("the.tui"));
-	if(uitemplates) {
-		auto content = view_contents(*uitemplates);
-		serialization::in_buffer buffer(content.data, content.file_size);
-		ui_templates = template_project::bytes_to_project(buffer);
-		ui_templates.svg_directory.pop_back();
-		svg_image_files.root_directory = simple_fs::utf16_to_native(ui_templates.svg_directory);
-		auto svgdir = simple_fs::open_directory(assets, simple_fs::utf16_to_native(ui_templates.svg_directory));
-		for(auto& i : ui_templates.icons) {
-			auto f = simple_fs::open_file(svgdir, simple_fs::utf8_to_native(i.file_name));
+	svg_render_queue.cache_directory = simple_fs::get_or_create_cache_directory();
+	simple_fs::trim_directory(*svg_render_queue.cache_directory, asvg::render_cache_size_limit);
+
+	// files are opened and decoded on the workers; only the results are moved into the ui state on this (the opengl) thread
+	struct loaded_ui_file {
+		std::optional<simple_fs::file> file;
+		std::string name;
+		ankerl::unordered_dense::map<std::string, sys::aui_pending_bytes> windows;
+	};
+	std::vector<loaded_ui_file> ui_files;
+	std::optional<simple_fs::directory> svgdir;
+
+	tick_scheduler loader;
+	auto templates_stage = loader.add_phase("templates", [&](state& s) {
+		s.startup_items_total.fetch_add(1, std::memory_order::relaxed);
+		auto uitemplates = simple_fs::open_file(assets, NATIVE("the.tui"));
+		if(uitemplates) {
+			auto content = view_contents(*uitemplates);
+			serialization::in_buffer buffer(content.data, content.file_size);
+			s.ui_templates = template_project::bytes_to_project(buffer);
+			s.ui_templates.svg_directory.pop_back();
+			s.svg_image_files.root_directory = simple_fs::utf16_to_native(s.ui_templates.svg_directory);
+			svgdir = simple_fs::open_directory(assets, simple_fs::utf16_to_native(s.ui_templates.svg_directory));
+			s.startup_items_total.fetch_add(int32_t(s.ui_templates.icons.size() + s.ui_templates.backgrounds.size()), std::memory_order::relaxed);
+		}
+		s.startup_items_loaded.fetch_add(1, std::memory_order::relaxed);
+	});
+	loader.add_phase("icons", [&](state& s) {
+		if(!svgdir)
+			return;
+		tbb::parallel_for(size_t(0), s.ui_templates.icons.size(), [&](size_t n) {
+			auto& i = s.ui_templates.icons[n];
+			auto f = simple_fs::open_file(*svgdir, simple_fs::utf8_to_native(i.file_name));
 			if(f) {
 				auto contents = simple_fs::view_contents(*f);
 				i.renders = asvg::simple_svg(contents.data, size_t(contents.file_size));
 			}
-		}
-		for(auto& b : ui_templates.backgrounds) {
-			auto f = simple_fs::open_file(svgdir, simple_fs::utf8_to_native(b.file_name));
+			s.startup_items_loaded.fetch_add(1, std::memory_order::relaxed);
+		});
+	}, 1 << templates_stage);
+	loader.add_phase("backgrounds", [&](state& s) {
+		if(!svgdir)
+			return;
+		tbb::parallel_for(size_t(0), s.ui_templates.backgrounds.size(), [&](size_t n) {
+			auto& b = s.ui_templates.backgrounds[n];
+			auto f = simple_fs::open_file(*svgdir, simple_fs::utf8_to_native(b.file_name));
 			if(f) {
 				auto contents = simple_fs::view_contents(*f);
 				b.renders = asvg::svg(contents.data, size_t(contents.file_size), b.base_x, b.base_y);
 			}
-		}
-	}
-
-	for(auto gui_file : list_files(assets, NATIVE(".aui"))) {
-		auto file_name = simple_fs::get_file_name(gui_file);
-		auto opened_file = open_file(gui_file);
-		if(opened_file) {
-			file_name.pop_back(); file_name.pop_back(); file_name.pop_back(); file_name.pop_back();
-			auto afile_name = simple_fs::native_to_utf8(file_name);
-			auto content = view_contents(*opened_file);
-			bytes_to_windows(content.data, content.file_size, afile_name, ui_state.new_ui_windows);
-			ui_state.held_open_ui_files.emplace_back(std::move(*opened_file));
-		}
-	}
-
+			s.startup_items_loaded.fetch_add(1, std::memory_order::relaxed);
+		});
+	}, 1 << templates_stage);
+	loader.add_phase("windows", [&](state& s) {
+		auto gui_files = list_files(assets, NATIVE(".aui"));
+		ui_files.resize(gui_files.size());
+		s.startup_items_total.fetch_add(int32_t(gui_files.size()), std::memory_order::relaxed);
+		tbb::parallel_for(size_t(0), gui_files.size(), [&](size_t n) {
+			auto& result = ui_files[n];
+			auto file_name = simple_fs::get_file_name(gui_files[n]);
+			result.file = open_file(gui_files[n]);
+			if(result.file) {
+				file_name.pop_back(); file_name.pop_back(); file_name.pop_back(); file_name.pop_back();
+				result.name = simple_fs::native_to_utf8(file_name);
+				auto content = view_contents(*result.file);
+				bytes_to_windows(content.data, content.file_size, result.name, result.windows);
+			}
+			s.startup_items_loaded.fetch_add(1, std::memory_order::relaxed);
+		});
+	});
+	// the phases run on their own thread, so that this one can keep a progress bar on the screen meanwhile
+	std::atomic<bool> loaded = false;
+	std::thread load_thread([&]() {
+		loader.run_tick(*this);
+		loaded.store(true, std::memory_order::release);
+	});
+	while(!loaded.load(std::memory_order::acquire)) {
+		draw_startup_progress(*this);
+		window::present_frame(*this);
+		std::this_thread::sleep_for(std::chrono::milliseconds(15));
+	}
+	load_thread.join();
+
+	// in directory order, so that a window defined twice resolves the same way as when the files were read one by one
+	auto merge_start = std::chrono::steady_clock::now();
+	for(auto& f : ui_files) {
+		if(!f.file)
+			continue;
+		for(auto& w : f.windows)
+			ui_state.new_ui_windows.insert_or_assign(w.first, w.second);
+		ui_state.held_open_ui_files.emplace_back(std::move(*f.file));
+	}
+	auto load_end = std::chrono::steady_clock::now();
+
+	startup_timings.clear();
+	for(uint32_t i = 0; i < loader.phase_count(); ++i)
+		startup_timings.push_back(startup_stage_timing{ loader.phase(i).name, loader.phase(i).last_duration_ns.load(std::memory_order::relaxed) });
+	startup_timings.push_back(startup_stage_timing{ "merge", std::chrono::duration_cast<std::chrono::nanoseconds>(load_end - merge_start).count() });
+	startup_timings.push_back(startup_stage_timing{ "total", std::chrono::duration_cast<std::chrono::nanoseconds>(load_end - load_start).count() });
+#ifndef NDEBUG
+	// the icons, backgrounds and windows phases overlap, so their durations add up to more than the total
+	for(auto& t : startup_timings)
+		std::fprintf(stderr, "startup %s: %.2f ms\n", t.name, double(t.duration_ns) / 1000000.0);
+#endif
+	report_texture_memory();
+}
+
+void state::report_texture_memory() {
+	texture_report = ogl::make_texture_memory_report();
+#ifndef NDEBUG
+	auto& r = texture_report;
+	std::fprintf(stderr, "textures: %u block compressed, %u uncompressed, %llu KiB in video memory, %llu KiB saved by compression",
+		r.loaded.compressed_textures, r.loaded.uncompressed_textures, (unsigned long long)(r.loaded.stored_bytes / 1024), (unsigned long long)(r.saved_bytes / 1024));
+	if(r.free_video_memory_kb >= 0)
+		std::fprintf(stderr, ", %lld KiB free", (long long)r.free_video_memory_kb);
+	std::fprintf(stderr, "\n");
+#endif
 }
 //
 // string pool functions
@@ -474,6 +656,7 @@ void state::save_user_settings() const {
 	US_SAVE(zoom_speed);
 	US_SAVE(mute_on_focus_lost);
 	US_SAVE(locale);
+	US_SAVE(sdf_glyphs);
 #undef US_SAVE
 
 	simple_fs::write_file(settings_location, NATIVE("user_settings.dat"), &buffer[0], uint32_t(ptr - buffer));
@@ -502,6 +685,7 @@ void state::load_user_settings() {
 			US_LOAD(zoom_speed);
 			US_LOAD(mute_on_focus_lost);
 			US_LOAD(locale);
+			US_LOAD(sdf_glyphs);
 #undef US_LOAD
 		} while(false);
 
@@ -523,6 +707,8 @@ void state::load_user_settings() {
 
 	}
 
+	font_collection.sdf_glyphs = user_settings.sdf_glyphs; // nothing is in the glyph atlas yet
+
 	user_settings.locale[15] = 0;
 	std::string lname(user_settings.locale);
 	bool locale_loaded = false;
@@ -568,6 +754,7 @@ void state::load_user_settings() {
 }
 
 void state::update_ui_scale(float new_scale) {
+	ui_state.invalidate_mouse_probe();
 	user_settings.ui_scale = new_scale;
 	ui_state.for_each_root([&](ui::element_base& elm) {
 		elm.base_data.size.x = int16_t(x_size / user_settings.ui_scale);
@@ -575,33 +762,106 @@ void state::update_ui_scale(float new_scale) {
 	});
 
 	for(auto& s : ui_templates.backgrounds) {
-		s.renders.release_renders();
+		s.renders.release_renders(svg_atlas);
 	}
 	for(auto& s : ui_templates.icons) {
-		s.renders.release_renders();
+		s.renders.release_renders(svg_atlas);
 	}
 	//font_collection.reset_fonts();
+	if(font_collection.sdf_glyphs != user_settings.sdf_glyphs) {
+		// glyphs of the other kind can't be reused; resetting the atlas also bumps its generation, which drops retained quads
+		font_collection.sdf_glyphs = user_settings.sdf_glyphs;
+		font_collection.glyphs.reset();
+	}
 
 	ui_state.for_each_root([&](ui::element_base& elm) {
 		elm.impl_on_reset_text(*this);
 	});
 
-	game_state_updated.store(true, std::memory_order::release); //update ui
+	mark_ui_dirty(ui::update_topic::ui_settings); //update ui
 
 	// TODO move windows
 }
 
+uint32_t tick_scheduler::add_phase(char const* name, std::function<void(state&)> run, uint32_t dependencies) {
+	if(count >= max_phases)
+		std::abort(); // too many phases
+	if((dependencies >> count) != 0)
+		std::abort(); // depends on a phase that does not exist yet
+	auto& p = phases[count];
+	p.name = name;
+	p.run = std::move(run);
+	p.dependencies = dependencies;
+	return count++;
+}
+
+void tick_scheduler::run_tick(state& s) {
+	auto tick_start = std::chrono::steady_clock::now();
+	uint32_t finished = 0;
+	uint32_t all = count == max_phases ? ~uint32_t(0) : (uint32_t(1) << count) - 1;
+
+	arena.execute([&]() {
+		// phases only depend on earlier ones, so every pass makes progress
+		while(finished != all) {
+			uint32_t ready = 0;
+			for(uint32_t i = 0; i < count; ++i) {
+				if((finished & (uint32_t(1) << i)) == 0 && (phases[i].dependencies & finished) == phases[i].dependencies)
+					ready |= uint32_t(1) << i;
+			}
+
+			tbb::task_group group;
+			for(uint32_t i = 0; i < count; ++i) {
+				if((ready & (uint32_t(1) << i)) == 0)
+					continue;
+				group.run([&s, &p = phases[i]]() {
+					auto phase_start = std::chrono::steady_clock::now();
+					p.run(s);
+					auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - phase_start).count();
+					p.last_duration_ns.store(ns, std::memory_order::relaxed);
+					p.total_duration_ns.fetch_add(ns, std::memory_order::relaxed);
+				});
+			}
+			group.wait();
+			finished |= ready;
+		}
+	});
+
+	last_tick_duration_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tick_start).count(), std::memory_order::relaxed);
+}
+
 void state::single_game_tick() {
 	// do update logic
 
 	tick_start_counter.fetch_add(1, std::memory_order::seq_cst);
 
-	// do business
+	tick_phases.run_tick(*this);
 
 	tick_end_counter.fetch_add(1, std::memory_order::seq_cst);
+	mark_ui_dirty(ui::update_topic::game_tick);
+}
+
+void state::mark_ui_dirty(ui::update_mask topics) {
+	dirty_ui_topics.fetch_or(topics, std::memory_order::release);
 	game_state_updated.store(true, std::memory_order::release);
 }
 
+void state::wake_game_loop() {
+	{
+		std::lock_guard lg{ game_loop_lock };
+		game_loop_signaled = true;
+	}
+	game_loop_cv.notify_one();
+}
+
+void state::set_game_speed(int32_t speed) {
+	actual_game_speed.store(speed, std::memory_order::release);
+	wake_game_loop();
+}
+
+void state::set_ui_pause(bool paused) {
+	ui_pause.store(paused, std::memory_order::release);
+	wake_game_loop();
+}
 
 void state::game_loop() {
 	static int32_t game_speed[] = {
@@ -612,6 +872,17 @@ void state::game_loop() {
 		125,		// speed 4 -- 0.125 seconds
 	};
 
+	// ticks are scheduled at fixed intervals from the previous deadline rather than from when the tick actually ran, so lateness does not accumulate
+	auto next_tick = last_update;
+	bool running = false;
+	int32_t running_speed = 0;
+
+	auto sleep_until = [&](std::chrono::time_point<std::chrono::steady_clock> deadline) {
+		std::unique_lock lk{ game_loop_lock };
+		game_loop_cv.wait_until(lk, deadline, [&]() { return game_loop_signaled; });
+		game_loop_signaled = false;
+	};
+
 	while(quit_signaled.load(std::memory_order::acquire) == false) {
 		{
 			command::execute_pending_commands(*this);
@@ -619,20 +890,33 @@ void state::game_loop() {
 
 		auto speed = actual_game_speed.load(std::memory_order::acquire);
 		auto upause = ui_pause.load(std::memory_order::acquire);
+		auto now = std::chrono::steady_clock::now();
 
 		if(speed <= 0 || upause || internally_paused || current_scene.enforced_pause) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(15));
+			running = false;
+			// scene pauses do not signal, so still look again every so often
+			sleep_until(now + std::chrono::milliseconds(100));
+		} else if(speed >= 5) {
+			running = false;
+			last_update = now;
+			single_game_tick();
 		} else {
-			auto entry_time = std::chrono::steady_clock::now();
-			auto ms_count = std::chrono::duration_cast<std::chrono::milliseconds>(entry_time - last_update).count();
-			if(speed >= 5 || ms_count >= game_speed[speed]) { /*enough time has passed*/
-				last_update = entry_time;
+			auto interval = std::chrono::milliseconds(game_speed[speed]);
+			if(!running || running_speed != speed) {
+				next_tick = std::max(now, last_update + interval);
+				running = true;
+				running_speed = speed;
+			}
+			if(now >= next_tick) {
+				last_update = now;
 				single_game_tick();
+				next_tick += interval;
+				if(next_tick + interval < now) // fell more than a tick behind, don't try to catch up with a burst
+					next_tick = now + interval;
 			} else {
-				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				sleep_until(next_tick);
 			}
 		}
-
 	}
 }
 
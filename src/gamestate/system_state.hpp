@@ -5,6 +5,9 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <array>
+#include <functional>
+#include "oneapi/tbb/task_arena.h"
 
 #include "window.hpp"
 #include "sound.hpp"
@@ -15,6 +18,7 @@
 // #include "SPSCQueue.h"
 #include "text.hpp"
 #include "game_scene.hpp"
+#include "commands_containers.hpp"
 #include "graphics\opengl_wrapper.hpp"
 #include "gui\ui_state.hpp"
 
@@ -38,9 +42,49 @@ struct user_settings_s {
 	float zoom_speed = 20.f;
 	bool mute_on_focus_lost = true;
 	char locale[16] = "en-US";
+	bool sdf_glyphs = false; // see text::font_manager::sdf_glyphs; applied by update_ui_scale
 };
 
 
+struct state;
+
+// one step of a game tick
+struct tick_phase {
+	char const* name = "";
+	std::function<void(state&)> run;
+	uint32_t dependencies = 0; // bit i set: waits for phase i to finish
+	std::atomic<int64_t> last_duration_ns = 0; // duration of the most recent run, may be read from the ui thread
+	std::atomic<int64_t> total_duration_ns = 0;
+};
+
+// runs the phases of a tick in dependency order; phases that do not depend on each other run in parallel
+// also drives the loading done by state::on_create
+class tick_scheduler {
+public:
+	static constexpr uint32_t max_phases = 32;
+
+	// a phase may only depend on phases added before it; returns the index to use in later dependency masks
+	uint32_t add_phase(char const* name, std::function<void(state&)> run, uint32_t dependencies = 0);
+	void run_tick(state& s);
+	uint32_t phase_count() const {
+		return count;
+	}
+	tick_phase const& phase(uint32_t i) const {
+		return phases[i];
+	}
+
+	std::atomic<int64_t> last_tick_duration_ns = 0;
+private:
+	std::array<tick_phase, max_phases> phases;
+	uint32_t count = 0;
+	tbb::task_arena arena;
+};
+
+struct startup_stage_timing {
+	char const* name = "";
+	int64_t duration_ns = 0;
+};
+
 struct alignas(64) state {
 	// dcon::data_container world; // Holds data regarding the game world. Also contains user locales.
 
@@ -75,22 +119,29 @@ struct alignas(64) state {
 	ui::state ui_state;                                              // transient information for the state of the ui
 	ogl::animation ui_animation;
 	asvg::file_bank svg_image_files;
+	asvg::texture_atlas svg_atlas;
+	asvg::render_queue svg_render_queue;
 	template_project::project ui_templates;
 
 	// synchronization data (between main update logic and ui thread)
 	std::atomic<bool> game_state_updated = false;                    // game state -> ui signal
+	std::atomic<ui::update_mask> dirty_ui_topics = 0;                // game state -> ui: what changed, see mark_ui_dirty
 	std::atomic<int32_t> actual_game_speed = 0;                      // ui -> game state message
 	std::atomic<bool> quit_signaled = false;                         // ui -> game state signal
-	// rigtorp::SPSCQueue<command::command_data> incoming_commands;          // ui or network -> local gamestate
+	command::command_ring incoming_commands;                         // ui, network or scripting threads -> local gamestate
 	std::atomic<bool> ui_pause = false;                              // force pause by an important message being open
 
 	std::atomic<int64_t> tick_start_counter;
 	std::atomic<int64_t> tick_end_counter;
 
+	std::mutex game_loop_lock;
+	std::condition_variable game_loop_cv;                            // wakes the game loop early
+	bool game_loop_signaled = false;                                 // guarded by game_loop_lock
 
 	// internal game timer / update logic
 	std::chrono::time_point<std::chrono::steady_clock> last_update = std::chrono::steady_clock::now();
 	bool internally_paused = false; // should NOT be set from the ui context (but may be read)
+	tick_scheduler tick_phases;
 
 	// common data for the window
 	int32_t x_size = 0;
@@ -116,6 +167,12 @@ struct alignas(64) state {
 	// the following functions will be invoked by the window subsystem
 
 	void on_create(); // called once after the window is created and opengl is ready
+	std::vector<startup_stage_timing> startup_timings;                // filled by on_create and logged in debug builds, the last entry is the total
+	std::atomic<int32_t> startup_items_total = 0;                    // files on_create has found so far, shown as its progress bar
+	std::atomic<int32_t> startup_items_loaded = 0;
+	ogl::texture_memory_report texture_report;                         // refreshed after on_create and whenever streamed textures stop arriving
+	bool textures_arriving = false;
+	void report_texture_memory(); // GL thread only
 	void on_rbutton_down(int32_t x, int32_t y, key_modifiers mod);
 	void on_mbutton_down(int32_t x, int32_t y, key_modifiers mod);
 	void on_lbutton_down(int32_t x, int32_t y, key_modifiers mod);
@@ -139,6 +196,11 @@ struct alignas(64) state {
 	void single_game_tick();
 	// this function runs the internal logic of the game. It will return *only* after a quit notification is sent to it
 	void game_loop();
+	// call after queueing a command or changing the speed, pause or quit flags so the game loop does not sleep through it
+	void wake_game_loop();
+	void mark_ui_dirty(ui::update_mask topics); // schedules an update pass for the elements reading any of these topics
+	void set_game_speed(int32_t speed);
+	void set_ui_pause(bool paused);
 
 
 	std::string_view to_string_view(dcon::text_key tag) const;
@@ -153,7 +215,7 @@ struct alignas(64) state {
 	uint32_t add_locale_data_utf8(std::string const& text);
 	uint32_t add_locale_data_utf8(std::string_view text);
 
-	state() : untrans_key_to_text_sequence(0, text::vector_backed_ci_hash(key_data), text::vector_backed_ci_eq(key_data)), locale_key_to_text_sequence(0, text::vector_backed_ci_hash(key_data), text::vector_backed_ci_eq(key_data)), incoming_commands(4096) {
+	state() : untrans_key_to_text_sequence(0, text::vector_backed_ci_hash(key_data), text::vector_backed_ci_eq(key_data)), locale_key_to_text_sequence(0, text::vector_backed_ci_hash(key_data), text::vector_backed_ci_eq(key_data)), incoming_commands(1 << 16) {
 		game_scene::switch_scene(*this, game_scene::scene_id::in_game_basic);
 		key_data.push_back(0);
 	}
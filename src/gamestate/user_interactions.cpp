@@ -11,6 +11,7 @@ void on_mouse_wheel(sys::state& state, int32_t x, int32_t y, key_modifiers mod,
 		ui::mouse_probe_type::scroll);
 
 	state.ui_state.scroll_target = probe_result.under_mouse;
+	state.ui_state.invalidate_mouse_probe();
 
 
 	if(state.ui_state.scroll_target != nullptr) {
@@ -6,60 +6,248 @@
 #endif
 #include "GL/glew.h"
 #include "simple_fs.hpp"
+#include "blake2.h"
+#include "zstd.h"
+#include "oneapi/tbb/parallel_for.h"
+#include "oneapi/tbb/task_arena.h"
 
 void assert_no_errors();
 
 namespace asvg {
 
-svg_instance::~svg_instance() noexcept {
-	if(texture_handle != 0) {
-		glDeleteTextures(1, &texture_handle);
-		texture_handle = 0;
+texture_atlas::~texture_atlas() {
+	for(auto& p : pages) {
+		if(p.texture_handle != 0) {
+			glDeleteTextures(1, &p.texture_handle);
+			p.texture_handle = 0;
+		}
 	}
 }
 
-svg_instance::svg_instance(char const* bytes, int32_t sx, int32_t sy) {
-	glGenTextures(1, &texture_handle);
-	if(texture_handle) {
-		glBindTexture(GL_TEXTURE_2D, texture_handle);
+uint32_t texture_atlas::make_page(int32_t sx, int32_t sy, bool oversized) {
+	uint32_t index = uint32_t(pages.size());
+	for(uint32_t i = 0; i < pages.size(); ++i) {
+		if(pages[i].texture_handle == 0) {
+			index = i;
+			break;
+		}
+	}
+	if(index == pages.size())
+		pages.emplace_back();
+
+	auto& p = pages[index];
+	p.shelves.clear();
+	p.live_entries = 0;
+	p.last_used = frame;
+	p.oversized = oversized;
+
+	glGenTextures(1, &p.texture_handle);
+	if(p.texture_handle) {
+		glBindTexture(GL_TEXTURE_2D, p.texture_handle);
 		assert_no_errors();
 		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, sx, sy);
 		assert_no_errors();
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, sx, sy, GL_RGBA, GL_UNSIGNED_BYTE, bytes);
+		uint32_t clearvalue = 0;
+		glClearTexImage(p.texture_handle, 0, GL_RGBA, GL_UNSIGNED_BYTE, &clearvalue);
 		assert_no_errors();
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		assert_no_errors();
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		assert_no_errors();
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		assert_no_errors();
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		assert_no_errors();
 
 		glBindTexture(GL_TEXTURE_2D, 0);
-		assert_no_errors();
+	}
+	return index;
+}
+
+bool texture_atlas::place(page& p, int32_t sx, int32_t sy, int32_t& x, int32_t& y) {
+	auto w = sx + padding;
+	auto h = sy + padding;
+
+	// best fitting shelf: the lowest one that is tall enough and still has room
+	shelf* best = nullptr;
+	for(auto& sh : p.shelves) {
+		if(sh.height >= h && sh.x + w <= page_size && (!best || sh.height < best->height))
+			best = &sh;
+	}
+	if(!best) {
+		auto top = p.shelves.empty() ? 0 : p.shelves.back().y + p.shelves.back().height;
+		if(top + h > page_size)
+			return false;
+		p.shelves.push_back(shelf{ top, h, 0 });
+		best = &p.shelves.back();
+	}
+	x = best->x;
+	y = best->y;
+	best->x += w;
+	return true;
+}
+
+void texture_atlas::evict_page(uint32_t index, bool reuse) {
+	for(uint32_t i = 0; i < slots.size(); ++i) {
+		if(slots[i].live && slots[i].page == index) {
+			slots[i].live = false;
+			++slots[i].generation;
+			free_slots.push_back(i);
+		}
+	}
+	auto& p = pages[index];
+	p.shelves.clear();
+	p.live_entries = 0;
+	++evictions;
+	if(p.texture_handle == 0)
+		return;
+	if(p.oversized || !reuse) {
+		glDeleteTextures(1, &p.texture_handle);
+		p.texture_handle = 0;
+	} else {
+		// new entries only overwrite their own pixels; the padding next to them would keep texels of the evicted renders, which linear filtering blends in
+		uint32_t clearvalue = 0;
+		glClearTexImage(p.texture_handle, 0, GL_RGBA, GL_UNSIGNED_BYTE, &clearvalue);
+	}
+}
+
+void texture_atlas::new_frame() {
+	++frame;
+	// pages made past max_pages, because every page was drawn from in the same frame, are deleted again once one goes a frame unused
+	uint32_t regular_pages = 0;
+	for(auto& p : pages) {
+		if(p.texture_handle != 0 && !p.oversized)
+			++regular_pages;
+	}
+	for(uint32_t i = uint32_t(pages.size()); i-- > 0 && regular_pages > max_pages;) {
+		auto& p = pages[i];
+		if(p.texture_handle == 0 || p.oversized || p.last_used + 1 >= frame)
+			continue;
+		evict_page(i, false);
+		--regular_pages;
 	}
 }
 
-svg_instance::svg_instance(svg_instance&& other) noexcept {
-	if(texture_handle != 0) {
-		glDeleteTextures(1, &texture_handle);
+atlas_handle texture_atlas::add(char const* bgra, int32_t sx, int32_t sy) {
+	uint32_t page_index = 0;
+	int32_t x = 0;
+	int32_t y = 0;
+
+	if(sx + padding > page_size || sy + padding > page_size) {
+		page_index = make_page(sx, sy, true);
+	} else {
+		bool placed = false;
+		for(uint32_t i = 0; i < pages.size() && !placed; ++i) {
+			if(pages[i].texture_handle != 0 && !pages[i].oversized && place(pages[i], sx, sy, x, y)) {
+				page_index = i;
+				placed = true;
+			}
+		}
+		if(!placed) {
+			// prefer a page whose entries have all been released, then a new page, then the least recently used one
+			uint32_t regular_pages = 0;
+			uint32_t lru = uint32_t(pages.size());
+			for(uint32_t i = 0; i < pages.size(); ++i) {
+				if(pages[i].texture_handle == 0 || pages[i].oversized)
+					continue;
+				++regular_pages;
+				if(pages[i].live_entries == 0) {
+					lru = i;
+					break;
+				}
+				if(lru == pages.size() || pages[i].last_used < pages[lru].last_used)
+					lru = i;
+			}
+			// never recycle a page drawn from this frame, its quads may still be waiting in the batch
+			if(lru != pages.size() && (pages[lru].live_entries == 0 || (regular_pages >= max_pages && pages[lru].last_used != frame))) {
+				evict_page(lru, true);
+				page_index = lru;
+			} else {
+				page_index = make_page(page_size, page_size, false);
+			}
+			place(pages[page_index], sx, sy, x, y);
+		}
 	}
-	texture_handle = other.texture_handle;
-	other.texture_handle = 0;
+
+	auto& p = pages[page_index];
+	glBindTexture(GL_TEXTURE_2D, p.texture_handle);
+	assert_no_errors();
+	// plutovg's native layout: premultiplied ARGB words, which the atlas_sprite shader un-premultiplies after filtering
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, sx, sy, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, bgra);
+	assert_no_errors();
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	float page_x = float(p.oversized ? sx : page_size);
+	float page_y = float(p.oversized ? sy : page_size);
+
+	uint32_t slot_index = 0;
+	if(!free_slots.empty()) {
+		slot_index = free_slots.back();
+		free_slots.pop_back();
+	} else {
+		slot_index = uint32_t(slots.size());
+		slots.emplace_back();
+	}
+	auto& sl = slots[slot_index];
+	sl.region.texture_handle = p.texture_handle;
+	sl.region.x = float(x) / page_x;
+	sl.region.width = float(sx) / page_x;
+	sl.region.y = float(y) / page_y;
+	sl.region.height = float(sy) / page_y;
+	sl.page = page_index;
+	sl.live = true;
+	++p.live_entries;
+	p.last_used = frame;
+
+	return atlas_handle{ slot_index, sl.generation };
+}
+
+atlas_region const* texture_atlas::find(atlas_handle h) {
+	if(h.slot >= slots.size() || !slots[h.slot].live || slots[h.slot].generation != h.generation)
+		return nullptr;
+	pages[slots[h.slot].page].last_used = frame;
+	return &slots[h.slot].region;
 }
 
-svg_instance& svg_instance::operator=(svg_instance&& other) noexcept {
-	if(texture_handle != 0) {
-		glDeleteTextures(1, &texture_handle);
+uint32_t texture_atlas::page_of(uint32_t texture_handle) const {
+	if(texture_handle == 0)
+		return uint32_t(pages.size());
+	for(uint32_t i = 0; i < pages.size(); ++i) {
+		if(pages[i].texture_handle == texture_handle)
+			return i;
 	}
-	texture_handle = other.texture_handle;
-	other.texture_handle = 0;
-	return *this;
+	return uint32_t(pages.size());
 }
 
+void texture_atlas::release(atlas_handle h) {
+	if(h.slot >= slots.size() || !slots[h.slot].live || slots[h.slot].generation != h.generation)
+		return;
+	auto& sl = slots[h.slot];
+	sl.live = false;
+	++sl.generation;
+	free_slots.push_back(h.slot);
+
+	auto& p = pages[sl.page];
+	--p.live_entries;
+	if(p.live_entries == 0 && p.oversized && p.texture_handle != 0) {
+		glDeleteTextures(1, &p.texture_handle);
+		p.texture_handle = 0;
+		++evictions;
+	}
+}
+
+struct parsed_document {
+	std::mutex access; // renders of the same document are serialized
+	std::vector<char> data; // svg_data with an id injected into every element that has a bound attribute
+	std::vector<std::string> element_ids; // one per binding
+	std::vector<std::string> attribute_names;
+	std::unique_ptr<lunasvg::Document> doc;
+	std::vector<lunasvg::Element> targets;
+	std::vector<lunasvg::Element> primary;
+};
+
 svg::svg(char const* data, size_t count, int32_t base_width, int32_t base_height) : svg_data(data, data+count), base_width(base_width), base_height(base_height) {
+	int32_t base_size[2] = { base_width, base_height };
+	blake2b(&content_hash, sizeof(content_hash), data, count, base_size, sizeof(base_size));
+
 	for(size_t i = 0; i < count; ++i) {
 		if(svg_data[i] == '[' && i + 1 < count && svg_data[i + 1] == '[') {
 			affine_replacement new_rep{ };
@@ -153,15 +341,325 @@ svg::svg(char const* data, size_t count, int32_t base_width, int32_t base_height
 			}
 		}
 	}
+
+	bind_replacements();
+}
+
+static bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void svg::bind_replacements() {
+	auto count = svg_data.size();
+	auto d = std::make_shared<parsed_document>();
+	std::vector<bool> bound(replacements.size(), false);
+	std::vector<std::pair<size_t, std::string>> injected_ids;
+
+	// <use> clones its target when the document is built, so bound attributes wouldn't reach the clones
+	std::string_view text(svg_data.data(), count);
+	if(!replacements.empty() && text.find("<use") != std::string_view::npos)
+		return;
+
+	size_t i = 0;
+	while(i < count) {
+		if(svg_data[i] != '<' || i + 1 >= count || svg_data[i + 1] == '/' || svg_data[i + 1] == '!' || svg_data[i + 1] == '?') {
+			++i;
+			continue;
+		}
+		auto tag_start = i;
+		++i;
+		while(i < count && !is_space(svg_data[i]) && svg_data[i] != '>' && svg_data[i] != '/')
+			++i;
+		auto name_end = i;
+		bool tag_bound = false;
+
+		while(i < count && svg_data[i] != '>') {
+			if(svg_data[i] != '\"' && svg_data[i] != '\'') {
+				++i;
+				continue;
+			}
+			auto quote = svg_data[i];
+			auto value_start = i + 1;
+			auto value_end = value_start;
+			while(value_end < count && svg_data[value_end] != quote)
+				++value_end;
+
+			attribute_binding binding;
+			auto pos = value_start;
+			for(uint32_t k = 0; k < replacements.size(); ++k) {
+				auto& reos = replacements[k];
+				if(reos.start_position + 1 < value_start || reos.end_position > value_end + 1)
+					continue;
+				auto start = std::max(size_t(reos.start_position), value_start);
+				binding.literals.emplace_back(svg_data.data() + pos, svg_data.data() + start);
+				binding.slots.push_back(k);
+				pos = std::min(size_t(reos.end_position), value_end);
+				bound[k] = true;
+			}
+			if(!binding.slots.empty()) {
+				binding.literals.emplace_back(svg_data.data() + pos, svg_data.data() + value_end);
+
+				auto attr_end = i;
+				while(attr_end > tag_start && (is_space(svg_data[attr_end - 1]) || svg_data[attr_end - 1] == '='))
+					--attr_end;
+				auto attr_start = attr_end;
+				while(attr_start > tag_start && !is_space(svg_data[attr_start - 1]))
+					--attr_start;
+
+				if(!tag_bound) {
+					injected_ids.emplace_back(name_end, "asvg-" + std::to_string(injected_ids.size()));
+					tag_bound = true;
+				}
+				d->element_ids.push_back(injected_ids.back().second);
+				d->attribute_names.emplace_back(svg_data.data() + attr_start, svg_data.data() + attr_end);
+				bindings.push_back(std::move(binding));
+			}
+			i = value_end + 1;
+		}
+	}
+
+	for(auto b : bound) {
+		if(!b) { // a replacement outside of any attribute, fall back to patching the text
+			bindings.clear();
+			return;
+		}
+	}
+
+	// the injected id comes first so that an id already on the element still wins as the attribute value
+	size_t copied = 0;
+	for(auto& inj : injected_ids) {
+		d->data.insert(d->data.end(), svg_data.data() + copied, svg_data.data() + inj.first);
+		auto attr = " id=\"" + inj.second + "\"";
+		d->data.insert(d->data.end(), attr.begin(), attr.end());
+		copied = inj.first;
+	}
+	d->data.insert(d->data.end(), svg_data.data() + copied, svg_data.data() + count);
+	document = std::move(d);
+}
+
+render_queue::~render_queue() {
+	workers.wait();
+}
+
+// renders larger than this are split into bands of rows that rasterize on separate threads
+constexpr size_t band_render_pixels = 512 * 512;
+constexpr int32_t band_rows = 128;
+
+static void rasterize(render_job& job, lunasvg::Document& doc) {
+	job.pixels.resize(size_t(job.size_x) * size_t(job.size_y) * 4);
+	lunasvg::Bitmap bmp(job.pixels.data(), job.size_x, job.size_y, job.size_x * 4);
+
+	auto matrix = job.render_scale != 0.0f
+		? lunasvg::Matrix{ }.scale(job.render_scale, job.render_scale)
+		: lunasvg::Matrix{ }.scale(float(job.size_x) / float(doc.width()), float(job.size_y) / float(doc.height()));
+	if(size_t(job.size_x) * size_t(job.size_y) <= band_render_pixels) {
+		doc.render(bmp, matrix);
+	} else {
+		// an empty band fills the bounding boxes the document computes lazily, so the bands can then share it
+		doc.render(bmp, matrix, 0, 0);
+		int32_t band_count = (job.size_y + band_rows - 1) / band_rows;
+		// the caller may hold the document's mutex: isolated, a thread waiting here can't pick up another render
+		// job that would lock it again
+		tbb::this_task_arena::isolate([&]() {
+			tbb::parallel_for(int32_t(0), band_count, [&](int32_t i) {
+				doc.render(bmp, matrix, i * band_rows, band_rows);
+			});
+		});
+	}
+}
+
+// cached bitmaps: a cache_header followed by the zstd compressed premultiplied BGRA pixels
+constexpr uint32_t cache_version = 2;
+
+struct cache_header {
+	uint32_t version = cache_version;
+	int32_t size_x = 0;
+	int32_t size_y = 0;
+};
+
+static uint64_t make_cache_key(uint64_t content_hash, uint64_t idx, int32_t grid_size, float scale) {
+	struct {
+		uint64_t content_hash;
+		uint64_t idx;
+		int32_t grid_size;
+		float scale;
+	} key_data{ content_hash, idx, grid_size, scale };
+	uint64_t key = 0;
+	blake2b(&key, sizeof(key), &key_data, sizeof(key_data), nullptr, 0);
+	return key;
+}
+
+static native_string cache_file_name(uint64_t key) {
+	char buffer[24] = { 0 };
+	auto result = std::to_chars(buffer, buffer + 16, key, 16);
+	return simple_fs::utf8_to_native(std::string_view(buffer, size_t(result.ptr - buffer))) + NATIVE(".bmpz");
+}
+
+static bool read_cached_render(simple_fs::directory const& dir, render_job& job) {
+	auto f = simple_fs::open_file(dir, cache_file_name(job.cache_key));
+	if(!f)
+		return false;
+	auto content = simple_fs::view_contents(*f);
+	if(content.file_size < sizeof(cache_header))
+		return false;
+	cache_header header;
+	memcpy(&header, content.data, sizeof(cache_header));
+	auto expected = size_t(job.size_x) * size_t(job.size_y) * 4;
+	if(header.version != cache_version || header.size_x != job.size_x || header.size_y != job.size_y)
+		return false;
+	auto compressed = content.data + sizeof(cache_header);
+	auto compressed_size = content.file_size - sizeof(cache_header);
+	if(ZSTD_getFrameContentSize(compressed, compressed_size) != expected)
+		return false;
+	job.pixels.resize(expected);
+	auto written = ZSTD_decompress(job.pixels.data(), expected, compressed, compressed_size);
+	if(ZSTD_isError(written) || written != expected) {
+		job.pixels.clear();
+		return false;
+	}
+	return true;
+}
+
+static void write_cached_render(simple_fs::directory const& dir, render_job const& job) {
+	std::vector<char> buffer(sizeof(cache_header) + ZSTD_compressBound(job.pixels.size()));
+	cache_header header{ cache_version, job.size_x, job.size_y };
+	memcpy(buffer.data(), &header, sizeof(cache_header));
+	auto written = ZSTD_compress(buffer.data() + sizeof(cache_header), buffer.size() - sizeof(cache_header), job.pixels.data(), job.pixels.size(), 3);
+	if(ZSTD_isError(written))
+		return;
+	simple_fs::replace_file(dir, cache_file_name(job.cache_key), buffer.data(), uint32_t(sizeof(cache_header) + written));
+}
+
+void render_queue::submit(simple_fs::file_system const& fs, asvg::file_bank& svg_image_files, std::shared_ptr<render_job> job) {
+	workers.run([this, &fs, &svg_image_files, job = std::move(job)]() {
+		auto loader = [&svg_image_files, &fs](std::string_view file_name) {
+			return svg_image_files.get_file_data(fs, file_name);
+		};
+
+		if(cache_directory && read_cached_render(*cache_directory, *job)) {
+			simple_fs::touch_file(*cache_directory, cache_file_name(job->cache_key)); // trimming the cache keeps the renders that are reused
+			job->document.reset();
+			job->svg_data = std::vector<char>{ };
+			completed.push(std::move(job));
+			return;
+		}
+
+		if(job->document) {
+			auto& d = *job->document;
+			std::lock_guard lock(d.access);
+			if(!d.doc) {
+				d.doc = lunasvg::Document::loadFromData(d.data.data(), d.data.size(), loader);
+				if(!d.doc) std::abort(); // TODO: error message
+				for(auto& id : d.element_ids)
+					d.targets.push_back(d.doc->getElementById(id));
+				d.primary = d.doc->querySelectorAll(".primarycolor");
+			}
+			for(size_t i = 0; i < d.targets.size(); ++i)
+				d.targets[i].setAttribute(d.attribute_names[i], job->attribute_values[i]);
+			for(auto& e : d.primary) {
+				e.setAttribute("fill", job->primary_color);
+				e.setAttribute("stroke", job->primary_color);
+			}
+			rasterize(*job, *d.doc);
+		} else {
+			auto doc = lunasvg::Document::loadFromData(job->svg_data.data(), job->svg_data.size(), loader);
+			if(!doc) std::abort(); // TODO: error message
+			doc->applyStyleSheet(job->stylesheet);
+			rasterize(*job, *doc);
+			job->svg_data = std::vector<char>{ };
+		}
+		if(cache_directory)
+			write_cached_render(*cache_directory, *job);
+
+		job->document.reset();
+		completed.push(std::move(job));
+	});
+}
+
+bool render_queue::upload_completed(texture_atlas& atlas) {
+	bool any = false;
+	std::shared_ptr<render_job> job;
+	while(completed.try_pop(job)) {
+		any = true;
+		if(!job->cancelled)
+			job->handle = atlas.add((char const*)(job->pixels.data()), job->size_x, job->size_y);
+		job->pixels = std::vector<uint8_t>{ };
+		job->uploaded = true;
+	}
+	return any;
+}
+
+static std::string make_color(float r, float g, float b) {
+	auto tohexdigit = [](uint32_t v) {
+		char table[] = "0123456789abcdef";
+		return table[v & 0x0F];
+	};
+	auto rv = uint32_t(r * 255.0f);
+	auto gv = uint32_t(g * 255.0f);
+	auto bv = uint32_t(b * 255.0f);
+	char color[] = { '#', tohexdigit(rv >> 4), tohexdigit(rv), tohexdigit(gv >> 4), tohexdigit(gv), tohexdigit(bv >> 4), tohexdigit(bv), 0 };
+	return std::string(color);
+}
+
+static std::string make_stylesheet(float r, float g, float b) {
+	auto color = make_color(r, g, b);
+	return ".primarycolor { fill: " + color + "; stroke: " + color + "; } ";
+}
+
+// claims the upload of a finished job; nullptr while the job is in flight or after the entry was evicted
+static atlas_region const* find_render(texture_atlas& atlas, cached_render& c) {
+	if(c.job) {
+		if(!c.job->uploaded)
+			return nullptr;
+		c.handle = c.job->handle;
+		c.job.reset();
+	}
+	return atlas.find(c.handle);
+}
+
+static void release_render(texture_atlas& atlas, cached_render& c) {
+	if(c.job && c.job->uploaded) {
+		c.handle = c.job->handle;
+		c.job.reset();
+	}
+	if(c.job)
+		c.job->cancelled = true;
+	else
+		atlas.release(c.handle);
+}
+
+// stand in for a render that is still in flight: the closest finished size with the same color, if there is one
+static atlas_region nearest_render(texture_atlas& atlas, ankerl::unordered_dense::map<uint64_t, cached_render>& renders, uint64_t idx) {
+	auto size_x = int64_t(idx & 0xFFFFF);
+	auto size_y = int64_t((idx >> 20) & 0xFFFFF);
+
+	atlas_region best{ };
+	int64_t best_distance = std::numeric_limits<int64_t>::max();
+	for(auto& r : renders) {
+		if(r.first == idx || (r.first >> 40) != (idx >> 40))
+			continue;
+		auto distance = std::abs(int64_t(r.first & 0xFFFFF) - size_x) + std::abs(int64_t((r.first >> 20) & 0xFFFFF) - size_y);
+		if(distance >= best_distance)
+			continue;
+		if(auto region = find_render(atlas, r.second); region) {
+			best = *region;
+			best_distance = distance;
+		}
+	}
+	return best;
 }
 
-void svg::release_renders() {
+void svg::release_renders(asvg::texture_atlas& atlas) {
+	for(auto& r : renders)
+		release_render(atlas, r.second);
 	renders.clear();
 }
 
-uint32_t svg::get_render(
+atlas_region svg::get_render(
 	simple_fs::file_system const& fs,
 	asvg::file_bank& svg_image_files,
+	asvg::texture_atlas& atlas,
+	asvg::render_queue& queue,
 	float size_x, float size_y,
 	int32_t grid_size, float scale,
 	float r, float g, float b
@@ -170,30 +668,36 @@ uint32_t svg::get_render(
 	uint64_t idx = uint64_t(uint32_t(size_x * grid_size * scale)) | (uint64_t(uint32_t(size_y * grid_size * scale)) << uint64_t(20)) | (colorid << 40);
 
 	if(auto it = renders.find(idx); it != renders.end()) {
-		return it->second.texture_handle;
+		if(auto region = find_render(atlas, it->second); region)
+			return *region;
+		if(it->second.job)
+			return nearest_render(atlas, renders, idx);
 	}
-	return make_new_render(fs, svg_image_files, size_x, size_y, grid_size, scale);
+	return make_new_render(fs, svg_image_files, atlas, queue, size_x, size_y, grid_size, scale, r, g, b);
 }
 
-uint32_t svg::try_get_render(float size_x, float size_y, int32_t grid_size, float r, float g, float b) {
+atlas_region svg::try_get_render(asvg::texture_atlas& atlas, float size_x, float size_y, int32_t grid_size, float r, float g, float b) {
 	uint64_t colorid = uint64_t(r * 255.0f) | (uint64_t(g * 255.0f) << uint64_t(8)) | (uint64_t(b * 255.0f) << uint64_t(16));
 	uint64_t idx = uint64_t(uint32_t(size_x * grid_size)) | (uint64_t(uint32_t(size_y * grid_size)) << uint64_t(20)) | (colorid << 40);
 
 	if(auto it = renders.find(idx); it != renders.end()) {
-		return it->second.texture_handle;
+		if(auto region = find_render(atlas, it->second); region)
+			return *region;
 	}
-	return 0;
+	return atlas_region{ };
 }
-uint32_t svg::make_new_render(
+atlas_region svg::make_new_render(
 	const simple_fs::file_system& fs,
 	asvg::file_bank& svg_image_files,
+	asvg::texture_atlas& atlas,
+	asvg::render_queue& queue,
 	float size_x, float size_y,
 	int32_t grid_size,
 	float scale,
 	float r, float g, float b
 ) {
 	if(svg_data.size() == 0)
-		return 0;
+		return atlas_region{ };
 
 	char temp_buffer[128] = { 0 };
 
@@ -204,7 +708,11 @@ uint32_t svg::make_new_render(
 	float d_scale = std::sqrt(x_scale * x_scale + y_scale * y_scale);
 	float p_scale = 500.0f / float(grid_size);
 
-	for(auto& reos : replacements) {
+	auto job = std::make_shared<render_job>();
+	std::vector<float> values(replacements.size());
+
+	for(size_t i = 0; i < replacements.size(); ++i) {
+		auto& reos = replacements[i];
 		float chosen_scale = x_scale;
 		switch(reos.dimension) {
 			case dimension_relative::height: chosen_scale = y_scale; break;
@@ -214,148 +722,121 @@ uint32_t svg::make_new_render(
 			case dimension_relative::diagonal: chosen_scale = d_scale; break;
 			case dimension_relative::pixel: chosen_scale = p_scale; break;
 		}
-		if(!reos.emit_quotes) {
-			auto result = std::to_chars(temp_buffer, temp_buffer + 128, chosen_scale * reos.scale + reos.offset);
-			memset(result.ptr, ' ', size_t((temp_buffer + 128) - result.ptr));
-			memcpy(svg_data.data() + reos.start_position, temp_buffer, size_t(std::min(reos.end_position - reos.start_position, uint32_t(128))));
-		} else {
-			auto result = std::to_chars(temp_buffer + 1, temp_buffer + 126, chosen_scale * reos.scale + reos.offset);
-			memset(result.ptr, ' ', size_t((temp_buffer + 128) - result.ptr));
-			*result.ptr = '\"';
-			temp_buffer[0] = '\"';
-			memcpy(svg_data.data() + reos.start_position, temp_buffer, size_t(std::min(reos.end_position - reos.start_position, uint32_t(128))));
-		}
+		values[i] = chosen_scale * reos.scale + reos.offset;
 	}
 
-	char cssstylesheet[] = ".primarycolor { fill: #000000; stroke: #000000; } ";
-	auto const clroffset = strlen(".primarycolor { fill: #");
-	auto const clroffset2 = strlen(".primarycolor { fill: #000000; stroke: #");
-	auto tohexdigit = [](uint32_t v) {
-		char table[] = "0123456789abcdef";
-		return table[v & 0x0F];
-	};
-	auto rv = uint32_t(r * 255.0f);
-	cssstylesheet[clroffset] = cssstylesheet[clroffset2] = tohexdigit(rv >> 4);
-	cssstylesheet[clroffset+1] = cssstylesheet[clroffset2 + 1] = tohexdigit(rv);
-	auto gv = uint32_t(g * 255.0f);
-	cssstylesheet[clroffset + 2] = cssstylesheet[clroffset2 + 2] = tohexdigit(gv >> 4);
-	cssstylesheet[clroffset + 3] = cssstylesheet[clroffset2 + 3] = tohexdigit(gv);
-	auto bv = uint32_t(b * 255.0f);
-	cssstylesheet[clroffset + 4] = cssstylesheet[clroffset2 + 4] = tohexdigit(bv >> 4);
-	cssstylesheet[clroffset + 5] = cssstylesheet[clroffset2 + 5] = tohexdigit(bv);
-
-	auto doc = lunasvg::Document::loadFromData(svg_data.data(), svg_data.size(), [&svg_image_files, &fs](std::string_view file_name) {
-		return svg_image_files.get_file_data(fs, file_name);
-	});
-
-	if(!doc) std::abort(); // TODO: error message
-	doc->applyStyleSheet(cssstylesheet);
-
-	lunasvg::Bitmap bmp(
-		int32_t(size_x * scale * grid_size),
-		int32_t(size_y * scale * grid_size));
-
-	doc->render(bmp, lunasvg::Matrix{ }.scale(scale * float(grid_size) / 500.0f, scale * float(grid_size) / 500.0f));
-
-	bmp.convertToRGBA();
-
-	svg_instance new_inst((char const*)(bmp.data()),
-		int32_t(size_x * scale * grid_size),
-		int32_t(size_y * scale * grid_size));
+	if(document) {
+		job->document = document;
+		job->primary_color = make_color(r, g, b);
+		for(auto& binding : bindings) {
+			std::string value = binding.literals[0];
+			for(size_t i = 0; i < binding.slots.size(); ++i) {
+				auto result = std::to_chars(temp_buffer, temp_buffer + 128, values[binding.slots[i]]);
+				value.append(temp_buffer, result.ptr);
+				value += binding.literals[i + 1];
+			}
+			job->attribute_values.push_back(std::move(value));
+		}
+	} else {
+		job->svg_data = svg_data;
+		job->stylesheet = make_stylesheet(r, g, b);
+		for(size_t i = 0; i < replacements.size(); ++i) {
+			auto& reos = replacements[i];
+			if(!reos.emit_quotes) {
+				auto result = std::to_chars(temp_buffer, temp_buffer + 128, values[i]);
+				memset(result.ptr, ' ', size_t((temp_buffer + 128) - result.ptr));
+				memcpy(job->svg_data.data() + reos.start_position, temp_buffer, size_t(std::min(reos.end_position - reos.start_position, uint32_t(128))));
+			} else {
+				auto result = std::to_chars(temp_buffer + 1, temp_buffer + 126, values[i]);
+				memset(result.ptr, ' ', size_t((temp_buffer + 128) - result.ptr));
+				*result.ptr = '\"';
+				temp_buffer[0] = '\"';
+				memcpy(job->svg_data.data() + reos.start_position, temp_buffer, size_t(std::min(reos.end_position - reos.start_position, uint32_t(128))));
+			}
+		}
+	}
 
-	auto h = new_inst.texture_handle;
+	job->size_x = int32_t(size_x * scale * grid_size);
+	job->size_y = int32_t(size_y * scale * grid_size);
+	job->render_scale = scale * float(grid_size) / 500.0f;
 
 	uint64_t colorid = uint64_t(r * 255.0f) | (uint64_t(g * 255.0f) << uint64_t(8)) | (uint64_t(b * 255.0f) << uint64_t(16));
 	uint64_t idx = uint64_t(uint32_t(size_x * grid_size * scale)) | (uint64_t(uint32_t(size_y * grid_size * scale)) << uint64_t(20)) | (colorid << 40);
-	renders[idx] = std::move(new_inst);
+	job->cache_key = make_cache_key(content_hash, idx, grid_size, scale);
+	renders[idx] = cached_render{ atlas_handle{ }, job };
+	queue.submit(fs, svg_image_files, std::move(job));
 
-	return h;
+	return nearest_render(atlas, renders, idx);
 }
 
 
 simple_svg::simple_svg(char const* data, size_t count) : svg_data(data, data + count) {
-
+	blake2b(&content_hash, sizeof(content_hash), data, count, nullptr, 0);
+	document = std::make_shared<parsed_document>();
+	document->data = svg_data;
 }
 
-void simple_svg::release_renders() {
+void simple_svg::release_renders(asvg::texture_atlas& atlas) {
+	for(auto& r : renders)
+		release_render(atlas, r.second);
 	renders.clear();
 }
 
-uint32_t simple_svg::get_render(
+atlas_region simple_svg::get_render(
 	const simple_fs::file_system& fs,
 	asvg::file_bank& svg_image_files,
+	asvg::texture_atlas& atlas,
+	asvg::render_queue& queue,
 	int32_t size_x, int32_t size_y, float scale, float r, float g, float b
 ) {
 	uint64_t colorid = uint64_t(r * 255.0f) | (uint64_t(g * 255.0f) << uint64_t(8)) | (uint64_t(b * 255.0f) << uint64_t(16));
 	uint64_t idx = uint64_t(uint32_t(size_x)) | (uint64_t(uint32_t(size_y)) << uint64_t(20)) | (colorid << 40);
 
 	if(auto it = renders.find(idx); it != renders.end()) {
-		return it->second.texture_handle;
+		if(auto region = find_render(atlas, it->second); region)
+			return *region;
+		if(it->second.job)
+			return nearest_render(atlas, renders, idx);
 	}
-	return make_new_render(fs, svg_image_files, size_x, size_y, scale, r, g, b);
+	return make_new_render(fs, svg_image_files, atlas, queue, size_x, size_y, scale, r, g, b);
 }
-uint32_t simple_svg::try_get_render(int32_t size_x, int32_t size_y, float r, float g, float b) {
+atlas_region simple_svg::try_get_render(asvg::texture_atlas& atlas, int32_t size_x, int32_t size_y, float r, float g, float b) {
 	uint64_t colorid = uint64_t(r * 255.0f) | (uint64_t(g * 255.0f) << uint64_t(8)) | (uint64_t(b * 255.0f) << uint64_t(16));
 	uint64_t idx = uint64_t(uint32_t(size_x)) | (uint64_t(uint32_t(size_y)) << uint64_t(20)) | (colorid << 40);
 
 	if(auto it = renders.find(idx); it != renders.end()) {
-		return it->second.texture_handle;
+		if(auto region = find_render(atlas, it->second); region)
+			return *region;
 	}
-	return 0;
+	return atlas_region{ };
 }
-uint32_t simple_svg::make_new_render(
+atlas_region simple_svg::make_new_render(
 	const simple_fs::file_system& fs,
 	asvg::file_bank& svg_image_files,
+	asvg::texture_atlas& atlas,
+	asvg::render_queue& queue,
 	int32_t size_x, int32_t size_y, float scale, float r, float g, float b
 ) {
 	if(svg_data.size() == 0)
-		return 0;
-
-	char cssstylesheet[] = ".primarycolor { fill: #000000; stroke: #000000; } ";
-	auto const clroffset = strlen(".primarycolor { fill: #");
-	auto const clroffset2 = strlen(".primarycolor { fill: #000000; stroke: #");
-	auto tohexdigit = [](uint32_t v) {
-		char table[] = "0123456789abcdef";
-		return table[v & 0x0F];
-	};
-	auto rv = uint32_t(r * 255.0f);
-	cssstylesheet[clroffset] = cssstylesheet[clroffset2] = tohexdigit(rv >> 4);
-	cssstylesheet[clroffset + 1] = cssstylesheet[clroffset2 + 1] = tohexdigit(rv);
-	auto gv = uint32_t(g * 255.0f);
-	cssstylesheet[clroffset + 2] = cssstylesheet[clroffset2 + 2] = tohexdigit(gv >> 4);
-	cssstylesheet[clroffset + 3] = cssstylesheet[clroffset2 + 3] = tohexdigit(gv);
-	auto bv = uint32_t(b * 255.0f);
-	cssstylesheet[clroffset + 4] = cssstylesheet[clroffset2 + 4] = tohexdigit(bv >> 4);
-	cssstylesheet[clroffset + 5] = cssstylesheet[clroffset2 + 5] = tohexdigit(bv);
-
-	auto doc = lunasvg::Document::loadFromData(svg_data.data(), svg_data.size(), [&svg_image_files, &fs](std::string_view file_name) {
-		return svg_image_files.get_file_data(fs, file_name);
-	});
-
-	if(!doc) std::abort(); // TODO: error message
-	doc->applyStyleSheet(cssstylesheet);
-
-	lunasvg::Bitmap bmp(
-		int32_t(size_x * scale),
-		int32_t(size_y * scale));
-
-	doc->render(bmp, lunasvg::Matrix{ }.scale(scale * size_x / float(doc->width()), scale * size_y / float(doc->height())));
-	bmp.convertToRGBA();
-
-	svg_instance new_inst((char const*)(bmp.data()),
-		int32_t(size_x * scale),
-		int32_t(size_y * scale));
+		return atlas_region{ };
 
-	auto h = new_inst.texture_handle;
+	auto job = std::make_shared<render_job>();
+	job->document = document;
+	job->primary_color = make_color(r, g, b);
+	job->size_x = int32_t(size_x * scale);
+	job->size_y = int32_t(size_y * scale);
 
 	uint64_t colorid = uint64_t(r * 255.0f) | (uint64_t(g * 255.0f) << uint64_t(8)) | (uint64_t(b * 255.0f) << uint64_t(16));
 	uint64_t idx = uint64_t(uint32_t(size_x)) | (uint64_t(uint32_t(size_y)) << uint64_t(20)) | (colorid << 40);
-	renders[idx] = std::move(new_inst);
+	job->cache_key = make_cache_key(content_hash, idx, 0, scale);
+	renders[idx] = cached_render{ atlas_handle{ }, job };
+	queue.submit(fs, svg_image_files, std::move(job));
 
-	return h;
+	return nearest_render(atlas, renders, idx);
 }
 
 std::pair<void const*, int> file_bank::get_file_data(simple_fs::file_system const& common_fs, std::string_view file_name) {
+	std::lock_guard lock(access);
 	if(auto it = file_contents.find(file_name); it != file_contents.end()) {
 		return std::pair<void const*, int>{(void const*)(it->second.data()), int(it->second.size()) };
 	} else {
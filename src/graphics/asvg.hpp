@@ -1,24 +1,82 @@
 #pragma once
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <limits>
 #include "unordered_dense.h"
 #include "simple_fs.hpp"
+#include "oneapi/tbb/task_group.h"
+#include "oneapi/tbb/concurrent_queue.h"
 
 namespace asvg {
 
-class svg_instance {
-public:
+// location of a render inside one of the atlas pages, in texture coordinates
+struct atlas_region {
 	uint32_t texture_handle = 0;
-	svg_instance() { }
-	svg_instance(char const* bytes, int32_t sx, int32_t sy);
-	svg_instance(svg_instance&& other) noexcept;
-	svg_instance(svg_instance const& other) noexcept {
-		std::abort();
-	}
-	svg_instance& operator=(svg_instance&& other) noexcept;
-	svg_instance& operator=(svg_instance const& other) noexcept {
-		std::abort();
+	float x = 0.0f; // x offset
+	float width = 0.0f; // x width
+	float y = 0.0f; // y offset
+	float height = 0.0f; // y height
+};
+
+struct atlas_handle {
+	uint32_t slot = std::numeric_limits<uint32_t>::max();
+	uint32_t generation = 0;
+};
+
+// renders are packed into shelves of large GL_RGBA8 pages; when every page is full, the page that
+// was used least recently has all of its entries evicted and is packed again from the top
+// a page drawn from in the current frame is never evicted, so a frame that needs more than max_pages
+// pages briefly gets extra ones; new_frame deletes those again once they go unused
+class texture_atlas {
+public:
+	static constexpr int32_t page_size = 2048;
+	static constexpr int32_t padding = 1;
+	static constexpr uint32_t max_pages = 8;
+
+	struct shelf {
+		int32_t y = 0;
+		int32_t height = 0;
+		int32_t x = 0;
+	};
+	struct page {
+		std::vector<shelf> shelves;
+		uint32_t texture_handle = 0;
+		uint32_t last_used = 0;
+		int32_t live_entries = 0;
+		bool oversized = false; // holds a single render that doesn't fit in a regular page
+	};
+	struct slot {
+		atlas_region region;
+		uint32_t page = 0;
+		uint32_t generation = 0;
+		bool live = false;
+	};
+
+	std::vector<page> pages;
+	std::vector<slot> slots;
+	std::vector<uint32_t> free_slots;
+	uint32_t frame = 0;
+	uint32_t evictions = 0; // pages repacked or deleted so far; quads recorded before then may point at reused space
+
+	texture_atlas() { }
+	texture_atlas(texture_atlas const& other) = delete;
+	texture_atlas& operator=(texture_atlas const& other) = delete;
+	~texture_atlas();
+
+	atlas_handle add(char const* bgra, int32_t sx, int32_t sy); // premultiplied, as rasterized by lunasvg
+	atlas_region const* find(atlas_handle h); // nullptr if the entry was evicted
+	void release(atlas_handle h);
+	void new_frame();
+	uint32_t page_of(uint32_t texture_handle) const; // index of the page with this texture, or pages.size() if none has it
+	void touch(uint32_t page_index) { // for quads drawn from a page without going through find, such as replayed ones
+		pages[page_index].last_used = frame;
 	}
-	~svg_instance() noexcept;
+private:
+	uint32_t make_page(int32_t sx, int32_t sy, bool oversized);
+	bool place(page& p, int32_t sx, int32_t sy, int32_t& x, int32_t& y);
+	void evict_page(uint32_t p, bool reuse); // the texture is cleared for reuse, or deleted
 };
 
 enum class dimension_relative : uint8_t {
@@ -38,14 +96,68 @@ class file_bank {
 public:
 	native_string root_directory;
 	ankerl::unordered_dense::map<std::string_view, std::vector<char>> file_contents;
+	std::mutex access; // documents are parsed on the worker threads
 	std::pair<void const*, int> get_file_data(simple_fs::file_system const& common_fs, std::string_view file_name);
 };
 
+// the document is parsed once, on the first render, and kept alive in parsed_document; later renders only
+// rewrite the bound attributes and the primary color and lay it out again
+struct parsed_document;
+
+// an attribute whose value contains replacements: literals[0] slot[0] literals[1] ... literals[n]
+struct attribute_binding {
+	std::vector<std::string> literals;
+	std::vector<uint32_t> slots; // indices into svg::replacements
+};
+
+// a render that is rasterized on a worker thread; the pixels are handed back to the
+// GL thread through render_queue::completed and uploaded into the atlas there
+struct render_job {
+	std::shared_ptr<parsed_document> document;
+	std::vector<std::string> attribute_values; // one per binding
+	std::string primary_color;
+	std::vector<char> svg_data; // when the document couldn't be bound: copy with the replacements already applied
+	std::string stylesheet;
+	std::vector<uint8_t> pixels;
+	atlas_handle handle;
+	uint64_t cache_key = 0; // name of the rasterized bitmap in the disk cache
+	int32_t size_x = 0;
+	int32_t size_y = 0;
+	float render_scale = 0.0f; // 0 scales the document to fill the render
+	bool uploaded = false;
+	bool cancelled = false; // the render was released before it finished
+};
+
+struct cached_render {
+	atlas_handle handle;
+	std::shared_ptr<render_job> job; // set while the render is still in flight
+};
+
+constexpr inline uint64_t render_cache_size_limit = uint64_t(256) * 1024 * 1024; // the least recently used cached renders beyond this are deleted at startup
+
+class render_queue {
+public:
+	tbb::task_group workers;
+	tbb::concurrent_queue<std::shared_ptr<render_job>> completed;
+	std::optional<simple_fs::directory> cache_directory; // finished renders are stored here and looked up before rasterizing
+
+	render_queue() { }
+	render_queue(render_queue const& other) = delete;
+	render_queue& operator=(render_queue const& other) = delete;
+	~render_queue();
+
+	void submit(simple_fs::file_system const& fs, asvg::file_bank& svg_image_files, std::shared_ptr<render_job> job);
+	bool upload_completed(texture_atlas& atlas); // GL thread only; true when anything was uploaded
+};
+
 class svg {
 public:
-	ankerl::unordered_dense::map<uint64_t, svg_instance> renders;
+	ankerl::unordered_dense::map<uint64_t, cached_render> renders;
 	std::vector<char> svg_data;
 	std::vector<affine_replacement> replacements;
+	std::vector<attribute_binding> bindings;
+	std::shared_ptr<parsed_document> document; // null if some replacement isn't inside an attribute
+	uint64_t content_hash = 0;
 	int32_t base_width = 1;
 	int32_t base_height = 1;
 public:
@@ -54,44 +166,54 @@ public:
 	svg(svg&& other) noexcept = default;
 	svg& operator=(svg&& other) noexcept = default;
 
-	uint32_t make_new_render(
+	void bind_replacements();
+
+	atlas_region make_new_render(
 		simple_fs::file_system const& fs,
 		asvg::file_bank& svg_image_files,
+		asvg::texture_atlas& atlas,
+		asvg::render_queue& queue,
 		float size_x, float size_y, int32_t grid_size, float scale,
 		float r = 0.0f, float g = 0.0f, float b = 0.0f
 	);
-	void release_renders();
-	uint32_t get_render(
+	void release_renders(asvg::texture_atlas& atlas);
+	atlas_region get_render(
 		simple_fs::file_system const& fs,
 		asvg::file_bank& svg_image_files,
+		asvg::texture_atlas& atlas,
+		asvg::render_queue& queue,
 		float size_x, float size_y, int32_t grid_size, float scale,
 		float r = 0.0f, float g = 0.0f, float b = 0.0f
 	);
-	uint32_t try_get_render(float size_x, float size_y, int32_t grid_size, float r = 0.0f, float g = 0.0f, float b = 0.0f);
+	atlas_region try_get_render(asvg::texture_atlas& atlas, float size_x, float size_y, int32_t grid_size, float r = 0.0f, float g = 0.0f, float b = 0.0f);
 };
 
 class simple_svg {
 public:
-	ankerl::unordered_dense::map<uint64_t, svg_instance> renders;
+	ankerl::unordered_dense::map<uint64_t, cached_render> renders;
 	std::vector<char> svg_data;
+	std::shared_ptr<parsed_document> document;
+	uint64_t content_hash = 0;
 public:
 	simple_svg() {
 	}
 	simple_svg(char const* data, size_t count);
 	simple_svg(simple_svg&& other) noexcept = default;
 	simple_svg& operator=(simple_svg&& other) noexcept = default;
-	uint32_t make_new_render(
+	atlas_region make_new_render(
 		simple_fs::file_system const& fs,
 		asvg::file_bank& svg_image_files,
+		asvg::texture_atlas& atlas,
+		asvg::render_queue& queue,
 		int32_t size_x, int32_t size_y, float scale, float r = 0.0f, float g = 0.0f, float b = 0.0f
 	);
-	void release_renders();
-	uint32_t get_render(
+	void release_renders(asvg::texture_atlas& atlas);
+	atlas_region get_render(
 		const simple_fs::file_system& fs,
-		asvg::file_bank& svg_image_files, int32_t size_x, int32_t size_y, float scale,
+		asvg::file_bank& svg_image_files, asvg::texture_atlas& atlas, asvg::render_queue& queue, int32_t size_x, int32_t size_y, float scale,
 		float r = 0.0f, float g = 0.0f, float b = 0.0f
 	);
-	uint32_t try_get_render(int32_t size_x, int32_t size_y, float r = 0.0f, float g = 0.0f, float b = 0.0f);
+	atlas_region try_get_render(asvg::texture_atlas& atlas, int32_t size_x, int32_t size_y, float r = 0.0f, float g = 0.0f, float b = 0.0f);
 };
 
 
@@ -1,6 +1,7 @@
 #include "opengl_wrapper.hpp"
 #include "simple_fs.hpp"
 #include "fonts.hpp"
+#include "asvg.hpp"
 
 #include "constants.hpp"
 #include "window.hpp"
@@ -504,6 +505,7 @@ void load_shaders(ogl::data& state, simple_fs::file_system& fs) {
 
 		state.ui_shader_texture_sampler_uniform = glGetUniformLocation(state.ui_shader_program, "texture_sampler");
 		state.ui_shader_secondary_texture_sampler_uniform = glGetUniformLocation(state.ui_shader_program, "secondary_texture_sampler");
+		state.ui_shader_glyph_sampler_uniform = glGetUniformLocation(state.ui_shader_program, "glyph_sampler");
 		state.ui_shader_screen_width_uniform = glGetUniformLocation(state.ui_shader_program, "screen_width");
 		state.ui_shader_screen_height_uniform = glGetUniformLocation(state.ui_shader_program, "screen_height");
 		state.ui_shader_gamma_uniform = glGetUniformLocation(state.ui_shader_program, "gamma");
@@ -513,6 +515,7 @@ void load_shaders(ogl::data& state, simple_fs::file_system& fs) {
 		state.ui_shader_inner_color_uniform = glGetUniformLocation(state.ui_shader_program, "inner_color");
 		state.ui_shader_subrect_uniform = glGetUniformLocation(state.ui_shader_program, "subrect");
 		state.ui_shader_border_size_uniform = glGetUniformLocation(state.ui_shader_program, "border_size");
+		state.ui_shader_instanced_uniform = glGetUniformLocation(state.ui_shader_program, "instanced");
 	} else {
 		notify_user_of_fatal_opengl_error("Unable to open a necessary shader file");
 	}
@@ -580,6 +583,168 @@ void load_global_squares(ogl::data& state) {
 	glGenBuffers(1, &state.global_rtl_square_flipped_buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, state.global_rtl_square_flipped_buffer);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 16, global_rtl_square_flipped_data, GL_STATIC_DRAW);
+
+	// every square maps the unit square to texture coordinates by an affine transform
+	// recover it from the corners, so that a batched quad can carry its orientation as instance data
+	GLfloat const* squares[12] = {
+		global_square_data, global_rtl_square_data,
+		global_square_flipped_data, global_rtl_square_flipped_data,
+		global_square_left_data, global_rtl_square_left_data,
+		global_square_left_flipped_data, global_rtl_square_left_flipped_data,
+		global_square_right_data, global_rtl_square_right_data,
+		global_square_right_flipped_data, global_rtl_square_right_flipped_data
+	};
+	for(uint32_t i = 0; i < 12; ++i) {
+		float origin[2] = { 0.f, 0.f };
+		float x_corner[2] = { 0.f, 0.f };
+		float y_corner[2] = { 0.f, 0.f };
+		for(uint32_t v = 0; v < 4; ++v) {
+			auto vertex = squares[i] + v * 4;
+			if(vertex[0] == 0.f && vertex[1] == 0.f) {
+				origin[0] = vertex[2];
+				origin[1] = vertex[3];
+			} else if(vertex[0] == 1.f && vertex[1] == 0.f) {
+				x_corner[0] = vertex[2];
+				x_corner[1] = vertex[3];
+			} else if(vertex[0] == 0.f && vertex[1] == 1.f) {
+				y_corner[0] = vertex[2];
+				y_corner[1] = vertex[3];
+			}
+		}
+		auto& t = state.ui_batch.square_transforms[i];
+		t[0] = x_corner[0] - origin[0];
+		t[1] = x_corner[1] - origin[1];
+		t[2] = y_corner[0] - origin[0];
+		t[3] = y_corner[1] - origin[1];
+		t[4] = origin[0];
+		t[5] = origin[1];
+	}
+
+	// Populate the quad batch
+	GLsizeiptr batch_size = GLsizeiptr(sizeof(quad_instance) * quad_batch::quads_per_segment * quad_batch::segment_count);
+	glGenBuffers(1, &state.ui_batch.instance_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, state.ui_batch.instance_buffer);
+	glBufferStorage(GL_ARRAY_BUFFER, batch_size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+	state.ui_batch.mapped = static_cast<quad_instance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, batch_size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+	if(!state.ui_batch.mapped) {
+		notify_user_of_fatal_opengl_error("Unable to map the ui quad buffer");
+	}
+
+	glGenVertexArrays(1, &state.ui_batch.vao);
+	glBindVertexArray(state.ui_batch.vao);
+	for(GLuint i = 0; i < 9; ++i)
+		glEnableVertexAttribArray(i);
+
+	glBindVertexBuffer(0, state.global_square_buffer, 0, sizeof(GLfloat) * 4);
+	glBindVertexBuffer(1, state.ui_batch.instance_buffer, 0, sizeof(quad_instance));
+	glVertexBindingDivisor(1, 1); // one quad_instance per instance
+
+	glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, 0); // position
+	glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 2); // texture coordinates
+	glVertexAttribFormat(2, 4, GL_FLOAT, GL_FALSE, offsetof(quad_instance, d_rect));
+	glVertexAttribFormat(3, 4, GL_FLOAT, GL_FALSE, offsetof(quad_instance, subrect));
+	glVertexAttribFormat(4, 4, GL_FLOAT, GL_FALSE, offsetof(quad_instance, inner_color)); // inner color + border size
+	glVertexAttribFormat(5, 4, GL_FLOAT, GL_FALSE, offsetof(quad_instance, tex_transform));
+	glVertexAttribFormat(6, 2, GL_FLOAT, GL_FALSE, offsetof(quad_instance, tex_offset));
+	glVertexAttribIFormat(7, 2, GL_UNSIGNED_INT, offsetof(quad_instance, subroutines));
+	glVertexAttribIFormat(8, 1, GL_UNSIGNED_INT, offsetof(quad_instance, layer));
+	glVertexAttribBinding(0, 0);
+	glVertexAttribBinding(1, 0);
+	for(GLuint i = 2; i < 9; ++i)
+		glVertexAttribBinding(i, 1);
+
+	glBindVertexArray(0);
+}
+
+uint32_t square_index(ui::rotation r, bool flipped, bool rtl) {
+	return (uint32_t(r) >> ui::rotation_bit_offset) * 4 + (flipped ? 2 : 0) + (rtl ? 1 : 0);
+}
+
+quad_instance make_quad(ogl::data const& state, float x, float y, float width, float height, GLuint color_subroutine, GLuint font_subroutine, ui::rotation r, bool flipped, bool rtl) {
+	quad_instance q;
+	q.d_rect[0] = x;
+	q.d_rect[1] = y;
+	q.d_rect[2] = width;
+	q.d_rect[3] = height;
+	auto& t = state.ui_batch.square_transforms[square_index(r, flipped, rtl)];
+	q.tex_transform[0] = t[0];
+	q.tex_transform[1] = t[1];
+	q.tex_transform[2] = t[2];
+	q.tex_transform[3] = t[3];
+	q.tex_offset[0] = t[4];
+	q.tex_offset[1] = t[5];
+	q.subroutines[0] = color_subroutine;
+	q.subroutines[1] = font_subroutine;
+	return q;
+}
+
+void advance_batch_segment(quad_batch& b) {
+	b.fences[b.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	b.segment = (b.segment + 1) % quad_batch::segment_count;
+	if(b.fences[b.segment]) {
+		// the gpu may still be reading the segment we are about to overwrite
+		glClientWaitSync(b.fences[b.segment], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+		glDeleteSync(b.fences[b.segment]);
+		b.fences[b.segment] = nullptr;
+	}
+	b.used = 0;
+	b.first_pending = 0;
+}
+
+void flush_quads(ogl::data const& state) {
+	auto& b = state.ui_batch;
+	if(b.used == b.first_pending)
+		return;
+
+	glBindVertexArray(b.vao);
+	if(b.glyph_texture) {
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, b.glyph_texture);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, b.texture);
+	glUniform1ui(state.ui_shader_instanced_uniform, 1);
+	glDrawArraysInstancedBaseInstance(GL_TRIANGLE_FAN, 0, 4, GLsizei(b.used - b.first_pending), b.segment * quad_batch::quads_per_segment + b.first_pending);
+	glUniform1ui(state.ui_shader_instanced_uniform, 0);
+	b.first_pending = b.used;
+}
+
+void queue_quad(ogl::data const& state, GLuint texture_handle, quad_instance const& q) {
+	auto& b = state.ui_batch;
+	if(b.used == quad_batch::quads_per_segment) {
+		flush_quads(state);
+		advance_batch_segment(b);
+	}
+	// quads without a texture can join any run, and a run of them can adopt the next texture
+	if(texture_handle != 0 && texture_handle != b.texture) {
+		if(b.texture != 0)
+			flush_quads(state);
+		b.texture = texture_handle;
+	}
+	b.mapped[b.segment * quad_batch::quads_per_segment + b.used] = q;
+	++b.used;
+	if(b.recording)
+		b.recording->push_back(recorded_quad{ q, texture_handle });
+}
+
+void begin_direct_draw(ogl::data const& state) {
+	flush_quads(state);
+	state.ui_batch.recording_complete = false;
+}
+
+void mark_animated(ogl::data const& state) {
+	state.ui_batch.recording_complete = false;
+}
+
+void replay_quads(ogl::data const& state, std::span<recorded_quad const> quads) {
+	for(auto& r : quads)
+		queue_quad(state, r.texture, r.quad);
+}
+
+void end_ui_batch(ogl::data& state) {
+	flush_quads(state);
+	advance_batch_segment(state.ui_batch);
+	state.ui_batch.texture = 0;
 }
 
 void bind_vertices_by_rotation(ogl::data const& state, ui::rotation r, bool flipped, bool rtl) {
@@ -618,15 +783,11 @@ void render_colored_rect(
 	float red, float green, float blue,
 	ui::rotation r, bool flipped, bool rtl
 ) {
-	glBindVertexArray(state.global_square_vao);
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	GLuint subroutines[2] = { map_color_modification_to_index(color_modification::none), parameters::solid_color };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	glUniform3f(state.ui_shader_inner_color_uniform, red, green, blue);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-	glLineWidth(2.0f);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, map_color_modification_to_index(color_modification::none), parameters::solid_color, r, flipped, rtl);
+	q.inner_color[0] = red;
+	q.inner_color[1] = green;
+	q.inner_color[2] = blue;
+	queue_quad(state, 0, q);
 }
 
 void render_alpha_colored_rect(
@@ -634,16 +795,12 @@ void render_alpha_colored_rect(
 	float x, float y, float width, float height,
 	float red, float green, float blue, float alpha
 ) {
-	glBindVertexArray(state.global_square_vao);
-	glBindVertexBuffer(0, state.global_square_buffer, 0, sizeof(GLfloat) * 4);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	GLuint subroutines[2] = { map_color_modification_to_index(color_modification::none), parameters::alpha_color };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	glUniform3f(state.ui_shader_inner_color_uniform, red, green, blue);
-	glUniform1f(state.ui_shader_border_size_uniform, alpha);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-	glLineWidth(2.0f);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, map_color_modification_to_index(color_modification::none), parameters::alpha_color, ui::rotation::upright, false, false);
+	q.inner_color[0] = red;
+	q.inner_color[1] = green;
+	q.inner_color[2] = blue;
+	q.border_size = alpha;
+	queue_quad(state, 0, q);
 }
 
 void render_simple_rect(ogl::data const& state, float x, float y, float width, float height, ui::rotation r, bool flipped, bool rtl) {
@@ -654,38 +811,24 @@ void render_simple_rect(ogl::data const& state, float x, float y, float width, f
 
 void render_textured_rect(ogl::data const& state, color_modification enabled, float x, float y, float width, float height,
 		GLuint texture_handle, ui::rotation r, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	// glUniform4f(state.ui_shader_d_rect_uniform, 0, 0, width, height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	GLuint subroutines[2] = {map_color_modification_to_index(enabled), parameters::no_filter};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	queue_quad(state, texture_handle, make_quad(state, x, y, width, height, map_color_modification_to_index(enabled), parameters::no_filter, r, flipped, rtl));
 }
 
 void render_textured_rect_direct(ogl::data const& state, float x, float y, float width, float height, uint32_t handle) {
-	glBindVertexArray(state.global_square_vao);
-
-	glBindVertexBuffer(0, state.global_square_buffer, 0, sizeof(GLfloat) * 4);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, handle);
-
-	GLuint subroutines[2] = {parameters::enabled, parameters::no_filter};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
+	queue_quad(state, handle, make_quad(state, x, y, width, height, parameters::enabled, parameters::no_filter, ui::rotation::upright, false, false));
+}
 
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+void render_textured_rect_direct(ogl::data const& state, float x, float y, float width, float height, asvg::atlas_region const& region) {
+	if(region.texture_handle == 0) { // still being rasterized
+		state.ui_batch.recording_complete = false;
+		return;
+	}
+	auto q = make_quad(state, x, y, width, height, parameters::enabled, parameters::atlas_sprite, ui::rotation::upright, false, false);
+	q.subrect[0] = region.x;
+	q.subrect[1] = region.width;
+	q.subrect[2] = region.y;
+	q.subrect[3] = region.height;
+	queue_quad(state, region.texture_handle, q);
 }
 
 void render_ui_mesh(
@@ -696,6 +839,8 @@ void render_ui_mesh(
 	generic_ui_mesh_triangle_strip& mesh,
 	data_texture& t
 ) {
+	begin_direct_draw(state);
+
 	glBindVertexArray(state.global_square_vao);
 
 	mesh.bind_buffer();
@@ -712,6 +857,8 @@ void render_ui_mesh(
 
 void render_linegraph(ogl::data const& state, color_modification enabled, float x, float y, float width, float height,
 		lines& l) {
+	begin_direct_draw(state);
+
 	glBindVertexArray(state.global_square_vao);
 
 	l.bind_buffer();
@@ -730,6 +877,8 @@ void render_linegraph(ogl::data const& state, color_modification enabled, float
 
 void render_linegraph(ogl::data const& state, color_modification enabled, float x, float y, float width, float height, float r, float g, float b,
 		lines& l) {
+	begin_direct_draw(state);
+
 	glBindVertexArray(state.global_square_vao);
 
 	l.bind_buffer();
@@ -750,6 +899,8 @@ void render_linegraph(
 	float x, float y, float width, float height, float r, float g, float b, float a, lines& l,
 	float ui_scale
 ) {
+	begin_direct_draw(state);
+
 	glBindVertexArray(state.global_square_vao);
 
 	l.bind_buffer();
@@ -768,102 +919,41 @@ void render_linegraph(
 
 void render_barchart(ogl::data const& state, color_modification enabled, float x, float y, float width, float height,
 		data_texture& t, ui::rotation r, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, t.handle());
-
-	GLuint subroutines[2] = {map_color_modification_to_index(enabled), parameters::barchart};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	queue_quad(state, t.handle(), make_quad(state, x, y, width, height, map_color_modification_to_index(enabled), parameters::barchart, r, flipped, rtl));
 }
 
 void render_piechart(ogl::data const& state, color_modification enabled, float x, float y, float size, data_texture& t) {
-	glBindVertexArray(state.global_square_vao);
-
-	glBindVertexBuffer(0, state.global_square_buffer, 0, sizeof(GLfloat) * 4);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, size, size);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, t.handle());
-
-	GLuint subroutines[2] = {map_color_modification_to_index(enabled), parameters::piechart};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	queue_quad(state, t.handle(), make_quad(state, x, y, size, size, map_color_modification_to_index(enabled), parameters::piechart, ui::rotation::upright, false, false));
 }
 void render_stripchart(ogl::data const& state, color_modification enabled, float x, float y, float sizex, float sizey, data_texture& t) {
-	glBindVertexArray(state.global_square_vao);
-
-	glBindVertexBuffer(0, state.global_square_buffer, 0, sizeof(GLfloat) * 4);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, sizex, sizey);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, t.handle());
-
-	GLuint subroutines[2] = { map_color_modification_to_index(enabled), parameters::stripchart };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	queue_quad(state, t.handle(), make_quad(state, x, y, sizex, sizey, map_color_modification_to_index(enabled), parameters::stripchart, ui::rotation::upright, false, false));
 }
 void render_bordered_rect(ogl::data const& state, color_modification enabled, float border_size, float x, float y, float width,
 		float height, GLuint texture_handle, ui::rotation r, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	glUniform1f(state.ui_shader_border_size_uniform, border_size);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	GLuint subroutines[2] = {map_color_modification_to_index(enabled), parameters::frame_stretch};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, map_color_modification_to_index(enabled), parameters::frame_stretch, r, flipped, rtl);
+	q.border_size = border_size;
+	queue_quad(state, texture_handle, q);
 }
 
 
 void render_rect_with_repeated_border(ogl::data const& state, color_modification enabled, float grid_size, float x, float y, float width,
 		float height, GLuint texture_handle, ui::rotation r, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	glUniform1f(state.ui_shader_border_size_uniform, grid_size);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-	GLuint subroutines[2] = { map_color_modification_to_index(enabled), parameters::border_repeat };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, map_color_modification_to_index(enabled), parameters::border_repeat, r, flipped, rtl);
+	q.border_size = grid_size;
+	queue_quad(state, texture_handle, q);
 }
 
 void render_rect_with_repeated_corner(ogl::data const& state, color_modification enabled, float grid_size, float x, float y, float width,
 		float height, GLuint texture_handle, ui::rotation r, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	glUniform1f(state.ui_shader_border_size_uniform, grid_size);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-	GLuint subroutines[2] = { map_color_modification_to_index(enabled), parameters::corner_repeat };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, map_color_modification_to_index(enabled), parameters::corner_repeat, r, flipped, rtl);
+	q.border_size = grid_size;
+	queue_quad(state, texture_handle, q);
 }
 
 void render_masked_rect(ogl::data const& state, color_modification enabled, float x, float y, float width, float height,
 		GLuint texture_handle, GLuint mask_texture_handle, ui::rotation r, bool flipped, bool rtl) {
+	begin_direct_draw(state);
+
 	glBindVertexArray(state.global_square_vao);
 
 	bind_vertices_by_rotation(state, r, flipped, rtl);
@@ -884,6 +974,8 @@ void render_masked_rect(ogl::data const& state, color_modification enabled, floa
 
 void render_progress_bar(ogl::data const& state, color_modification enabled, float progress, float x, float y, float width,
 		float height, GLuint left_texture_handle, GLuint right_texture_handle, ui::rotation r, bool flipped, bool rtl) {
+	begin_direct_draw(state);
+
 	glBindVertexArray(state.global_square_vao);
 
 	bind_vertices_by_rotation(state, r, flipped, rtl);
@@ -905,21 +997,11 @@ void render_progress_bar(ogl::data const& state, color_modification enabled, flo
 
 void render_tinted_textured_rect(ogl::data const& state, float x, float y, float width, float height, float r, float g, float b,
 		GLuint texture_handle, ui::rotation rot, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, rot, flipped, rtl);
-
-	glUniform3f(state.ui_shader_inner_color_uniform, r, g, b);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	GLuint subroutines[2] = {parameters::tint, parameters::no_filter};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, parameters::tint, parameters::no_filter, rot, flipped, rtl);
+	q.inner_color[0] = r;
+	q.inner_color[1] = g;
+	q.inner_color[2] = b;
+	queue_quad(state, texture_handle, q);
 }
 
 void render_tinted_rect(
@@ -928,72 +1010,52 @@ void render_tinted_rect(
 	float r, float g, float b,
 	ui::rotation rot, bool flipped, bool rtl
 ) {
-	glBindVertexArray(state.global_square_vao);
-	bind_vertices_by_rotation(state, rot, flipped, rtl);
-	glUniform3f(state.ui_shader_inner_color_uniform, r, g, b);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-	GLuint subroutines[2] = { parameters::tint, parameters::transparent_color };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, parameters::tint, parameters::transparent_color, rot, flipped, rtl);
+	q.inner_color[0] = r;
+	q.inner_color[1] = g;
+	q.inner_color[2] = b;
+	queue_quad(state, 0, q);
 }
 
 void render_tinted_subsprite(ogl::data const& state, int frame, int total_frames, float x, float y,
 		float width, float height, float r, float g, float b, GLuint texture_handle, ui::rotation rot, bool flipped,
 		bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, rot, flipped, rtl);
-
 	auto const scale = 1.0f / static_cast<float>(total_frames);
-	glUniform3f(state.ui_shader_inner_color_uniform, static_cast<float>(frame) * scale, scale, 0.0f);
-	glUniform4f(state.ui_shader_subrect_uniform, r, g, b, 0);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	GLuint subroutines[2] = { parameters::alternate_tint, parameters::sub_sprite };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, parameters::alternate_tint, parameters::sub_sprite, rot, flipped, rtl);
+	q.inner_color[0] = static_cast<float>(frame) * scale;
+	q.inner_color[1] = scale;
+	q.subrect[0] = r;
+	q.subrect[1] = g;
+	q.subrect[2] = b;
+	queue_quad(state, texture_handle, q);
 }
 
 void render_subsprite(ogl::data const& state, color_modification enabled, int frame, int total_frames, float x, float y,
 		float width, float height, GLuint texture_handle, ui::rotation r, bool flipped, bool rtl) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, r, flipped, rtl);
-
 	auto const scale = 1.0f / static_cast<float>(total_frames);
-	glUniform3f(state.ui_shader_inner_color_uniform, static_cast<float>(frame) * scale, scale, 0.0f);
-	glUniform4f(state.ui_shader_d_rect_uniform, x, y, width, height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	GLuint subroutines[2] = {map_color_modification_to_index(enabled), parameters::sub_sprite};
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
-
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, x, y, width, height, map_color_modification_to_index(enabled), parameters::sub_sprite, r, flipped, rtl);
+	q.inner_color[0] = static_cast<float>(frame) * scale;
+	q.inner_color[1] = scale;
+	queue_quad(state, texture_handle, q);
 }
 void render_rect_slice(ogl::data& state, float x, float y, float width, float height, GLuint texture_handle, float start_slice, float end_slice) {
-	glBindVertexArray(state.global_square_vao);
-
-	bind_vertices_by_rotation(state, ui::rotation::upright, false, false);
-
-	glUniform3f(state.ui_shader_inner_color_uniform, start_slice, end_slice - start_slice, 0.0f);
-	glUniform4f(state.ui_shader_d_rect_uniform, x + width * start_slice, y, width * (end_slice - start_slice), height);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	GLuint subroutines[2] = { map_color_modification_to_index(color_modification::none), parameters::sub_sprite };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, subroutines); // must set all subroutines in one call
+	auto q = make_quad(state, x + width * start_slice, y, width * (end_slice - start_slice), height, map_color_modification_to_index(color_modification::none), parameters::sub_sprite, ui::rotation::upright, false, false);
+	q.inner_color[0] = start_slice;
+	q.inner_color[1] = end_slice - start_slice;
+	queue_quad(state, texture_handle, q);
+}
 
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+void render_rect_slice(ogl::data const& state, float x, float y, float width, float height, asvg::atlas_region const& region, float start_slice, float end_slice) {
+	if(region.texture_handle == 0) { // still being rasterized
+		state.ui_batch.recording_complete = false;
+		return;
+	}
+	auto q = make_quad(state, x + width * start_slice, y, width * (end_slice - start_slice), height, map_color_modification_to_index(color_modification::none), parameters::atlas_sprite, ui::rotation::upright, false, false);
+	q.subrect[0] = region.x + region.width * start_slice;
+	q.subrect[1] = region.width * (end_slice - start_slice);
+	q.subrect[2] = region.y;
+	q.subrect[3] = region.height;
+	queue_quad(state, region.texture_handle, q);
 }
 
 
@@ -1014,63 +1076,45 @@ void render_text_icon(
 			.ascender(ui_scale)
 	) - font_size;
 
-	bind_vertices_by_rotation(state, ui::rotation::upright, false, false);
-	glActiveTexture(GL_TEXTURE0);
-
+	GLuint icon = 0;
 	switch(ico) {
 	case text::embedded_icon::check:
-		glBindTexture(GL_TEXTURE_2D, state.checkmark_icon_tex);
+		icon = state.checkmark_icon_tex;
 		icon_baseline += font_size * 0.1f;
 		break;
 	case text::embedded_icon::xmark:
-	{
-		GLuint false_icon = state.cross_icon_tex;
-		glBindTexture(GL_TEXTURE_2D, false_icon);
+		icon = state.cross_icon_tex;
 		icon_baseline += font_size * 0.1f;
 		break;
-	} case text::embedded_icon::xmark_desaturated:
-	{
-		GLuint false_icon = state.cross_desaturated_icon_tex;
-		glBindTexture(GL_TEXTURE_2D, false_icon);
+	case text::embedded_icon::xmark_desaturated:
+		icon = state.cross_desaturated_icon_tex;
 		icon_baseline += font_size * 0.1f;
 		break;
-	} case text::embedded_icon::check_desaturated:
-	{
-		GLuint false_icon = state.checkmark_desaturated_icon_tex;
-		glBindTexture(GL_TEXTURE_2D, false_icon);
+	case text::embedded_icon::check_desaturated:
+		icon = state.checkmark_desaturated_icon_tex;
 		icon_baseline += font_size * 0.1f;
 		break;
 	}
-	}
 
-	GLuint icon_subroutines[2] = { map_color_modification_to_index(cmod), parameters::no_filter };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, icon_subroutines[0], icon_subroutines[1]);
-	//glUniformSubroutinesuiv(GL_FRAGMENT_SHADER, 2, icon_subroutines); // must set all subroutines in one call
-	glUniform4f(state.ui_shader_d_rect_uniform, x, icon_baseline, scale * font_size, scale * font_size);
-	glUniform4f(state.ui_shader_subrect_uniform, 0.f, 1.f, 0.f, 1.f);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	queue_quad(state, icon, make_quad(state, x, icon_baseline, scale * font_size, scale * font_size, map_color_modification_to_index(cmod), parameters::no_filter, ui::rotation::upright, false, false));
 }
 
 void text_render(
-	FT_Library lib,
-	GLuint square_buffer,
+	ogl::data const& state,
+	text::font_manager& font_collection,
 	float ui_scale,
-	GLuint ui_shader_subroutines_index_uniform,
 	unsigned int subroutine_1,
 	unsigned int subroutine_2,
-	GLuint ui_shader_d_rect_uniform,
-	GLuint ui_shader_subrect_uniform,
-	const std::vector<text::stored_glyph>& glyph_info,
+	color3f const& c,
+	float border_size,
+	std::span<text::stored_glyph const> glyph_info,
 	unsigned int glyph_count,
 	float x,
 	float baseline_y,
 	float size,
 	text::font& f
 ) {
-	glBindVertexBuffer(0, square_buffer, 0, sizeof(GLfloat) * 4);
-	glUniform2ui(ui_shader_subroutines_index_uniform, subroutine_1, subroutine_2);
-
-	auto& font_instance = f.retrieve_stateless_instance(lib, int32_t(size * ui_scale));
+	auto& font_instance = f.retrieve_stateless_instance(font_collection.ft_library, font_collection.glyphs, int32_t(size * ui_scale));
 
 	x = std::floor(x * ui_scale);
 	baseline_y = std::floor(baseline_y * ui_scale);
@@ -1105,16 +1149,20 @@ void text_render(
 			float x_offset = pixel_x_off + float(gso.bitmap_left);
 			float y_offset = float(-gso.bitmap_top) - float(glyph_info[i].y_offset) / text::fixed_to_fp;
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, font_instance.textures[gso.tx_sheet]);
-
-			glUniform4f(ui_shader_d_rect_uniform, x_offset / ui_scale, (baseline_y + y_offset) / ui_scale, float(gso.width) / ui_scale, float(gso.height) / ui_scale);
-			glUniform4f(ui_shader_subrect_uniform, float(gso.x) / float(1024) /* x offset */,
-					float(gso.width) / float(1024) /* x width */, float(gso.y) / float(1024) /* y offset */,
-					float(gso.height) / float(1024) /* y height */
-			);
-
-			glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+			auto q = make_quad(state, x_offset / ui_scale, (baseline_y + y_offset) / ui_scale, float(gso.width) / ui_scale, float(gso.height) / ui_scale,
+				subroutine_1, subroutine_2, ui::rotation::upright, false, false);
+			q.subrect[0] = float(gso.x) / float(text::glyph_atlas::layer_size); // x offset
+			q.subrect[1] = float(gso.width) / float(text::glyph_atlas::layer_size); // x width
+			q.subrect[2] = float(gso.y) / float(text::glyph_atlas::layer_size); // y offset
+			q.subrect[3] = float(gso.height) / float(text::glyph_atlas::layer_size); // y height
+			q.inner_color[0] = c.r;
+			q.inner_color[1] = c.g;
+			q.inner_color[2] = c.b;
+			q.border_size = border_size;
+			q.layer = gso.tx_sheet;
+			// the atlas may have been reallocated while making the glyph
+			state.ui_batch.glyph_texture = font_collection.glyphs.texture;
+			queue_quad(state, 0, q);
 		}
 
 		x += x_advance;
@@ -1123,12 +1171,63 @@ void text_render(
 }
 
 
+// every size is drawn from the one distance field rasterization of the glyph, so glyph positions keep their fractional part
+void sdf_text_render(
+	ogl::data const& state,
+	text::font_manager& font_collection,
+	float ui_scale,
+	unsigned int subroutine_1,
+	color3f const& c,
+	std::span<text::stored_glyph const> glyph_info,
+	unsigned int glyph_count,
+	float x,
+	float baseline_y,
+	float size,
+	text::font& f
+) {
+	auto& font_instance = f.retrieve_sdf_instance(font_collection.ft_library, font_collection.glyphs);
+	float glyph_scale = size * ui_scale / float(text::sdf_reference_size);
+	// one screen pixel expressed in the normalized distance stored in the atlas
+	float pixel_distance = 1.0f / (2.0f * float(text::sdf_spread) * glyph_scale);
+
+	x = x * ui_scale;
+	baseline_y = std::floor(baseline_y * ui_scale);
+
+	for(unsigned int i = 0; i < glyph_count; i++) {
+		hb_codepoint_t glyphid = glyph_info[i].codepoint;
+
+		font_instance.make_glyph(uint16_t(glyphid), 0);
+		auto& gso = font_instance.get_glyph(uint16_t(glyphid), 0);
+
+		if(gso.width != 0) {
+			float x_offset = x + float(glyph_info[i].x_offset) / text::fixed_to_fp + float(gso.bitmap_left) * glyph_scale;
+			float y_offset = float(-gso.bitmap_top) * glyph_scale - float(glyph_info[i].y_offset) / text::fixed_to_fp;
+
+			auto q = make_quad(state, x_offset / ui_scale, (baseline_y + y_offset) / ui_scale, float(gso.width) * glyph_scale / ui_scale, float(gso.height) * glyph_scale / ui_scale,
+				subroutine_1, parameters::sdf_glyph, ui::rotation::upright, false, false);
+			q.subrect[0] = float(gso.x) / float(text::glyph_atlas::layer_size); // x offset
+			q.subrect[1] = float(gso.width) / float(text::glyph_atlas::layer_size); // x width
+			q.subrect[2] = float(gso.y) / float(text::glyph_atlas::layer_size); // y offset
+			q.subrect[3] = float(gso.height) / float(text::glyph_atlas::layer_size); // y height
+			q.inner_color[0] = c.r;
+			q.inner_color[1] = c.g;
+			q.inner_color[2] = c.b;
+			q.border_size = pixel_distance;
+			q.layer = gso.tx_sheet;
+			state.ui_batch.glyph_texture = font_collection.glyphs.texture;
+			queue_quad(state, 0, q);
+		}
+
+		x += float(glyph_info[i].x_advance) / text::fixed_to_fp;
+		baseline_y -= (float(glyph_info[i].y_advance) / text::fixed_to_fp);
+	}
+}
 
 void render_new_text(
 	data& state,
 	text::font_manager& font_collection,
 	text::font& f,
-	text::stored_glyphs const& txt,
+	std::span<text::stored_glyph const> glyphs,
 	color_modification enabled,
 	float x,
 	float y,
@@ -1136,19 +1235,32 @@ void render_new_text(
 	color3f const& c,
 	float ui_scale
 ) {
-	glUniform3f(state.ui_shader_inner_color_uniform, c.r, c.g, c.b);
-	glUniform1f(state.ui_shader_border_size_uniform, 0.08f * 16.0f / size);
+	if(font_collection.sdf_glyphs) {
+		sdf_text_render(
+			state,
+			font_collection,
+			ui_scale,
+			map_color_modification_to_index(enabled),
+			c,
+			glyphs,
+			static_cast<unsigned int>(glyphs.size()),
+			x,
+			y + size,
+			size,
+			f
+		);
+		return;
+	}
 	text_render(
-		font_collection.ft_library,
-		state.global_square_buffer,
+		state,
+		font_collection,
 		ui_scale,
-		state.ui_shader_subroutines_index_uniform,
 		map_color_modification_to_index(enabled),
-		ogl::parameters::subsprite_b,
-		state.ui_shader_d_rect_uniform,
-		state.ui_shader_subrect_uniform,
-		txt.glyph_info,
-		static_cast<unsigned int>(txt.glyph_info.size()),
+		ogl::parameters::glyph,
+		c,
+		0.08f * 16.0f / size,
+		glyphs,
+		static_cast<unsigned int>(glyphs.size()),
 		x,
 		y + size,
 		size,
@@ -1342,16 +1454,12 @@ GLuint load_texture_array_from_file(simple_fs::file& file, int32_t tiles_x, int3
 }
 
 void render_subrect(ogl::data const& state, float target_x, float target_y, float target_width, float target_height, float source_x, float source_y, float source_width, float source_height, GLuint texture_handle) {
-	bind_vertices_by_rotation(state, ui::rotation::upright, false, false);
-	GLuint subroutines[2] = { parameters::enabled, parameters::subsprite_c };
-	glUniform2ui(state.ui_shader_subroutines_index_uniform, subroutines[0], subroutines[1]);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture_handle);
-
-	glUniform4f(state.ui_shader_d_rect_uniform, target_x, target_y, target_width, target_height);
-	glUniform4f(state.ui_shader_subrect_uniform, source_x /* x offset */, source_width /* x width */, source_y /* y offset */, source_height /* y height */);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	auto q = make_quad(state, target_x, target_y, target_width, target_height, parameters::enabled, parameters::subsprite_c, ui::rotation::upright, false, false);
+	q.subrect[0] = source_x; // x offset
+	q.subrect[1] = source_width; // x width
+	q.subrect[2] = source_y; // y offset
+	q.subrect[3] = source_height; // y height
+	queue_quad(state, texture_handle, q);
 }
 
 bezier_path::~bezier_path() {
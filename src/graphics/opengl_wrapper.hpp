@@ -21,6 +21,9 @@ namespace text {
 class font;
 struct stored_glyphs;
 }
+namespace asvg {
+struct atlas_region;
+}
 
 namespace ogl {
 
@@ -170,9 +173,52 @@ inline void debug_callback(GLenum source, GLenum type, GLuint id, GLenum severit
 }
 #endif
 
+// per instance data of a single ui quad, mirrors the instance attributes of ui_v_shader
+struct quad_instance {
+	float d_rect[4] = { 0.f, 0.f, 0.f, 0.f };
+	float subrect[4] = { 0.f, 0.f, 0.f, 0.f };
+	float inner_color[3] = { 0.f, 0.f, 0.f };
+	float border_size = 0.f;
+	float tex_transform[4] = { 1.f, 0.f, 0.f, 1.f };
+	float tex_offset[2] = { 0.f, 0.f };
+	GLuint subroutines[2] = { 0, 0 };
+	GLuint layer = 0; // layer of the glyph atlas, for the glyph subroutine
+};
+
+// a queued quad together with the texture it was drawn with, kept by retained ui subtrees
+struct recorded_quad {
+	quad_instance quad;
+	GLuint texture = 0;
+};
+
+// quads are written into a persistently mapped ring of segments and drawn with one
+// instanced call per run sharing a texture; a segment is reused only once its fence has signaled
+struct quad_batch {
+	static constexpr uint32_t segment_count = 3;
+	static constexpr uint32_t quads_per_segment = 4096;
+
+	quad_instance* mapped = nullptr;
+	GLsync fences[segment_count] = { };
+	GLuint instance_buffer = 0;
+	GLuint vao = 0;
+	GLuint texture = 0;
+	GLuint glyph_texture = 0; // the glyph atlas, bound to texture unit 2 for every draw
+	uint32_t segment = 0;
+	uint32_t used = 0;
+	uint32_t first_pending = 0;
+
+	// while set, every queued quad is also appended here; a draw that bypasses the batch clears recording_complete
+	std::vector<recorded_quad>* recording = nullptr;
+	bool recording_complete = true;
+
+	// texture transforms of the 12 global squares, indexed by rotation, flip and rtl
+	float square_transforms[12][6] = { };
+};
+
 struct data {
 	tagged_vector<texture, dcon::texture_id> asset_textures;
 	ankerl::unordered_dense::map<std::string, dcon::texture_id> late_loaded_map;
+	texture_stream texture_streaming; // fills the textures of late_loaded_map
 
 	void* context = nullptr;
 	bool legacy_mode = false;
@@ -189,9 +235,13 @@ struct data {
 	GLuint ui_shader_border_size_uniform = 0;
 	GLuint ui_shader_texture_sampler_uniform = 0;
 	GLuint ui_shader_secondary_texture_sampler_uniform = 0;
+	GLuint ui_shader_glyph_sampler_uniform = 0;
 	GLuint ui_shader_screen_width_uniform = 0;
 	GLuint ui_shader_screen_height_uniform = 0;
 	GLuint ui_shader_gamma_uniform = 0;
+	GLuint ui_shader_instanced_uniform = 0;
+
+	mutable quad_batch ui_batch;
 
 	GLuint global_square_vao = 0;
 	GLuint global_square_buffer = 0;
@@ -245,6 +295,14 @@ GLuint create_program(std::string_view vertex_shader, std::string_view tes_contr
 void load_shaders(ogl::data& state, simple_fs::file_system& fs);
 void load_global_squares(ogl::data& state);
 
+quad_instance make_quad(ogl::data const& state, float x, float y, float width, float height, GLuint color_subroutine, GLuint font_subroutine, ui::rotation r, bool flipped, bool rtl);
+void queue_quad(ogl::data const& state, GLuint texture_handle, quad_instance const& q);
+void flush_quads(ogl::data const& state); // must be called before any draw that doesn't go through the batch
+void begin_direct_draw(ogl::data const& state); // flushes, and marks any recording in progress as unable to reproduce this draw
+void mark_animated(ogl::data const& state); // what is drawn now changes every frame, so a recording in progress can't be replayed
+void replay_quads(ogl::data const& state, std::span<recorded_quad const> quads);
+void end_ui_batch(ogl::data& state); // flushes and moves to the next segment of the ring, once per frame
+
 class bezier_path {
 public:
 
@@ -378,6 +436,7 @@ void render_alpha_colored_rect(ogl::data const& state, float x, float y, float w
 void render_simple_rect(ogl::data const& state, float x, float y, float width, float height, ui::rotation r, bool flipped, bool rtl);
 void render_textured_rect(ogl::data const& state, color_modification enabled, float x, float y, float width, float height, GLuint texture_handle, ui::rotation r, bool flipped, bool rtl);
 void render_textured_rect_direct(ogl::data const& state, float x, float y, float width, float height, uint32_t handle);
+void render_textured_rect_direct(ogl::data const& state, float x, float y, float width, float height, asvg::atlas_region const& region);
 void render_linegraph(ogl::data const& state, color_modification enabled, float x, float y, float width, float height, lines& l);
 void render_linegraph(ogl::data const& state, color_modification enabled, float x, float y, float width, float height, float r, float g, float b, lines& l);
 void render_linegraph(ogl::data const& state, color_modification enabled, float x, float y, float width, float height, float r, float g, float b, float a, lines& l);
@@ -393,13 +452,14 @@ void render_progress_bar(ogl::data const& state, color_modification enabled, flo
 void render_tinted_textured_rect(ogl::data const& state, float x, float y, float width, float height, float r, float g, float b, GLuint texture_handle, ui::rotation rot, bool flipped, bool rtl);
 void render_subsprite(ogl::data const& state, color_modification enabled, int frame, int total_frames, float x, float y, float width, float height, GLuint texture_handle, ui::rotation r, bool flipped, bool rtl);
 void render_rect_slice(ogl::data const& state, float x, float y, float width, float height, GLuint texture_handle, float start_slice, float end_slice);
+void render_rect_slice(ogl::data const& state, float x, float y, float width, float height, asvg::atlas_region const& region, float start_slice, float end_slice);
 void render_tinted_rect(ogl::data const& state, float x, float y, float width, float height, float r, float g, float b, ui::rotation rot, bool flipped, bool rtl);
 void render_tinted_subsprite(ogl::data const& state, int frame, int total_frames, float x, float y, float width, float height, float r, float g, float b, GLuint texture_handle, ui::rotation rot, bool flipped, bool rtl);
 void render_new_text(
 	data& state,
 	text::font_manager& font_collection,
 	text::font& f,
-	text::stored_glyphs const& txt,
+	std::span<text::stored_glyph const> glyphs,
 	color_modification enabled,
 	float x,
 	float y,
@@ -1,6 +1,8 @@
 #include <bit>
+#include <cstring>
 #include "texture.hpp"
 #include "simple_fs.hpp"
+#include "system_state.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION 1
 // #define STBI_NO_STDIO 1
@@ -60,6 +62,22 @@ set to one or more of the following values.	*/
 #define SOIL_RGBA_S3TC_DXT1 0x83F1
 #define SOIL_RGBA_S3TC_DXT3 0x83F2
 #define SOIL_RGBA_S3TC_DXT5 0x83F3
+#define SOIL_RGBA_BPTC_UNORM 0x8E8C
+#define SOIL_SRGB_ALPHA_S3TC_DXT1 0x8C4D
+#define SOIL_SRGB_ALPHA_S3TC_DXT3 0x8C4E
+#define SOIL_SRGB_ALPHA_S3TC_DXT5 0x8C4F
+#define SOIL_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+
+#define DDS_FOURCC(a, b, c, d) (uint32_t(a) | (uint32_t(b) << 8) | (uint32_t(c) << 16) | (uint32_t(d) << 24))
+/*	DXGI formats that may follow a DX10 header	*/
+#define DXGI_FORMAT_BC1_UNORM 71
+#define DXGI_FORMAT_BC1_UNORM_SRGB 72
+#define DXGI_FORMAT_BC2_UNORM 74
+#define DXGI_FORMAT_BC2_UNORM_SRGB 75
+#define DXGI_FORMAT_BC3_UNORM 77
+#define DXGI_FORMAT_BC3_UNORM_SRGB 78
+#define DXGI_FORMAT_BC7_UNORM 98
+#define DXGI_FORMAT_BC7_UNORM_SRGB 99
 
 #define SOIL_TEXTURE_WRAP_R 0x8072
 #define SOIL_CLAMP_TO_EDGE 0x812F
@@ -98,6 +116,15 @@ set to one or more of the following values.	*/
 		unsigned int dwReserved2;
 	} DDS_header;
 
+	/*	follows DDS_header when the FourCC is DX10	*/
+	typedef struct {
+		unsigned int dxgiFormat;
+		unsigned int resourceDimension;
+		unsigned int miscFlag;
+		unsigned int arraySize;
+		unsigned int miscFlags2;
+	} DDS_header_DX10;
+
 	GLuint SOIL_direct_load_DDS_from_memory(unsigned char const* const buffer, uint32_t buffer_length, uint32_t& width, uint32_t& height, int soil_flags) {
 		/*	file reading variables	*/
 		uint32_t block_size = 16;
@@ -136,7 +163,8 @@ set to one or more of the following values.	*/
 			return 0;
 		}
 		/*	make sure it is a type we can upload	*/
-		if((header->sPixelFormat.dwFlags & DDPF_FOURCC) &&
+		bool dx10 = (header->sPixelFormat.dwFlags & DDPF_FOURCC) && header->sPixelFormat.dwFourCC == DDS_FOURCC('D', 'X', '1', '0');
+		if((header->sPixelFormat.dwFlags & DDPF_FOURCC) && !dx10 &&
 		!((header->sPixelFormat.dwFourCC == (('D' << 0) | ('X' << 8) | ('T' << 16) | ('1' << 24)))
 		|| (header->sPixelFormat.dwFourCC == (('D' << 0) | ('X' << 8) | ('T' << 16) | ('3' << 24)))
 		|| (header->sPixelFormat.dwFourCC == (('D' << 0) | ('X' << 8) | ('T' << 16) | ('5' << 24))))) {
@@ -156,7 +184,54 @@ set to one or more of the following values.	*/
 		GLint s3tc_format_layout = 0; //How's it laid on memory
 		GLint s3tc_type = GL_UNSIGNED_BYTE;
 		uint32_t dds_main_size = 0;
-		if(uncompressed) {
+		if(dx10) {
+			/*	block compressed formats written by newer tools, BC7 among them	*/
+			if(buffer_length < sizeof(DDS_header) + sizeof(DDS_header_DX10)) {
+				return 0;
+			}
+			DDS_header_DX10 const* header_dx10 = reinterpret_cast<DDS_header_DX10 const*>(buffer + buffer_index);
+			buffer_index += sizeof(DDS_header_DX10);
+			if(header_dx10->arraySize > 1) {
+				return 0;
+			}
+			switch(header_dx10->dxgiFormat) {
+			case DXGI_FORMAT_BC1_UNORM:
+				s3tc_format = SOIL_RGBA_S3TC_DXT1;
+				block_size = 8;
+				break;
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+				s3tc_format = SOIL_SRGB_ALPHA_S3TC_DXT1;
+				block_size = 8;
+				break;
+			case DXGI_FORMAT_BC2_UNORM:
+				s3tc_format = SOIL_RGBA_S3TC_DXT3;
+				block_size = 16;
+				break;
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+				s3tc_format = SOIL_SRGB_ALPHA_S3TC_DXT3;
+				block_size = 16;
+				break;
+			case DXGI_FORMAT_BC3_UNORM:
+				s3tc_format = SOIL_RGBA_S3TC_DXT5;
+				block_size = 16;
+				break;
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+				s3tc_format = SOIL_SRGB_ALPHA_S3TC_DXT5;
+				block_size = 16;
+				break;
+			case DXGI_FORMAT_BC7_UNORM:
+				s3tc_format = SOIL_RGBA_BPTC_UNORM;
+				block_size = 16;
+				break;
+			case DXGI_FORMAT_BC7_UNORM_SRGB:
+				s3tc_format = SOIL_SRGB_ALPHA_BPTC_UNORM;
+				block_size = 16;
+				break;
+			default:
+				return 0;
+			}
+			dds_main_size = ((width + 3) >> 2) * ((height + 3) >> 2) * block_size;
+		} else if(uncompressed) {
 			block_size = 3;
 			if(is_alpha) {
 				block_size = 4;
@@ -219,6 +294,13 @@ set to one or more of the following values.	*/
 			glBindTexture(GL_TEXTURE_2D, texid);
 			if(!texid)
 				return 0;
+			{
+				uint64_t rgba8_size = 0;
+				for(uint32_t i = 0; i <= mipmaps; ++i)
+					rgba8_size += uint64_t(std::max<uint32_t>(width >> i, 1)) * uint64_t(std::max<uint32_t>(height >> i, 1)) * 4;
+				/*	uncompressed files are expanded to rgba before the upload	*/
+				record_texture_memory(uncompressed ? rgba8_size : dds_full_size, rgba8_size);
+			}
 			/*	did I have MIPmaps?	*/
 			if(mipmaps > 0) {
 				/*	instruct OpenGL to use the MIPmaps	*/
@@ -801,19 +883,61 @@ GLuint texture::get_texture_handle() const {
 	return texture_handle;
 }
 
+void record_texture_memory(uint64_t stored_bytes, uint64_t rgba8_bytes) {
+	texture_memory.stored_bytes += stored_bytes;
+	texture_memory.rgba8_bytes += rgba8_bytes;
+	if(stored_bytes < rgba8_bytes)
+		++texture_memory.compressed_textures;
+	else
+		++texture_memory.uncompressed_textures;
+}
+
+texture_memory_report make_texture_memory_report() {
+	constexpr GLenum gpu_memory_info_total_available_memory_nvx = 0x9048;
+	constexpr GLenum gpu_memory_info_current_available_vidmem_nvx = 0x9049;
+	constexpr GLenum texture_free_memory_ati = 0x87FC;
+
+	texture_memory_report result;
+	result.loaded = texture_memory;
+	result.saved_bytes = texture_memory.rgba8_bytes > texture_memory.stored_bytes ? texture_memory.rgba8_bytes - texture_memory.stored_bytes : 0;
+
+	GLint extension_count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+	for(GLint i = 0; i < extension_count; ++i) {
+		auto name = std::string_view(reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, GLuint(i))));
+		if(name == "GL_NVX_gpu_memory_info") {
+			GLint kb = 0;
+			glGetIntegerv(gpu_memory_info_current_available_vidmem_nvx, &kb);
+			result.free_video_memory_kb = kb;
+			glGetIntegerv(gpu_memory_info_total_available_memory_nvx, &kb);
+			result.total_video_memory_kb = kb;
+			break;
+		} else if(name == "GL_ATI_meminfo") {
+			GLint values[4] = { 0, 0, 0, 0 }; // the first is the free pool total
+			glGetIntegerv(texture_free_memory_ati, values);
+			result.free_video_memory_kb = values[0];
+			break;
+		}
+	}
+	return result;
+}
+
+// the name with its three letter extension swapped, names without an extension are returned as they are
+static native_string replace_extension(native_string const& name, native_char const* extension) {
+	auto result = name;
+	if(auto pos = result.find_last_of('.'); pos != native_string::npos) {
+		result.resize(pos + 1);
+		result += extension;
+	}
+	return result;
+}
+
 GLuint load_file_and_return_handle(native_string const& native_name, simple_fs::file_system const& fs, texture& asset_texture, bool keep_data) {
 	auto name_length = native_name.length();
 
 	auto root = get_root(fs);
 	if(name_length > 4) { // try loading as a dds
-		auto dds_name = native_name;
-		if(auto pos = dds_name.find_last_of('.'); pos != native_string::npos) {
-			dds_name[pos + 1] = NATIVE('d');
-			dds_name[pos + 2] = NATIVE('d');
-			dds_name[pos + 3] = NATIVE('s');
-			dds_name.resize(pos + 4);
-		}
-		auto file = open_file(root, dds_name);
+		auto file = open_file(root, replace_extension(native_name, NATIVE("dds")));
 		if(file) {
 			auto content = simple_fs::view_contents(*file);
 
@@ -839,14 +963,7 @@ GLuint load_file_and_return_handle(native_string const& native_name, simple_fs::
 
 	auto file = open_file(root, native_name);
 	if(!file && name_length > 4) {
-		auto png_name = native_name;
-		if(auto pos = png_name.find_last_of('.'); pos != native_string::npos) {
-			png_name[pos + 1] = NATIVE('p');
-			png_name[pos + 2] = NATIVE('n');
-			png_name[pos + 3] = NATIVE('g');
-			png_name.resize(pos + 4);
-		}
-		file = open_file(root, png_name);
+		file = open_file(root, replace_extension(native_name, NATIVE("png")));
 	}
 	if(file) {
 		auto content = simple_fs::view_contents(*file);
@@ -864,6 +981,7 @@ GLuint load_file_and_return_handle(native_string const& native_name, simple_fs::
 			glBindTexture(GL_TEXTURE_2D, asset_texture.texture_handle);
 
 			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, asset_texture.size_x, asset_texture.size_y);
+			record_texture_memory(uint64_t(asset_texture.size_x) * uint64_t(asset_texture.size_y) * 4, uint64_t(asset_texture.size_x) * uint64_t(asset_texture.size_y) * 4);
 			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, asset_texture.size_x, asset_texture.size_y, GL_RGBA, GL_UNSIGNED_BYTE,
 					asset_texture.data);
 
@@ -886,24 +1004,177 @@ GLuint load_file_and_return_handle(native_string const& native_name, simple_fs::
 	return 0;
 }
 
-/*
+texture_stream_job::~texture_stream_job() {
+	if(pixels)
+		STBI_FREE(pixels);
+}
+
+texture_stream::~texture_stream() {
+	workers.wait();
+}
+
+// same search order as load_file_and_return_handle: a dds next to the file first, then the file itself, then a png
+static void decode_streamed_texture(simple_fs::file_system const& fs, texture_stream_job& job) {
+	auto root = get_root(fs);
+	if(job.name.length() > 4) {
+		job.dds_file = open_file(root, replace_extension(job.name, NATIVE("dds")));
+		if(job.dds_file)
+			return;
+	}
+	auto file = open_file(root, job.name);
+	if(!file && job.name.length() > 4)
+		file = open_file(root, replace_extension(job.name, NATIVE("png")));
+	if(file) {
+		auto content = simple_fs::view_contents(*file);
+		int32_t file_channels = 4;
+		job.pixels = stbi_load_from_memory(reinterpret_cast<uint8_t const*>(content.data), int32_t(content.file_size), &job.size_x, &job.size_y, &file_channels, 4);
+	}
+}
+
+void texture_stream::submit(simple_fs::file_system const& fs, std::shared_ptr<texture_stream_job> job) {
+	workers.run([&fs, this, job]() {
+		decode_streamed_texture(fs, *job);
+		decoded.push(job);
+	});
+}
+
+GLuint texture_stream::get_placeholder() {
+	if(!placeholder) {
+		uint8_t const transparent[4] = { 0, 0, 0, 0 };
+		glCreateTextures(GL_TEXTURE_2D, 1, &placeholder);
+		glTextureStorage2D(placeholder, 1, GL_RGBA8, 1, 1);
+		glTextureSubImage2D(placeholder, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, transparent);
+	}
+	return placeholder;
+}
+
+static void finish_streamed_texture(ogl::data& state, texture_stream_job& job) {
+	auto& t = state.asset_textures[dcon::texture_id{ dcon::texture_id::value_base_t(job.texture_index) }];
+	t.texture_handle = job.handle;
+	t.size_x = job.size_x;
+	t.size_y = job.size_y;
+	t.channels = 4;
+	t.loaded = true;
+	if(job.keep_data && job.pixels) {
+		t.data = job.pixels;
+		job.pixels = nullptr;
+	} else if(job.keep_data && job.handle) {
+		// dds contents only exist on the gpu
+		t.data = static_cast<uint8_t*>(STBI_MALLOC(4 * job.size_x * job.size_y));
+		glGetTextureImage(job.handle, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<int32_t>(4 * job.size_x * job.size_y), t.data);
+	}
+}
+
+bool texture_stream::upload_pending(ogl::data& state) {
+	bool any = false;
+	std::shared_ptr<texture_stream_job> job;
+	while(decoded.try_pop(job)) {
+		any = true;
+		if(job->dds_file) {
+			auto content = simple_fs::view_contents(*job->dds_file);
+			uint32_t w = 0;
+			uint32_t h = 0;
+			job->handle = SOIL_direct_load_DDS_from_memory(reinterpret_cast<uint8_t const*>(content.data), content.file_size, w, h, 0);
+			job->size_x = int32_t(w);
+			job->size_y = int32_t(h);
+			job->dds_file.reset();
+			bytes_uploaded += content.file_size;
+			finish_streamed_texture(state, *job);
+		} else if(!job->pixels) {
+			finish_streamed_texture(state, *job); // missing or undecodable, trying again would be wasteful
+		} else {
+			glCreateTextures(GL_TEXTURE_2D, 1, &job->handle);
+			glTextureStorage2D(job->handle, 1, GL_RGBA8, job->size_x, job->size_y);
+			record_texture_memory(uint64_t(job->size_x) * uint64_t(job->size_y) * 4, uint64_t(job->size_x) * uint64_t(job->size_y) * 4);
+			glTextureParameteri(job->handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTextureParameteri(job->handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTextureParameteri(job->handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(job->handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			uploading.push_back(std::move(job));
+		}
+	}
+	if(uploading.empty())
+		return any;
+
+	if(!pixel_buffer) {
+		GLsizeiptr ring_size = GLsizeiptr(segment_size) * segment_count;
+		glCreateBuffers(1, &pixel_buffer);
+		glNamedBufferStorage(pixel_buffer, ring_size, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+		mapped = static_cast<uint8_t*>(glMapNamedBufferRange(pixel_buffer, 0, ring_size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+		if(!mapped) {
+			notify_user_of_fatal_opengl_error("Unable to map the texture upload buffer");
+		}
+	}
+	if(fences[segment]) {
+		// never wait: if the gpu hasn't consumed this segment yet, the uploads move to the next frame
+		auto status = glClientWaitSync(fences[segment], 0, 0);
+		if(status == GL_TIMEOUT_EXPIRED)
+			return true;
+		glDeleteSync(fences[segment]);
+		fences[segment] = nullptr;
+	}
+
+	uint32_t budget = std::min(upload_budget, segment_size);
+	uint32_t used = 0;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	while(!uploading.empty()) {
+		auto& front = *uploading.front();
+		uint32_t row_bytes = uint32_t(front.size_x) * 4;
+		if(row_bytes > segment_size) {
+			// a single row doesn't fit the ring, upload straight from memory
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glTextureSubImage2D(front.handle, 0, 0, 0, front.size_x, front.size_y, GL_RGBA, GL_UNSIGNED_BYTE, front.pixels);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+			front.rows_uploaded = front.size_y;
+			bytes_uploaded += uint64_t(row_bytes) * uint64_t(front.size_y);
+		} else {
+			int32_t rows = std::min(front.size_y - front.rows_uploaded, int32_t((budget - used) / row_bytes));
+			if(rows <= 0)
+				break;
+			size_t offset = size_t(segment) * segment_size + used;
+			std::memcpy(mapped + offset, front.pixels + size_t(front.rows_uploaded) * row_bytes, size_t(rows) * row_bytes);
+			glTextureSubImage2D(front.handle, 0, 0, front.rows_uploaded, front.size_x, rows, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void const*>(offset));
+			used += uint32_t(rows) * row_bytes;
+			front.rows_uploaded += rows;
+		}
+		if(front.rows_uploaded >= front.size_y) {
+			finish_streamed_texture(state, front);
+			uploading.pop_front();
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	if(used != 0) {
+		fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		segment = (segment + 1) % segment_count;
+		bytes_uploaded += used;
+	}
+	return true;
+}
+
 GLuint get_late_load_texture_handle(sys::state& state, dcon::texture_id& id, std::string_view asset_name) {
-	if(id && state.open_gl.asset_textures[id].loaded) {
-		return state.open_gl.asset_textures[id].texture_handle;
-	} else {
+	if(!id) {
 		if(auto it = state.open_gl.late_loaded_map.find(std::string(asset_name)); it != state.open_gl.late_loaded_map.end()) {
 			id = it->second;
-			return state.open_gl.asset_textures[id].texture_handle;
+		} else {
+			dcon::texture_id new_id{ dcon::texture_id::value_base_t(state.open_gl.asset_textures.size()) };
+			state.open_gl.asset_textures.emplace_back();
+			id = new_id;
+			state.open_gl.late_loaded_map.insert_or_assign(std::string(asset_name), new_id);
+
+			auto job = std::make_shared<texture_stream_job>();
+			job->name = native_string(NATIVE("assets")) + NATIVE_DIR_SEPARATOR + simple_fs::utf8_to_native(asset_name);
+			job->texture_index = int32_t(new_id.index());
+			state.open_gl.texture_streaming.submit(state.common_fs, std::move(job));
 		}
-		dcon::texture_id new_id{ dcon::texture_id::value_base_t(state.open_gl.asset_textures.size()) };
-		state.open_gl.asset_textures.emplace_back();
-		id = new_id;
-		state.open_gl.late_loaded_map.insert_or_assign(std::string(asset_name), new_id);
-		native_string nname = native_string(NATIVE("assets")) + NATIVE_DIR_SEPARATOR + simple_fs::utf8_to_native(asset_name);
-		return load_file_and_return_handle(nname, state.common_fs, state.open_gl.asset_textures.back(), false);
 	}
+	auto& t = state.open_gl.asset_textures[id];
+	if(t.loaded)
+		return t.texture_handle;
+	// a retained subtree must not keep drawing the placeholder once the texture arrives
+	state.open_gl.ui_batch.recording_complete = false;
+	return state.open_gl.texture_streaming.get_placeholder();
 }
-*/
 
 data_texture::data_texture(int32_t sz, int32_t ch) {
 	size = sz;
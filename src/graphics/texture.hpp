@@ -1,5 +1,8 @@
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <optional>
 #include "system_state_forward.hpp"
 #include "container_types.hpp"
 #include "native_types.hpp"
@@ -9,17 +12,22 @@
 #define GLEW_STATIC
 #endif
 #include "GL/glew.h"
+#include "oneapi/tbb/task_group.h"
+#include "oneapi/tbb/concurrent_queue.h"
 
 namespace dcon {
 class government_flag_id;
+class texture_id;
 }
 
 namespace ogl {
 
 class texture;
+struct data;
 
 GLuint load_file_and_return_handle(native_string const& native_name, simple_fs::file_system const& fs, texture& asset_texture, bool keep_data);
-// GLuint get_late_load_texture_handle(sys::state& state, dcon::texture_id& id, std::string_view asset_name);
+// the texture is streamed in the first time it is asked for; until it is uploaded the placeholder is returned instead
+GLuint get_late_load_texture_handle(sys::state& state, dcon::texture_id& id, std::string_view asset_name);
 
 enum {
 	SOIL_FLAG_TEXTURE_REPEATS = 4,
@@ -27,6 +35,24 @@ enum {
 
 GLuint SOIL_direct_load_DDS_from_memory(unsigned char const* const buffer, uint32_t buffer_length, uint32_t& width, uint32_t& height, int soil_flags);
 
+// texture storage created by the loaders next to what the same textures would take as GL_RGBA8; GL thread only
+struct texture_memory_stats {
+	uint64_t stored_bytes = 0;
+	uint64_t rgba8_bytes = 0;
+	uint32_t compressed_textures = 0;
+	uint32_t uncompressed_textures = 0;
+};
+inline texture_memory_stats texture_memory;
+void record_texture_memory(uint64_t stored_bytes, uint64_t rgba8_bytes);
+
+struct texture_memory_report {
+	texture_memory_stats loaded;
+	uint64_t saved_bytes = 0; // by block compression, from the loaders' own accounting
+	int64_t free_video_memory_kb = -1; // from GL_NVX_gpu_memory_info or GL_ATI_meminfo, -1 where neither is available
+	int64_t total_video_memory_kb = -1; // GL_NVX_gpu_memory_info only
+};
+texture_memory_report make_texture_memory_report(); // GL thread only
+
 class texture {
 public:
 	GLuint texture_handle = 0;
@@ -77,6 +103,53 @@ public:
 	~data_texture();
 };
 
+// a texture read and decoded on a worker thread; texture_stream::upload_pending moves it to the gpu
+struct texture_stream_job {
+	native_string name;
+	int32_t texture_index = 0; // into data::asset_textures
+	std::optional<simple_fs::file> dds_file; // dds files are handed to SOIL on the GL thread as they are
+	uint8_t* pixels = nullptr; // rgba8, from stbi
+	int32_t size_x = 0;
+	int32_t size_y = 0;
+	int32_t rows_uploaded = 0;
+	GLuint handle = 0;
+	bool keep_data = false;
+
+	texture_stream_job() { }
+	texture_stream_job(texture_stream_job const&) = delete;
+	texture_stream_job& operator=(texture_stream_job const&) = delete;
+	~texture_stream_job();
+};
+
+// decoded pixels are copied into a ring of persistently mapped pixel unpack buffers and uploaded from there,
+// a band of rows at a time and at most upload_budget bytes per frame, so a large texture is spread over several frames
+// a segment of the ring is written again only once the fence of its last upload has signaled
+class texture_stream {
+public:
+	static constexpr uint32_t segment_count = 3;
+	static constexpr uint32_t segment_size = 4 * 1024 * 1024;
+
+	tbb::task_group workers;
+	tbb::concurrent_queue<std::shared_ptr<texture_stream_job>> decoded;
+	std::deque<std::shared_ptr<texture_stream_job>> uploading; // GL thread only
+	uint8_t* mapped = nullptr;
+	GLsync fences[segment_count] = { };
+	GLuint pixel_buffer = 0;
+	GLuint placeholder = 0; // 1x1 transparent texture
+	uint32_t segment = 0;
+	uint32_t upload_budget = segment_size; // bytes per frame, capped at segment_size
+	uint64_t bytes_uploaded = 0;
+
+	texture_stream() { }
+	texture_stream(texture_stream const& other) = delete;
+	texture_stream& operator=(texture_stream const& other) = delete;
+	~texture_stream();
+
+	void submit(simple_fs::file_system const& fs, std::shared_ptr<texture_stream_job> job);
+	GLuint get_placeholder(); // GL thread only
+	bool upload_pending(ogl::data& state); // GL thread only, once per frame; true while textures are arriving
+};
+
 struct font_texture_result {
 	uint32_t handle = 0;
 	uint32_t size = 0;
@@ -84,6 +84,7 @@ void template_icon_button::render(sys::state& state, int32_t x, int32_t y) noexc
 				state.ui_templates.icons[icon].renders.get_render(state, int32_t(r - l), int32_t(b - t), state.user_settings.ui_scale, state.ui_templates.colors[ico_color].r, state.ui_templates.colors[ico_color].g, state.ui_templates.colors[ico_color].b));
 		}
 	} else if(ms_after.count() < mouse_over_animation_ms && state.ui_templates.iconic_button_t[template_id].animate_active_transition) {
+		ogl::mark_animated(state.open_gl);
 		float percentage = float(ms_after.count()) / float(mouse_over_animation_ms);
 		if(this == state.ui_state.under_mouse) {
 			auto active_id = state.ui_templates.iconic_button_t[template_id].active.bg;
@@ -333,6 +334,7 @@ void template_mixed_button::render(sys::state& state, int32_t x, int32_t y) noex
 				state.ui_templates.backgrounds[bg_id].renders.get_render(state, float(base_data.size.x) / float(par->grid_size), float(base_data.size.y) / float(par->grid_size), int32_t(par->grid_size), state.user_settings.ui_scale));
 		}
 	} else if(ms_after.count() < mouse_over_animation_ms && state.ui_templates.mixed_button_t[template_id].animate_active_transition) {
+		ogl::mark_animated(state.open_gl);
 		float percentage = float(ms_after.count()) / float(mouse_over_animation_ms);
 		if(this == state.ui_state.under_mouse) {
 			region = state.ui_templates.mixed_button_t[template_id].active;
@@ -438,6 +440,7 @@ void template_mixed_button_ci::render(sys::state& state, int32_t x, int32_t y) n
 				state.ui_templates.backgrounds[bg_id].renders.get_render(state, float(base_data.size.x) / float(par->grid_size), float(base_data.size.y) / float(par->grid_size), int32_t(par->grid_size), state.user_settings.ui_scale));
 		}
 	} else if(ms_after.count() < mouse_over_animation_ms && state.ui_templates.mixed_button_t[template_id].animate_active_transition) {
+		ogl::mark_animated(state.open_gl);
 		float percentage = float(ms_after.count()) / float(mouse_over_animation_ms);
 		if(this == state.ui_state.under_mouse) {
 			region = state.ui_templates.mixed_button_t[template_id].active;
@@ -588,6 +591,7 @@ void template_text_button::render(sys::state& state, int32_t x, int32_t y) noexc
 				state.ui_templates.backgrounds[bg_id].renders.get_render(state, float(base_data.size.x) / float(par->grid_size), float(base_data.size.y) / float(par->grid_size), int32_t(par->grid_size), state.user_settings.ui_scale));
 		}
 	} else if(ms_after.count() < mouse_over_animation_ms && state.ui_templates.button_t[template_id].animate_active_transition) {
+		ogl::mark_animated(state.open_gl);
 		float percentage = float(ms_after.count()) / float(mouse_over_animation_ms);
 		if(this == state.ui_state.under_mouse) {
 			region = state.ui_templates.button_t[template_id].active;
@@ -739,6 +743,7 @@ void template_toggle_button::render(sys::state& state, int32_t x, int32_t y) noe
 				state.ui_templates.backgrounds[bg_id].renders.get_render(state, float(base_data.size.x) / float(par->grid_size), float(base_data.size.y) / float(par->grid_size), int32_t(par->grid_size), state.user_settings.ui_scale));
 		}
 	} else if(ms_after.count() < mouse_over_animation_ms && state.ui_templates.toggle_button_t[template_id].animate_active_transition) {
+		ogl::mark_animated(state.open_gl);
 		float percentage = float(ms_after.count()) / float(mouse_over_animation_ms);
 		if(this == state.ui_state.under_mouse) {
 			region = mainregion.active;
@@ -1205,6 +1210,7 @@ void template_drop_down_control::open_list(sys::state& state) {
 	auto current_root = state.current_scene.get_root(state);
 	if(!state.ui_state.popup_menu) {
 		auto new_menu = std::make_unique<alice_ui::pop_up_menu_container>();
+		new_menu->set_update_dependencies(0); // only its list buttons read anything
 		state.ui_state.popup_menu = new_menu.get();
 		current_root->add_child_to_back(std::move(new_menu));
 	}
@@ -1289,6 +1295,7 @@ void template_drop_down_control::change_page(sys::state& state, int32_t to_page)
 		return;
 
 	state.ui_state.popup_menu->children.clear();
+	state.ui_state.popup_menu->invalidate_render_cache();
 	page_text_out_of_date = true;
 
 	grid_size_window* par = static_cast<grid_size_window*>(parent);
@@ -1302,6 +1309,7 @@ void template_drop_down_control::change_page(sys::state& state, int32_t to_page)
 		if(!page_controls) {
 			page_controls = std::make_unique<drop_down_list_page_buttons>();
 			page_controls->owner_control = this;
+			page_controls->set_update_dependencies(0); // redrawn from owner_control when the page changes
 			page_controls->base_data.size.x = int16_t(par->grid_size * 8);
 			page_controls->base_data.size.y = int16_t(par->grid_size * 2);
 		}
@@ -1326,7 +1334,7 @@ void template_drop_down_control::change_page(sys::state& state, int32_t to_page)
 		child->base_data.position.x = int16_t(x_offset);
 		child->base_data.position.y = int16_t(y_offset);
 		child->parent = state.ui_state.popup_menu;
-		child->impl_on_update(state);
+		child->force_update(state);
 		++index;
 	}
 
@@ -1345,6 +1353,8 @@ void template_drop_down_control::change_page(sys::state& state, int32_t to_page)
 		if(index >= int32_t(list_buttons_pool.size())) {
 			list_buttons_pool.emplace_back(std::make_unique<drop_down_list_button>());
 			list_buttons_pool.back()->owner_control = this;
+			// the selection mark only changes when the control itself is updated
+			list_buttons_pool.back()->set_update_dependencies(update_dependencies);
 		}
 		state.ui_state.popup_menu->children.push_back(list_buttons_pool[index].get());
 		list_buttons_pool[index]->list_id = effective_index;
@@ -1354,7 +1364,7 @@ void template_drop_down_control::change_page(sys::state& state, int32_t to_page)
 		list_buttons_pool[index]->base_data.size.x = int16_t(elm_h_size);
 		list_buttons_pool[index]->base_data.size.y = int16_t(element_y_size);
 		list_buttons_pool[index]->parent = state.ui_state.popup_menu;
-		list_buttons_pool[index]->impl_on_update(state);
+		list_buttons_pool[index]->force_update(state);
 		alt = !alt;
 		++index;
 	}
@@ -1391,6 +1401,7 @@ void template_drop_down_control::render(sys::state& state, int32_t x, int32_t y)
 				state.ui_templates.backgrounds[bg_id].renders.get_render(state, float(base_data.size.x) / float(par->grid_size), float(base_data.size.y) / float(par->grid_size), int32_t(par->grid_size), state.user_settings.ui_scale));
 		}
 	} else if(ms_after.count() < mouse_over_animation_ms && state.ui_templates.drop_down_t[template_id].animate_active_transition) {
+		ogl::mark_animated(state.open_gl);
 		float percentage = float(ms_after.count()) / float(mouse_over_animation_ms);
 		if(this == state.ui_state.under_mouse) {
 			auto active_id = state.ui_templates.drop_down_t[template_id].active_bg;
@@ -1439,6 +1450,8 @@ void template_drop_down_control::render(sys::state& state, int32_t x, int32_t y)
 void layout_window_element::initialize_template(sys::state& state, int32_t id, int32_t gs, bool ac) {
 	window_template = id;
 	grid_size = gs;
+	// windows mostly sit still between updates, so they replay the quads of their last frame
+	set_retained_render(true);
 	if(ac) {
 		auto_close = std::make_unique<auto_close_button>();
 		auto_close->base_data.size.x = int16_t(grid_size * 3);
@@ -1650,7 +1663,7 @@ struct layout_iterator {
 			if(i.fill_y)
 				i.ptr->base_data.size.y = int16_t(height);
 			destination->children.push_back(i.ptr);
-			i.ptr->impl_on_update(state);
+			i.ptr->force_update(state);
 		} else if(std::holds_alternative<layout_window>(m)) {
 			auto& i = std::get<layout_window>(m);
 			if(i.absolute_position) {
@@ -1665,7 +1678,7 @@ struct layout_iterator {
 			if(i.fill_y)
 				i.ptr->base_data.size.y = int16_t(height);
 			destination->children.push_back(i.ptr.get());
-			i.ptr->impl_on_update(state);
+			i.ptr->force_update(state);
 		} else if(std::holds_alternative<layout_glue>(m)) {
 
 		} else if(std::holds_alternative<generator_instance>(m)) {
@@ -1737,7 +1750,7 @@ struct layout_iterator {
 };
 
 void layout_window_element::impl_on_update(sys::state& state) noexcept {
-	on_update(state);
+	element_base::impl_on_update(state);
 }
 
 void layout_window_element::clear_pages_internal(layout_level& lvl) {
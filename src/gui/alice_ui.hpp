@@ -543,6 +543,7 @@ public:
 
 	void remake_layout(sys::state& state, bool remake_lists) {
 		children.clear();
+		invalidate_render_cache();
 		textures_to_render.clear();
 		if(remake_lists)
 			clear_pages_internal(layout);
@@ -574,7 +575,7 @@ ui::element_base* display_at_front(sys::state& state, display_closure_command fn
 		auto new_item = GEN_FN(state);
 		auto ptr = new_item.get();
 		current_root->add_child_to_back(std::move(new_item));
-		ptr->impl_on_update(state);
+		ptr->force_update(state);
 		return ptr;
 	}();
 
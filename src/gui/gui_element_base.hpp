@@ -40,9 +40,13 @@ class element_base {
 public:
 	static constexpr uint8_t is_invisible_mask = 0x01;
 	static constexpr uint8_t wants_update_when_hidden_mask = 0x02;
+	static constexpr uint8_t update_dependencies_cached_mask = 0x04;
+	static constexpr uint8_t retained_render_mask = 0x08; // containers only: replay the quads of the last frame while nothing below changes
+	static constexpr uint8_t render_cache_valid_mask = 0x10;
 
 	element_data base_data;
 	element_base* parent = nullptr;
+	update_mask update_dependencies = update_topic::all; // topics read by on_update; narrow it so that update passes can skip this element
 	uint8_t flags = 0;
 
 	bool is_visible() const {
@@ -51,15 +55,39 @@ public:
 	void set_visible(sys::state& state, bool vis) {
 		auto old_visibility = is_visible();
 		flags = uint8_t((flags & ~is_invisible_mask) | (vis ? 0 : is_invisible_mask));
+		if(vis != old_visibility)
+			invalidate_render_cache();
 		if(vis && !old_visibility) {
 			if((wants_update_when_hidden_mask & flags) == 0)
-				impl_on_update(state);
+				force_update(state);
 			on_visible(state);
 		} else if(!vis && old_visibility) {
 			on_hide(state);
 		}
 	}
 
+	void set_update_dependencies(update_mask topics) {
+		update_dependencies = topics;
+		invalidate_update_dependencies();
+	}
+	// must be called when the subtree below this element changes
+	void invalidate_update_dependencies() {
+		flags = uint8_t(flags & ~update_dependencies_cached_mask);
+		for(auto p = parent; p && (p->flags & update_dependencies_cached_mask) != 0; p = p->parent)
+			p->flags = uint8_t(p->flags & ~update_dependencies_cached_mask);
+	}
+
+	// only for subtrees whose look depends on nothing but their own state; hover, focus and dragging are handled
+	void set_retained_render(bool retain) {
+		flags = uint8_t((flags & ~retained_render_mask) | (retain ? retained_render_mask : 0));
+		invalidate_render_cache();
+	}
+	// must be called when anything changes how this element is drawn, if on_update and visibility changes aren't enough
+	void invalidate_render_cache() {
+		for(auto e = this; e; e = e->parent)
+			e->flags = uint8_t(e->flags & ~render_cache_valid_mask);
+	}
+
 	element_base() { }
 
 	// impl members: to be overridden only for the very basic container / not a container distinction
@@ -76,6 +104,10 @@ public:
 	virtual message_result impl_on_scroll(sys::state& state, int32_t x, int32_t y, float amount, sys::key_modifiers mods) noexcept;
 	virtual message_result impl_on_mouse_move(sys::state& state, int32_t x, int32_t y, sys::key_modifiers mods) noexcept;
 	virtual void impl_on_update(sys::state& state) noexcept;
+	void force_update(sys::state& state) noexcept; // impl_on_update regardless of which topics are dirty, for elements that were just shown or repopulated
+	virtual update_mask impl_update_dependencies(sys::state& state) noexcept { // topics read by this element and everything below it
+		return update_dependencies;
+	}
 	
 	virtual void* get_by_name(sys::state& state, std::string_view name) noexcept {
 		return nullptr;
@@ -95,26 +95,41 @@ message_result non_owning_container_base::impl_on_key_down(sys::state& state, sy
 	return greater_result(res, element_base::impl_on_key_down(state, key, mods));
 }
 
+static bool child_needs_update(sys::state& state, element_base& child) {
+	if(!child.is_visible() && (child.flags & element_base::wants_update_when_hidden_mask) == 0)
+		return false;
+	return state.ui_state.update_pass_topics == update_topic::all || (child.impl_update_dependencies(state) & state.ui_state.update_pass_topics) != 0;
+}
+
 void container_base::impl_on_update(sys::state& state) noexcept {
-	on_update(state);
+	element_base::impl_on_update(state);
 	if(is_visible()) {
 		for(auto& c : children) {
-			if(c->is_visible() || (c->flags & element_base::wants_update_when_hidden_mask) != 0) {
+			if(child_needs_update(state, *c)) {
 				c->impl_on_update(state);
 			}
 		}
 	}
 }
 void non_owning_container_base::impl_on_update(sys::state& state) noexcept {
-	on_update(state);
+	element_base::impl_on_update(state);
 	if(is_visible()) {
 		for(size_t i = children.size(); i-- > 0;) {
-			if(children[i]->is_visible() || (children[i]->flags & element_base::wants_update_when_hidden_mask) != 0) {
+			if(child_needs_update(state, *children[i])) {
 				children[i]->impl_on_update(state);
 			}
 		}
 	}
 }
+update_mask container_base::impl_update_dependencies(sys::state& state) noexcept {
+	if((flags & update_dependencies_cached_mask) == 0) {
+		subtree_update_dependencies = update_dependencies;
+		for(auto& c : children)
+			subtree_update_dependencies |= c->impl_update_dependencies(state);
+		flags = uint8_t(flags | update_dependencies_cached_mask);
+	}
+	return subtree_update_dependencies;
+}
 void container_base::impl_on_reset_text(sys::state& state) noexcept {
 	for(auto& c : children) {
 		c->impl_on_reset_text(state);
@@ -127,25 +142,100 @@ void non_owning_container_base::impl_on_reset_text(sys::state& state) noexcept {
 	}
 	on_reset_text(state);
 }
+static bool is_inside(element_base const& root, element_base const* e) {
+	for(; e; e = e->parent) {
+		if(e == &root)
+			return true;
+	}
+	return false;
+}
+// elements drawn differently while they are hovered, held, focused or dragged
+static bool has_live_element(sys::state& state, element_base const& root) {
+	return is_inside(root, state.ui_state.under_mouse)
+		|| is_inside(root, state.ui_state.left_mouse_hold_target)
+		|| is_inside(root, state.ui_state.edit_target_internal)
+		|| is_inside(root, state.ui_state.drag_target)
+		|| is_inside(root, state.ui_state.mouse_sensitive_target);
+}
+
+// replays the quads recorded on an earlier frame, or draws the subtree and records its quads
+template<typename F>
+static void render_retained(sys::state& state, element_base& root, retained_render_cache& cache, int32_t x, int32_t y, F&& render_subtree) {
+	if((root.flags & element_base::retained_render_mask) == 0) {
+		render_subtree();
+		return;
+	}
+	if(has_live_element(state, root)) { // whatever the interaction changes has to be recorded again afterwards
+		root.flags = uint8_t(root.flags & ~element_base::render_cache_valid_mask);
+		render_subtree();
+		return;
+	}
+	auto glyph_generation = state.font_collection.glyphs.generation;
+	auto svg_evictions = state.svg_atlas.evictions;
+	auto& batch = state.open_gl.ui_batch;
+	if((root.flags & element_base::render_cache_valid_mask) != 0 && cache.x == x && cache.y == y && cache.glyph_generation == glyph_generation && cache.svg_evictions == svg_evictions) {
+		for(auto p : cache.svg_pages)
+			state.svg_atlas.touch(p);
+		batch.glyph_texture = state.font_collection.glyphs.texture;
+		ogl::replay_quads(state.open_gl, cache.quads);
+		if(batch.recording)
+			batch.recording->insert(batch.recording->end(), cache.quads.begin(), cache.quads.end());
+		return;
+	}
+
+	auto outer_recording = batch.recording;
+	auto outer_complete = batch.recording_complete;
+	cache.quads.clear();
+	batch.recording = &cache.quads;
+	batch.recording_complete = true;
+	render_subtree();
+	// the atlases may have dropped entries while the subtree was drawn
+	bool complete = batch.recording_complete && glyph_generation == state.font_collection.glyphs.generation && svg_evictions == state.svg_atlas.evictions;
+	batch.recording = outer_recording;
+	batch.recording_complete = outer_complete && complete;
+	if(outer_recording)
+		outer_recording->insert(outer_recording->end(), cache.quads.begin(), cache.quads.end());
+
+	cache.svg_pages.clear();
+	GLuint last_texture = 0;
+	for(auto& q : cache.quads) {
+		if(q.texture == last_texture) // quads come in runs that share a texture
+			continue;
+		last_texture = q.texture;
+		auto p = state.svg_atlas.page_of(q.texture);
+		if(p != state.svg_atlas.pages.size() && std::find(cache.svg_pages.begin(), cache.svg_pages.end(), p) == cache.svg_pages.end())
+			cache.svg_pages.push_back(p);
+	}
+	cache.x = x;
+	cache.y = y;
+	cache.glyph_generation = glyph_generation;
+	cache.svg_evictions = svg_evictions;
+	root.flags = uint8_t(complete ? (root.flags | element_base::render_cache_valid_mask) : (root.flags & ~element_base::render_cache_valid_mask));
+}
+
 void container_base::impl_render(sys::state& state, int32_t x, int32_t y) noexcept {
-	element_base::impl_render(state, x, y);
+	render_retained(state, *this, render_cache, x, y, [&]() {
+		element_base::impl_render(state, x, y);
 
-	for(size_t i = children.size(); i-- > 0;) {
-		if(children[i]->is_visible()) {
-			auto relative_location = child_relative_location(state, *this, *(children[i]));
-			children[i]->impl_render(state, x + relative_location.x, y + relative_location.y);
+		for(size_t i = children.size(); i-- > 0;) {
+			if(children[i]->is_visible()) {
+				auto relative_location = child_relative_location(state, *this, *(children[i]));
+				children[i]->impl_render(state, x + relative_location.x, y + relative_location.y);
+			}
 		}
-	}
+	});
 }
 void non_owning_container_base::impl_render(sys::state& state, int32_t x, int32_t y) noexcept {
-	element_base::impl_render(state, x, y);
+	render_retained(state, *this, render_cache, x, y, [&]() {
+		element_base::impl_render(state, x, y);
 
-	for(size_t i = children.size(); i-- > 0;) {
-		if(children[i]->is_visible()) {
-			auto relative_location = child_relative_location(state, *this, *(children[i]));
-			children[i]->impl_render(state, x + relative_location.x, y + relative_location.y);
+		for(size_t i = children.size(); i-- > 0;) {
+			if(children[i]->is_visible()) {
+				auto relative_location = child_relative_location(state, *this, *(children[i]));
+				children[i]->impl_render(state, x + relative_location.x, y + relative_location.y);
+			}
 		}
-	}
+	});
 }
 
 std::unique_ptr<element_base> container_base::remove_child(element_base* child) noexcept {
@@ -155,6 +245,8 @@ std::unique_ptr<element_base> container_base::remove_child(element_base* child)
 		auto temp = std::move(children.back());
 		children.pop_back();
 		temp->parent = nullptr;
+		invalidate_update_dependencies();
+		invalidate_render_cache();
 		return temp;
 	}
 	return std::unique_ptr<element_base>{};
@@ -163,29 +255,35 @@ void container_base::move_child_to_front(element_base* child) noexcept {
 	if(auto it = std::find_if(children.begin(), children.end(), [child](std::unique_ptr<element_base>& p) { return p.get() == child; }); it != children.end()) {
 		if(it != children.begin())
 			std::rotate(children.begin(), it, it + 1);
+		invalidate_render_cache();
 	}
 }
 void non_owning_container_base::move_child_to_front(element_base* child) noexcept {
 	if(auto it = std::find_if(children.begin(), children.end(), [child](element_base* p) { return p == child; }); it != children.end()) {
 		if(it != children.begin())
 			std::rotate(children.begin(), it, it + 1);
+		invalidate_render_cache();
 	}
 }
 void container_base::move_child_to_back(element_base* child) noexcept {
 	if(auto it = std::find_if(children.begin(), children.end(), [child](std::unique_ptr<element_base>& p) { return p.get() == child; }); it != children.end()) {
 		if(it + 1 != children.end())
 			std::rotate(it, it + 1, children.end());
+		invalidate_render_cache();
 	}
 }
 void non_owning_container_base::move_child_to_back(element_base* child) noexcept {
 	if(auto it = std::find_if(children.begin(), children.end(), [child](element_base* p) { return p == child; }); it != children.end()) {
 		if(it + 1 != children.end())
 			std::rotate(it, it + 1, children.end());
+		invalidate_render_cache();
 	}
 }
 void container_base::add_child_to_front(std::unique_ptr<element_base> child) noexcept {
 	child->parent = this;
 	children.emplace_back(std::move(child));
+	invalidate_update_dependencies();
+	invalidate_render_cache();
 	if(children.size() > 1) {
 		std::rotate(children.begin(), children.end() - 1, children.end());
 	}
@@ -193,6 +291,8 @@ void container_base::add_child_to_front(std::unique_ptr<element_base> child) noe
 void container_base::add_child_to_back(std::unique_ptr<element_base> child) noexcept {
 	child->parent = this;
 	children.emplace_back(std::move(child));
+	invalidate_update_dependencies();
+	invalidate_render_cache();
 }
 element_base* container_base::get_child_by_index(sys::state const& state, int32_t index) noexcept {
 	if(0 <= index && index < int32_t(children.size()))
@@ -594,6 +694,7 @@ message_result edit_box_element_base::on_key_down(sys::state& state, sys::virtua
 }
 
 void edit_box_element_base::on_reset_text(sys::state& state) noexcept {
+	paragraphs.clear(); // fonts or scale may have changed
 	internal_on_text_changed(state);
 }
 
@@ -647,27 +748,107 @@ void edit_box_element_base::on_hover_end(sys::state& state) noexcept {
 	last_activated = std::chrono::steady_clock::now();
 	window::change_cursor(state, window::cursor_type::normal);
 }
-void edit_box_element_base::internal_on_text_changed(sys::state& state) {
-	changes_made = true;
+void edit_box_element_base::replace_text(int32_t start, int32_t end, std::u16string_view content) {
+	edit_undo_buffer.record(start, std::u16string_view(cached_text).substr(size_t(start), size_t(end - start)), content, int16_t(anchor_position), int16_t(cursor_position));
+	cached_text.replace(size_t(start), size_t(end - start), content);
+}
+void edit_box_element_base::relayout_text(sys::state& state) {
+	if(template_id == -1)
+		return;
 
-	//TODO multiline must save and restore visible line
-	if(template_id != -1) {
-		glyph_details.grapheme_placement.clear();
-		glyph_details.total_lines = 0;
+	glyph_details.grapheme_placement.clear();
+	glyph_details.total_lines = 0;
 
-		internal_layout.contents.clear();
-		internal_layout.number_of_lines = 0;
+	internal_layout.contents.clear();
+	internal_layout.number_of_lines = 0;
 
-		alice_ui::grid_size_window* par = static_cast<alice_ui::grid_size_window*>(parent);
-		auto hmargin = int32_t(state.ui_templates.button_t[template_id].primary.h_text_margins * par->grid_size);
-		auto al = alice_ui::convert_align(state.ui_templates.button_t[template_id].primary.h_text_alignment);
-		auto fh = text::make_font_id(state, state.ui_templates.button_t[template_id].primary.font_choice == 1, state.ui_templates.button_t[template_id].primary.font_scale * par->grid_size * 2);
+	alice_ui::grid_size_window* par = static_cast<alice_ui::grid_size_window*>(parent);
+	auto hmargin = int32_t(state.ui_templates.button_t[template_id].primary.h_text_margins * par->grid_size);
+	auto al = alice_ui::convert_align(state.ui_templates.button_t[template_id].primary.h_text_alignment);
+	auto fh = text::make_font_id(state, state.ui_templates.button_t[template_id].primary.font_choice == 1, state.ui_templates.button_t[template_id].primary.font_scale * par->grid_size * 2);
+	auto params = text::layout_parameters{ 0, 0, static_cast<int16_t>(base_data.size.x - hmargin * 2), static_cast<int16_t>(base_data.size.y), fh, 0, al, text::text_color::black, true, true };
+	auto rtl = state.world.locale_get_native_rtl(state.font_collection.get_current_locale()) ? text::layout_base::rtl_status::rtl : text::layout_base::rtl_status::ltr;
 
-		text::single_line_layout sl{ internal_layout, text::layout_parameters{ 0, 0, static_cast<int16_t>(base_data.size.x - hmargin * 2), static_cast<int16_t>(base_data.size.y), fh, 0, al, text::text_color::black, true, true }, state.world.locale_get_native_rtl(state.font_collection.get_current_locale()) ? text::layout_base::rtl_status::rtl : text::layout_base::rtl_status::ltr };
+	if(!multiline) {
+		paragraphs.clear();
+		text::single_line_layout sl{ internal_layout, params, rtl };
 		sl.edit_details = &glyph_details;
 		sl.add_text(state, cached_text);
+		return;
+	}
+
+	if(params.right != paragraph_parameters.right || params.bottom != paragraph_parameters.bottom || params.font_size != paragraph_parameters.font_size || params.align != paragraph_parameters.align) {
+		paragraphs.clear();
+		paragraph_parameters = params;
 	}
 
+	std::vector<std::u16string_view> pieces;
+	std::u16string_view all_text = cached_text;
+	size_t piece_start = 0;
+	while(true) {
+		auto nl = all_text.find(u'\n', piece_start);
+		if(nl == std::u16string_view::npos) {
+			pieces.push_back(all_text.substr(piece_start));
+			break;
+		}
+		pieces.push_back(all_text.substr(piece_start, nl + 1 - piece_start));
+		piece_start = nl + 1;
+	}
+
+	// an edit only changes the paragraphs between an unchanged prefix and an unchanged suffix
+	size_t prefix = 0;
+	while(prefix < pieces.size() && prefix < paragraphs.size() && paragraphs[prefix].text == pieces[prefix])
+		++prefix;
+	size_t suffix = 0;
+	while(suffix < pieces.size() - prefix && suffix < paragraphs.size() - prefix && paragraphs[paragraphs.size() - 1 - suffix].text == pieces[pieces.size() - 1 - suffix])
+		++suffix;
+
+	std::vector<paragraph_layout> updated;
+	updated.reserve(pieces.size());
+	for(size_t i = 0; i < prefix; ++i)
+		updated.push_back(std::move(paragraphs[i]));
+	for(size_t i = prefix; i < pieces.size() - suffix; ++i) {
+		updated.emplace_back();
+		auto& p = updated.back();
+		p.text = pieces[i];
+		text::single_line_layout sl{ p.layout, params, rtl };
+		sl.edit_details = &p.details;
+		sl.add_text(state, p.text);
+	}
+	for(size_t i = paragraphs.size() - suffix; i < paragraphs.size(); ++i)
+		updated.push_back(std::move(paragraphs[i]));
+	paragraphs = std::move(updated);
+
+	// stitch the paragraphs together, one per line
+	auto line_height = int32_t(state.font_collection.line_height(state, fh));
+	int32_t source_base = 0;
+	for(size_t i = 0; i < paragraphs.size(); ++i) {
+		auto& p = paragraphs[i];
+		auto grapheme_base = int16_t(glyph_details.grapheme_placement.size());
+		for(auto const& c : p.layout.contents) {
+			internal_layout.contents.push_back(c);
+			internal_layout.contents.back().y = int16_t(c.y + int32_t(i) * line_height);
+		}
+		for(auto g : p.details.grapheme_placement) {
+			g.source_offset = uint16_t(g.source_offset + source_base);
+			g.line = uint16_t(i);
+			if(g.visual_left != -1)
+				g.visual_left = int16_t(g.visual_left + grapheme_base);
+			if(g.visual_right != -1)
+				g.visual_right = int16_t(g.visual_right + grapheme_base);
+			glyph_details.grapheme_placement.push_back(g);
+		}
+		source_base += int32_t(p.text.size());
+	}
+	internal_layout.number_of_lines = int32_t(paragraphs.size());
+	glyph_details.total_lines = uint16_t(paragraphs.size());
+}
+void edit_box_element_base::internal_on_text_changed(sys::state& state) {
+	changes_made = true;
+
+	//TODO multiline must save and restore visible line
+	relayout_text(state);
+
 	// TODO accessibility integration
 	//if(acc_obj && win.is_visible(l_id)) {
 	//	win.accessibility_interface.on_text_content_changed(acc_obj);
@@ -760,19 +941,20 @@ void edit_box_element_base::insert_codepoint(sys::state& state, uint32_t codepoi
 		on_edit_command(state, edit_command::delete_selection, sys::key_modifiers::modifiers_none);
 	}
 	if(!changes_made)
-		edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+		edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 
 	auto insert_position = cursor_position < int32_t(glyph_details.grapheme_placement.size()) ?
 		std::min(int32_t(glyph_details.grapheme_placement[cursor_position].source_offset), int32_t(cached_text.length()))
 		: int32_t(cached_text.length());
 
 	if(codepoint < 0x10000) {
-		cached_text.insert(insert_position, 1, uint16_t(codepoint));
+		char16_t units[1] = { char16_t(codepoint) };
+		replace_text(insert_position, insert_position, std::u16string_view(units, 1));
 		++cursor_position;
 	} else {
 		auto p = text::make_surrogate_pair(codepoint);
-		cached_text.insert(insert_position, 1, uint16_t(p.high));
-		cached_text.insert(insert_position + 1, 1, uint16_t(p.low));
+		char16_t units[2] = { char16_t(p.high), char16_t(p.low) };
+		replace_text(insert_position, insert_position, std::u16string_view(units, 2));
 		++cursor_position;
 	}
 	anchor_position = cursor_position;
@@ -784,15 +966,13 @@ void edit_box_element_base::insert_codepoint(sys::state& state, uint32_t codepoi
 void edit_box_element_base::insert_text(sys::state& state, int32_t position_start, int32_t position_end, std::u16string_view content, insertion_source source) noexcept {
 	if(state.ui_state.edit_target_internal == this) {
 		if(!changes_made)
-			edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+			edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 	}
 
 	auto original_anchor_sp = anchor_position < int32_t(glyph_details.grapheme_placement.size()) ? int32_t(glyph_details.grapheme_placement[std::max(0, anchor_position)].source_offset) : int32_t(cached_text.size());
 	auto original_cursor_sp = cursor_position < int32_t(glyph_details.grapheme_placement.size()) ? int32_t(glyph_details.grapheme_placement[std::max(0, cursor_position)].source_offset) : int32_t(cached_text.size());
 
-	if(position_start != position_end)
-		cached_text.erase(size_t(position_start), size_t(position_end - position_start));
-	cached_text.insert(size_t(position_start), content);
+	replace_text(position_start, position_end, content);
 
 	if(int32_t(position_end) <= original_anchor_sp) {
 		original_anchor_sp += int32_t(content.length()) - int32_t(position_end - position_start);
@@ -972,7 +1152,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 			on_edit_command(state, edit_command::delete_selection, sys::key_modifiers::modifiers_none);
 		} else {
 			if(!changes_made)
-				edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+				edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 			int32_t to_erase = 0;
 			int32_t erase_count = 0;
 			if(cursor_position > int32_t(glyph_details.grapheme_placement.size()))
@@ -982,7 +1162,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 				erase_count = glyph_details.grapheme_placement[cursor_position - 1].unit_length;
 			}
 			if(to_erase != cursor_position && erase_count > 0) {
-				cached_text.erase(size_t(to_erase), size_t(erase_count));
+				replace_text(to_erase, to_erase + erase_count, std::u16string_view{});
 				auto old_cursor = cursor_position;
 				cursor_position = to_erase;
 				anchor_position = to_erase;
@@ -998,7 +1178,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 			on_edit_command(state, edit_command::delete_selection, sys::key_modifiers::modifiers_none);
 		} else {
 			if(!changes_made)
-				edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+				edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 			int32_t to_erase = 0;
 			int32_t erase_count = 0;
 			if(0 <= cursor_position && cursor_position < int32_t(glyph_details.grapheme_placement.size())) {
@@ -1006,7 +1186,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 				erase_count = glyph_details.grapheme_placement[cursor_position].unit_length;
 			}
 			if(erase_count != 0) {
-				cached_text.erase(size_t(to_erase), size_t(erase_count));
+				replace_text(to_erase, to_erase + erase_count, std::u16string_view{});
 				if(ts_obj) {
 					state.win_ptr->text_services.on_text_change(ts_obj, uint32_t(to_erase), uint32_t(to_erase + erase_count), uint32_t(to_erase));
 				}
@@ -1019,7 +1199,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 			on_edit_command(state, edit_command::delete_selection, sys::key_modifiers::modifiers_none);
 		} else {
 			if(!changes_made)
-				edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+				edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 			int32_t erase_end = 0;
 			int32_t erase_start = 0;
 			if(cursor_position >= int32_t(glyph_details.grapheme_placement.size())) {
@@ -1035,7 +1215,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 					break;
 			}
 			if(erase_start != erase_end) {
-				cached_text.erase(size_t(erase_start), size_t(erase_end - erase_start));
+				replace_text(erase_start, erase_end, std::u16string_view{});
 				anchor_position = cursor_position;
 				if(ts_obj) {
 					state.win_ptr->text_services.on_text_change(ts_obj, uint32_t(erase_start), uint32_t(erase_end), uint32_t(erase_start));
@@ -1049,7 +1229,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 			on_edit_command(state, edit_command::delete_selection, sys::key_modifiers::modifiers_none);
 		} else {
 			if(!changes_made)
-				edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+				edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 
 			int32_t erase_start = 0;
 			int32_t erase_end = 0;
@@ -1072,7 +1252,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 				++temp_cursor_position;
 			}
 			if(erase_start != erase_end) {
-				cached_text.erase(size_t(erase_start), size_t(erase_end - erase_start));
+				replace_text(erase_start, erase_end, std::u16string_view{});
 				if(ts_obj) {
 					state.win_ptr->text_services.on_text_change(ts_obj, uint32_t(erase_start), uint32_t(erase_end), uint32_t(erase_start));
 				}
@@ -1416,13 +1596,13 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 	{
 		auto old_start_position = std::min(anchor_position, cursor_position);
 		auto old_end_position = std::max(anchor_position, cursor_position);
-		edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+		edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 		bool temp_change_made = false;
 
 		if(anchor_position != cursor_position) {
 			auto start = std::min(anchor_position, cursor_position);
 			auto length = std::max(anchor_position, cursor_position) - start;
-			cached_text.erase(size_t(start), size_t(length));
+			replace_text(start, start + length, std::u16string_view{});
 			cursor_position = start;
 			anchor_position = start;
 			temp_change_made = true;
@@ -1459,7 +1639,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 			auto old_source_pos = (0 <= cursor_position && cursor_position < int32_t(glyph_details.grapheme_placement.size())) ? size_t(glyph_details.grapheme_placement[cursor_position].source_offset) : cached_text.length();
 			auto new_source_pos = old_source_pos + temp_text.length();
 
-			cached_text.insert(size_t(cursor_position), temp_text);
+			replace_text(cursor_position, cursor_position, temp_text);
 			temp_change_made = true;
 			internal_on_text_changed(state);
 
@@ -1484,12 +1664,11 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 		return;
 	case edit_command::undo:
 	{
-		auto undostate = edit_undo_buffer.undo(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
-		if(undostate.has_value()) {
-			auto old_length = cached_text.length();
-			cached_text = (*undostate).contents;
-			cursor_position = (*undostate).cursor;
-			anchor_position = (*undostate).anchor;
+		auto old_length = cached_text.length();
+		auto undostate = edit_undo_buffer.undo(cached_text, int16_t(anchor_position), int16_t(cursor_position));
+		if(undostate) {
+			cursor_position = undostate->cursor;
+			anchor_position = undostate->anchor;
 
 			internal_on_text_changed(state);
 
@@ -1501,12 +1680,11 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 	return;
 	case edit_command::redo:
 	{
-		auto redostate = edit_undo_buffer.redo(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
-		if(redostate.has_value()) {
-			auto old_length = cached_text.length();
-			cached_text = (*redostate).contents;
-			cursor_position = (*redostate).cursor;
-			anchor_position = (*redostate).anchor;
+		auto old_length = cached_text.length();
+		auto redostate = edit_undo_buffer.redo(cached_text);
+		if(redostate) {
+			cursor_position = redostate->cursor_after;
+			anchor_position = redostate->anchor_after;
 
 			internal_on_text_changed(state);
 
@@ -1580,7 +1758,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 		return;
 	case edit_command::delete_selection:
 		if(anchor_position != cursor_position) {
-			edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+			edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 
 			cursor_position = std::clamp(cursor_position, 0, int32_t(glyph_details.grapheme_placement.size()));
 			anchor_position = std::clamp(anchor_position, 0, int32_t(glyph_details.grapheme_placement.size()));
@@ -1588,7 +1766,7 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 			auto end_c = std::max(anchor_position, cursor_position);
 			auto start = (size_t(start_c) < glyph_details.grapheme_placement.size()) ? size_t(glyph_details.grapheme_placement[start_c].source_offset) : cached_text.size();
 			auto end = (size_t(end_c) < glyph_details.grapheme_placement.size()) ? size_t(glyph_details.grapheme_placement[end_c].source_offset) : cached_text.size();
-			cached_text.erase(start, end-start);
+			replace_text(int32_t(start), int32_t(end), std::u16string_view{});
 
 			cursor_position = int32_t(start_c);
 			anchor_position = int32_t(start_c);
@@ -1605,28 +1783,19 @@ void edit_box_element_base::on_edit_command(sys::state& state, edit_command comm
 void edit_box_element_base::set_text(sys::state& state, std::u16string const& new_text) {
 	if(template_id != -1) {
 		if(new_text != cached_text) {
-			alice_ui::grid_size_window* par = static_cast<alice_ui::grid_size_window*>(parent);
-			auto hmargin = state.ui_templates.button_t[template_id].primary.h_text_margins * par->grid_size;
-
-			glyph_details.grapheme_placement.clear();
-			glyph_details.total_lines = 0;
-
 			if(!changes_made)
-				edit_undo_buffer.push_state(undo_item{ cached_text, int16_t(anchor_position), int16_t(cursor_position), true });
+				edit_undo_buffer.begin_item(int16_t(anchor_position), int16_t(cursor_position));
 
-			cached_text = new_text;
-			{
-				internal_layout.contents.clear();
-				internal_layout.number_of_lines = 0;
+			// only the part between the common prefix and suffix is recorded as changed
+			size_t prefix = 0;
+			while(prefix < new_text.size() && prefix < cached_text.size() && new_text[prefix] == cached_text[prefix])
+				++prefix;
+			size_t suffix = 0;
+			while(suffix < new_text.size() - prefix && suffix < cached_text.size() - prefix && new_text[new_text.size() - 1 - suffix] == cached_text[cached_text.size() - 1 - suffix])
+				++suffix;
+			replace_text(int32_t(prefix), int32_t(cached_text.size() - suffix), std::u16string_view(new_text).substr(prefix, new_text.size() - prefix - suffix));
 
-				auto al = alice_ui::convert_align(state.ui_templates.button_t[template_id].primary.h_text_alignment);
-				auto fonthandle = text::make_font_id(state, state.ui_templates.button_t[template_id].primary.font_choice == 1, state.ui_templates.button_t[template_id].primary.font_scale * par->grid_size * 2);
-				text::single_line_layout sl{ internal_layout, text::layout_parameters{ 0, 0, static_cast<int16_t>(base_data.size.x - hmargin* 2), static_cast<int16_t>(base_data.size.y),
-							fonthandle, 0, al, text::text_color::black, true, true },
-					state.world.locale_get_native_rtl(state.font_collection.get_current_locale()) ? text::layout_base::rtl_status::rtl : text::layout_base::rtl_status::ltr };
-				sl.edit_details = &glyph_details;
-				sl.add_text(state, cached_text);
-			}
+			relayout_text(state);
 		}
 	}
 
@@ -1653,6 +1822,7 @@ void edit_box_element_base::render(sys::state& state, int32_t x, int32_t y) noex
 					state.ui_templates.backgrounds[bg_id].renders.get_render(state, float(base_data.size.x) / float(par->grid_size), float(base_data.size.y) / float(par->grid_size), int32_t(par->grid_size), state.user_settings.ui_scale));
 			}
 		} else if(ms_after.count() < alice_ui::mouse_over_animation_ms && state.ui_templates.button_t[template_id].animate_active_transition) {
+			ogl::mark_animated(state.open_gl);
 			float percentage = float(ms_after.count()) / float(alice_ui::mouse_over_animation_ms);
 			if(this == state.ui_state.under_mouse) {
 				region = state.ui_templates.button_t[template_id].active;
@@ -1942,7 +2112,9 @@ void tool_tip::render(sys::state& state, int32_t x, int32_t y) noexcept {
 
 state::state() {
 	root = std::make_unique<container_base>();
+	root->set_update_dependencies(0); // only its children read anything
 	tooltip = std::make_unique<tool_tip>();
+	tooltip->set_update_dependencies(0); // filled by populate_tooltip / update_tooltip instead
 	tooltip->flags |= element_base::is_invisible_mask;
 }
 
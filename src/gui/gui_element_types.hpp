@@ -10,6 +10,7 @@
 #include "texture.hpp"
 #include <cstdint>
 #include <vector>
+#include <deque>
 
 namespace window {
 struct text_services_object;
@@ -19,13 +20,26 @@ namespace ui {
 
 
 
+// the output of a retained subtree, see element_base::retained_render_mask
+struct retained_render_cache {
+	std::vector<ogl::recorded_quad> quads;
+	std::vector<uint32_t> svg_pages; // atlas pages the quads sample; replaying marks them used so they aren't evicted first
+	int32_t x = 0;
+	int32_t y = 0;
+	uint32_t glyph_generation = 0;
+	uint32_t svg_evictions = 0;
+};
+
 class container_base : public element_base {
 public:
 	std::vector<std::unique_ptr<element_base>> children;
+	update_mask subtree_update_dependencies = 0; // valid while update_dependencies_cached_mask is set
+	retained_render_cache render_cache;
 
 	mouse_probe impl_probe_mouse(sys::state& state, int32_t x, int32_t y, mouse_probe_type type) noexcept override;
 	message_result impl_on_key_down(sys::state& state, sys::virtual_key key, sys::key_modifiers mods) noexcept final;
 	void impl_on_update(sys::state& state) noexcept override;
+	update_mask impl_update_dependencies(sys::state& state) noexcept override;
 
 	void impl_render(sys::state& state, int32_t x, int32_t y) noexcept override;
 	void impl_on_reset_text(sys::state& state) noexcept override;
@@ -42,10 +56,17 @@ public:
 class non_owning_container_base : public element_base {
 public:
 	std::vector<element_base*> children;
+	retained_render_cache render_cache;
 
 	mouse_probe impl_probe_mouse(sys::state& state, int32_t x, int32_t y, mouse_probe_type type) noexcept override;
 	message_result impl_on_key_down(sys::state& state, sys::virtual_key key, sys::key_modifiers mods) noexcept final;
 	void impl_on_update(sys::state& state) noexcept override;
+	update_mask impl_update_dependencies(sys::state& state) noexcept override { // children are swapped in and out freely, so nothing is cached
+		update_mask result = update_dependencies;
+		for(auto c : children)
+			result |= c->impl_update_dependencies(state);
+		return result;
+	}
 
 	void impl_render(sys::state& state, int32_t x, int32_t y) noexcept override;
 	void impl_on_reset_text(sys::state& state) noexcept override;
@@ -59,71 +80,107 @@ public:
 
 class edit_box_element_base : public element_base {
 protected:
+	// replacement of removed, starting at position, by inserted
+	struct text_edit {
+		int32_t position = 0;
+		std::u16string removed;
+		std::u16string inserted;
+	};
+
+	// the edits of one editing session, undone and redone together
 	struct undo_item {
-		std::u16string contents;
-		int16_t anchor = 0;
+		std::vector<text_edit> edits;
+		int16_t anchor = 0; // selection before the first edit
 		int16_t cursor = 0;
-		bool valid = false;
-
-		bool operator==(undo_item const& o) const noexcept {
-			return contents == o.contents;
-		}
-		bool operator!=(undo_item const& o) const noexcept {
-			return !(*this == o);
-		}
+		int16_t anchor_after = 0; // selection when the item was undone
+		int16_t cursor_after = 0;
 	};
 
+	// keeps the changes made to the text rather than copies of it
 	struct undo_buffer {
 		constexpr static int32_t total_size = 16;
 
-		undo_item interal_buffer[total_size] = {};
-		int32_t buffer_position = 0;
-
-		std::optional<undo_item> undo(undo_item current_state) {
-			push_state(current_state);
-
-			auto temp_back = buffer_position - 1;
-			if(temp_back < 0) {
-				temp_back += total_size;
-			}
-
-			if(interal_buffer[temp_back].valid) {
-				buffer_position = temp_back;
-				return interal_buffer[temp_back];
-			}
-			return std::optional<undo_item>{};
+		std::deque<undo_item> done;
+		std::vector<undo_item> undone;
+		bool item_open = false;
+		bool item_requested = false;
+		int16_t requested_anchor = 0;
+		int16_t requested_cursor = 0;
+
+		// the next edit starts a new item, remembering this selection
+		void begin_item(int16_t anchor, int16_t cursor) {
+			item_requested = true;
+			requested_anchor = anchor;
+			requested_cursor = cursor;
 		}
-		std::optional<undo_item> redo(undo_item current_state) {
-			if(interal_buffer[buffer_position] == current_state) {
-				auto temp_back = buffer_position + 1;
-				if(temp_back >= total_size) {
-					temp_back -= total_size;
+		void record(int32_t position, std::u16string_view removed, std::u16string_view inserted, int16_t anchor, int16_t cursor) {
+			undone.clear();
+			if(item_requested || !item_open || done.empty()) {
+				if(int32_t(done.size()) >= total_size)
+					done.pop_front();
+				done.emplace_back();
+				done.back().anchor = item_requested ? requested_anchor : anchor;
+				done.back().cursor = item_requested ? requested_cursor : cursor;
+				item_open = true;
+				item_requested = false;
+			}
+			auto& edits = done.back().edits;
+			if(!edits.empty()) {
+				auto& last = edits.back();
+				auto last_end = last.position + int32_t(last.inserted.size());
+				if(removed.empty() && position == last_end) { // typing
+					last.inserted.append(inserted);
+					return;
 				}
-				if(interal_buffer[temp_back].valid) {
-					buffer_position = temp_back;
-					return interal_buffer[buffer_position];
+				if(inserted.empty() && last.position <= position && position + int32_t(removed.size()) == last_end) { // erasing what was just typed
+					last.inserted.erase(size_t(position - last.position));
+					return;
+				}
+				if(inserted.empty() && last.inserted.empty() && position + int32_t(removed.size()) == last.position) { // backspacing
+					last.removed.insert(0, removed);
+					last.position = position;
+					return;
 				}
 			}
-			return std::optional<undo_item>{};
+			edits.push_back(text_edit{ position, std::u16string(removed), std::u16string(inserted) });
 		}
-		void push_state(undo_item state) {
-			if(interal_buffer[buffer_position].valid == false || interal_buffer[buffer_position] != state) {
-				++buffer_position;
-				if(buffer_position >= total_size) {
-					buffer_position -= total_size;
-				}
-				interal_buffer[buffer_position] = state;
-				interal_buffer[buffer_position].valid = true;
-
-				auto temp_next = buffer_position + 1;
-				if(temp_next >= total_size) {
-					temp_next -= total_size;
-				}
-				interal_buffer[temp_next].valid = false;
+		undo_item const* undo(std::u16string& text, int16_t anchor, int16_t cursor) {
+			if(done.empty())
+				return nullptr;
+			undone.push_back(std::move(done.back()));
+			done.pop_back();
+			auto& item = undone.back();
+			item.anchor_after = anchor;
+			item.cursor_after = cursor;
+			for(auto it = item.edits.rbegin(); it != item.edits.rend(); ++it) {
+				text.replace(size_t(it->position), it->inserted.size(), it->removed);
+			}
+			item_open = false;
+			return &item;
+		}
+		undo_item const* redo(std::u16string& text) {
+			if(undone.empty())
+				return nullptr;
+			done.push_back(std::move(undone.back()));
+			undone.pop_back();
+			auto& item = done.back();
+			for(auto& e : item.edits) {
+				text.replace(size_t(e.position), e.removed.size(), e.inserted);
 			}
+			item_open = false;
+			return &item;
 		}
 	} edit_undo_buffer;
 
+	// multiline boxes lay out each paragraph on its own line and keep the result until the paragraph's text changes
+	struct paragraph_layout {
+		std::u16string text; // including the terminating new line, if any
+		text::layout layout;
+		text::layout_details details;
+	};
+	std::vector<paragraph_layout> paragraphs;
+	text::layout_parameters paragraph_parameters;
+
 	std::u16string cached_text;
 	text::layout internal_layout;
 
@@ -146,6 +203,9 @@ protected:
 	bool changes_made = false;
 
 	void insert_codepoint(sys::state& state, uint32_t codepoint, sys::key_modifiers mods);
+	// replaces [start, end) of the text, recording the change for undo
+	void replace_text(int32_t start, int32_t end, std::u16string_view content);
+	void relayout_text(sys::state& state);
 	void internal_on_text_changed(sys::state& state);
 	void internal_on_selection_changed(sys::state& state);
 	void internal_move_cursor_to_point(sys::state& state, int32_t x, int32_t y, bool extend_selection);
@@ -204,7 +264,7 @@ public:
 
 void render_text_chunk(
 	sys::state& state,
-	text::text_chunk t,
+	text::text_chunk const& t,
 	float x,
 	float baseline_y,
 	uint16_t font_id,
@@ -103,10 +103,22 @@ message_result element_base::impl_on_mouse_move(sys::state& state, int32_t x, in
 	return on_mouse_move(state, x, y, mods);
 }
 void element_base::impl_on_update(sys::state& state) noexcept {
-	on_update(state);
+	++state.ui_state.update_elements_visited;
+	if((update_dependencies & state.ui_state.update_pass_topics) != 0) {
+		++state.ui_state.update_elements_updated;
+		on_update(state);
+		invalidate_render_cache();
+	}
+}
+void element_base::force_update(sys::state& state) noexcept {
+	auto pass_topics = state.ui_state.update_pass_topics;
+	state.ui_state.update_pass_topics = update_topic::all;
+	impl_on_update(state);
+	state.ui_state.update_pass_topics = pass_topics;
 }
 void element_base::impl_on_reset_text(sys::state& state) noexcept {
 	on_reset_text(state);
+	invalidate_render_cache();
 }
 
 message_result element_base::test_mouse(sys::state& state, int32_t x, int32_t y, mouse_probe_type t) noexcept {
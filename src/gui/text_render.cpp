@@ -5,7 +5,7 @@ namespace ui {
 void render_text_chunk(
 	text::font_manager& font_collection,
         ogl::data& state,
-	text::text_chunk t,
+	text::text_chunk const& t,
 	float x,
 	float baseline_y,
 	uint16_t font_size,
@@ -32,7 +32,7 @@ void render_text_chunk(
                         state,
                         font_collection,
                         current_font,
-                        t.unicodechars,
+                        t.unicodechars.glyph_info,
                         cmod,
                         x,
                         baseline_y,
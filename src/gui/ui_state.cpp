@@ -50,44 +50,8 @@ void state::update_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, int
 	if(!last_tooltip) return;
 	if(!tooltip->is_visible()) return;
 
-	auto type = last_tooltip->has_tooltip(state);
-	if(type != ui::tooltip_behavior::position_sensitive_tooltip) {
-		auto container = text::create_columnar_layout(
-			state,
-			tooltip->internal_layout,
-			text::layout_parameters{
-				0, 0,
-				tooltip_width,
-				max_height,
-				default_body_font,
-				0,
-				text::alignment::left,
-				text::text_color::white,
-				true
-			},
-			10
-		);
-		last_tooltip->update_tooltip(state, tooltip_probe.relative_location.x, tooltip_probe.relative_location.y,
-				container);
-		if(container.native_rtl == text::layout_base::rtl_status::rtl) {
-			container.used_width = -container.used_width;
-			for(auto& t : container.base_layout.contents) {
-				t.x += 16 + container.used_width;
-				t.y += 16;
-			}
-		} else {
-			for(auto& t : container.base_layout.contents) {
-				t.x += 16;
-				t.y += 16;
-			}
-		}
-		tooltip->base_data.size.x = int16_t(container.used_width + 32);
-		tooltip->base_data.size.y = int16_t(container.used_height + 32);
-		if(container.used_width > 0)
-			tooltip->set_visible(state, true);
-		else
-			tooltip->set_visible(state, false);
-	}
+	if(last_tooltip->has_tooltip(state) != ui::tooltip_behavior::position_sensitive_tooltip)
+		show_cached_tooltip(state, tooltip_probe, tooltip_sub_index, max_height);
 }
 
 
@@ -99,41 +63,10 @@ void state::populate_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, i
 
 		if(tooltip_probe.under_mouse) {
 			auto type = last_tooltip->has_tooltip(state);
-			if(type != ui::tooltip_behavior::no_tooltip) {
-				auto container = text::create_columnar_layout(state, tooltip->internal_layout,
-					text::layout_parameters{
-						0, 0, tooltip_width, max_height,
-						default_body_font, 0,
-						text::alignment::left,
-						text::text_color::white,
-						true
-					},
-					10
-				);
-				last_tooltip->update_tooltip(
-					state,
-					tooltip_probe.relative_location.x,
-					tooltip_probe.relative_location.y,
-					container
-				);
-				if(container.native_rtl == text::layout_base::rtl_status::rtl) {
-					container.used_width = -container.used_width;
-					for(auto& t : container.base_layout.contents) {
-						t.x += 16 + container.used_width;
-						t.y += 16;
-					}
-				} else {
-					for(auto& t : container.base_layout.contents) {
-						t.x += 16;
-						t.y += 16;
-					}
-				}
-				tooltip->base_data.size.x = int16_t(container.used_width + 32);
-				tooltip->base_data.size.y = int16_t(container.used_height + 32);
-				if(container.used_width > 0)
-					tooltip->set_visible(state, true);
-				else
-					tooltip->set_visible(state, false);
+			if(type == ui::tooltip_behavior::position_sensitive_tooltip) {
+				layout_tooltip(state, tooltip_probe, max_height);
+			} else if(type != ui::tooltip_behavior::no_tooltip) {
+				show_cached_tooltip(state, tooltip_probe, tooltip_sub_index, max_height);
 			} else {
 				tooltip->set_visible(state, false);
 			}
@@ -141,38 +74,83 @@ void state::populate_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, i
 			tooltip->set_visible(state, false);
 		}
 	} else if(last_tooltip && last_tooltip->has_tooltip(state) == ui::tooltip_behavior::position_sensitive_tooltip) {
-		auto container = text::create_columnar_layout(
-			state,
-			tooltip->internal_layout,
-			text::layout_parameters{
-				0, 0, tooltip_width, max_height,
-				default_body_font, 0,
-				text::alignment::left,
-				text::text_color::white,
-				true
-			},
-			10
-		);
-		last_tooltip->update_tooltip(state, tooltip_probe.relative_location.x, tooltip_probe.relative_location.y, container);
-		if(container.native_rtl == text::layout_base::rtl_status::rtl) {
-			container.used_width = -container.used_width;
-			for(auto& t : container.base_layout.contents) {
-				t.x += 16 + container.used_width;
-				t.y += 16;
-			}
-		} else {
-			for(auto& t : container.base_layout.contents) {
-				t.x += 16;
-				t.y += 16;
-			}
+		layout_tooltip(state, tooltip_probe, max_height);
+	}
+}
+
+void state::layout_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, int16_t max_height) {
+	auto container = text::create_columnar_layout(
+		state,
+		tooltip->internal_layout,
+		text::layout_parameters{
+			0, 0, tooltip_width, max_height,
+			default_body_font, 0,
+			text::alignment::left,
+			text::text_color::white,
+			true
+		},
+		10
+	);
+	last_tooltip->update_tooltip(state, tooltip_probe.relative_location.x, tooltip_probe.relative_location.y, container);
+	if(container.native_rtl == text::layout_base::rtl_status::rtl) {
+		container.used_width = -container.used_width;
+		for(auto& t : container.base_layout.contents) {
+			t.x += 16 + container.used_width;
+			t.y += 16;
+		}
+	} else {
+		for(auto& t : container.base_layout.contents) {
+			t.x += 16;
+			t.y += 16;
+		}
+	}
+	tooltip->base_data.size.x = int16_t(container.used_width + 32);
+	tooltip->base_data.size.y = int16_t(container.used_height + 32);
+	if(container.used_width > 0)
+		tooltip->set_visible(state, true);
+	else
+		tooltip->set_visible(state, false);
+}
+
+// tooltips that don't follow the mouse within their element are reused from the cache while nothing they show could have changed
+void state::show_cached_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, int32_t tooltip_sub_index, int16_t max_height) {
+	tooltip_cache_key key{
+		last_tooltip,
+		tooltip_sub_index,
+		state.tick_end_counter.load(std::memory_order::acquire),
+		probe_generation,
+		state.user_settings.ui_scale,
+		state.font_collection.get_current_locale(),
+		max_height
+	};
+	++tooltip_cache_clock;
+	for(auto& e : tooltip_cache) {
+		if(e.key == key) {
+			e.last_used = tooltip_cache_clock;
+			tooltip->internal_layout = e.layout;
+			tooltip->base_data.size = e.size;
+			tooltip->set_visible(state, e.visible);
+			return;
+		}
+	}
+
+	layout_tooltip(state, tooltip_probe, max_height);
+
+	tooltip_cache_entry* slot = nullptr;
+	if(tooltip_cache.size() < tooltip_cache_size) {
+		slot = &tooltip_cache.emplace_back();
+	} else {
+		slot = &tooltip_cache[0];
+		for(auto& e : tooltip_cache) {
+			if(e.last_used < slot->last_used)
+				slot = &e;
 		}
-		tooltip->base_data.size.x = int16_t(container.used_width + 32);
-		tooltip->base_data.size.y = int16_t(container.used_height + 32);
-		if(container.used_width > 0)
-			tooltip->set_visible(state, true);
-		else
-			tooltip->set_visible(state, false);
 	}
+	slot->key = key;
+	slot->layout = tooltip->internal_layout;
+	slot->size = tooltip->base_data.size;
+	slot->visible = tooltip->is_visible();
+	slot->last_used = tooltip_cache_clock;
 }
 
 void state::reposition_tooltip(ui::urect tooltip_bounds, int16_t root_height, int16_t root_width) {
@@ -5,6 +5,28 @@
 
 namespace ui {
 
+// everything a finished tooltip layout depends on besides the element's own state, which can only change
+// through a tick, a command or an input event: all of those advance tick or probe_generation
+struct tooltip_cache_key {
+	element_base* element = nullptr;
+	int32_t sub_index = -1;
+	int64_t tick = 0;
+	uint32_t probe_generation = 0;
+	float ui_scale = 0.0f;
+	dcon::locale_id locale;
+	int16_t max_height = 0;
+
+	bool operator==(tooltip_cache_key const& other) const = default;
+};
+
+struct tooltip_cache_entry {
+	tooltip_cache_key key;
+	text::layout layout;
+	xy_pair size = xy_pair{ 0, 0 };
+	bool visible = false;
+	uint32_t last_used = 0;
+};
+
 struct state {
 	element_base* under_mouse = nullptr;
 	element_base* left_mouse_hold_target = nullptr;
@@ -51,6 +73,36 @@ struct state {
 	uint16_t default_body_font = 0;
 	bool ctrl_held_down = false;
 	bool shift_held_down = false;
+
+	// hit test results from the last frame, reused while the mouse stays put and no event could have changed the element tree
+	ui::mouse_probe last_mouse_probe{ nullptr, xy_pair{ 0, 0 } };
+	ui::mouse_probe last_tooltip_probe{ nullptr, xy_pair{ 0, 0 } };
+	element_base* last_probe_root = nullptr;
+	int32_t last_probe_x = 0;
+	int32_t last_probe_y = 0;
+	bool mouse_probe_invalid = true;
+	uint32_t probe_generation = 0; // advanced by every invalidation, so anything keyed on it is dropped after input
+
+	void invalidate_mouse_probe() {
+		mouse_probe_invalid = true;
+		++probe_generation;
+	}
+
+	// recently shown tooltips, so moving back and forth over the rows of a table doesn't lay them out again
+	static constexpr size_t tooltip_cache_size = 16;
+	std::vector<tooltip_cache_entry> tooltip_cache;
+	uint32_t tooltip_cache_clock = 0;
+
+	// topics refreshed by the update pass in progress; everything outside of a pass
+	update_mask update_pass_topics = update_topic::all;
+	// elements entered / elements whose on_update ran since the start of the last update pass
+	uint32_t update_elements_visited = 0;
+	uint32_t update_elements_updated = 0;
+	// debug builds only: heap allocations made by the last call to state::render, and the number of frames in a row
+	// without updates, mouse probes or uploads; once that reaches warm_frames a frame must not allocate at all
+	uint32_t render_heap_allocations = 0;
+	uint32_t quiet_frames = 0;
+	static constexpr uint32_t warm_frames = 120;
 	
 
 	void set_mouse_sensitive_target(sys::state& state, element_base* target);
@@ -59,6 +111,8 @@ struct state {
 	void populate_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, int32_t tooltip_sub_index, int16_t max_height);
 	void reposition_tooltip(ui::urect tooltip_bounds, int16_t root_height, int16_t root_width);
 	void render_tooltip(sys::state& state, bool follow_mouse, int32_t mouse_x, int32_t mouse_y, int32_t screen_size_x, int32_t screen_size_y, float ui_scale);
+	void layout_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, int16_t max_height);
+	void show_cached_tooltip(sys::state& state, ui::mouse_probe tooltip_probe, int32_t tooltip_sub_index, int16_t max_height);
 
 	state();
 	~state();
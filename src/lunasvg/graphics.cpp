@@ -1,6 +1,7 @@
 #include "graphics.h"
 #include "lunasvg.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 
@@ -648,7 +649,14 @@ void Canvas::convertToLuminanceMask()
     auto height = plutovg_surface_get_height(m_surface);
     auto stride = plutovg_surface_get_stride(m_surface);
     auto data = plutovg_surface_get_data(m_surface);
-    for(int y = 0; y < height; y++) {
+    int top = 0;
+    int bottom = height;
+    if(m_banded) {
+        top = std::clamp(m_bandY - m_y, 0, height);
+        bottom = std::clamp(m_bandY + m_bandHeight - m_y, top, height);
+    }
+
+    for(int y = top; y < bottom; y++) {
         auto pixels = reinterpret_cast<uint32_t*>(data + stride * y);
         for(int x = 0; x < width; x++) {
             auto pixel = pixels[x];
@@ -668,6 +676,26 @@ void Canvas::convertToLuminanceMask()
     }
 }
 
+void Canvas::clipToBand(int y, int height)
+{
+    m_banded = true;
+    m_bandY = y;
+    m_bandHeight = height;
+    // a whole row clip gives every span full coverage, so intersecting with it leaves the coverage of the band rows as is
+    int top = std::clamp(y - m_y, 0, this->height());
+    int bottom = std::clamp(y + height - m_y, top, this->height());
+    plutovg_canvas_reset_matrix(m_canvas);
+    plutovg_canvas_set_fill_rule(m_canvas, PLUTOVG_FILL_RULE_NON_ZERO);
+    plutovg_canvas_clip_rect(m_canvas, 0.f, float(top), float(width()), float(bottom - top));
+}
+
+void Canvas::inheritBand(const Canvas& parent)
+{
+    if(parent.m_banded) {
+        clipToBand(parent.m_bandY, parent.m_bandHeight);
+    }
+}
+
 Canvas::~Canvas()
 {
     plutovg_canvas_destroy(m_canvas);
@@ -535,6 +535,11 @@ public:
 
     void convertToLuminanceMask();
 
+    // restricts all drawing to the bitmap rows [y, y + height), by clipping every span against that band;
+    // a group or mask canvas created while rendering a band takes the band over from its parent with inheritBand
+    void clipToBand(int y, int height);
+    void inheritBand(const Canvas& parent);
+
     int x() const { return m_x; }
     int y() const { return m_y; }
     int width() const;
@@ -555,6 +560,9 @@ private:
     plutovg_matrix_t m_translation;
     const int m_x;
     const int m_y;
+    bool m_banded = false;
+    int m_bandY = 0;
+    int m_bandHeight = 0;
 };
 
 } // namespace lunasvg
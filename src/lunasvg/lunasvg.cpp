@@ -481,6 +481,16 @@ void Document::render(Bitmap& bitmap, const Matrix& matrix) const
     rootElement(true)->render(state);
 }
 
+void Document::render(Bitmap& bitmap, const Matrix& matrix, int bandY, int bandHeight) const
+{
+    if(bitmap.isNull())
+        return;
+    auto canvas = Canvas::create(bitmap);
+    canvas->clipToBand(bandY, bandHeight);
+    SVGRenderState state(nullptr, nullptr, matrix, SVGRenderMode::Painting, canvas);
+    rootElement(true)->render(state);
+}
+
 Bitmap Document::renderToBitmap(int width, int height, uint32_t backgroundColor) const
 {
     auto intrinsicWidth = rootElement(true)->intrinsicWidth();
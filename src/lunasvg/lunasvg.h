@@ -743,6 +743,18 @@ public:
      */
     void render(Bitmap& bitmap, const Matrix& matrix = Matrix()) const;
 
+    /**
+     * @brief Renders only the rows [bandY, bandY + bandHeight) of the bitmap, leaving the other rows untouched.
+     * The rows come out exactly as a full render would draw them.
+     * Bands of one document may be rendered from several threads at once, but only after a render has
+     * filled the lazily computed bounding boxes; rendering a band of height zero does that cheaply.
+     * @param bitmap The bitmap to render onto.
+     * @param matrix The root transformation matrix.
+     * @param bandY The first row of the band.
+     * @param bandHeight The number of rows in the band.
+     */
+    void render(Bitmap& bitmap, const Matrix& matrix, int bandY, int bandHeight) const;
+
     /**
      * @brief Renders the document to a bitmap with specified dimensions.
      * @param width The desired width in pixels, or -1 to auto-scale based on the intrinsic size.
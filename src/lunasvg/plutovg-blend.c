@@ -182,27 +182,40 @@ static inline uint32_t gradient_pixel(const gradient_data_t* gradient, float pos
     return gradient->colortable[gradient_clamp(gradient, ipos)];
 }
 
-static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+// position in color table units of the first pixel and the step per pixel
+static inline void linear_gradient_start(const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, float* t, float* inc)
 {
-    float t, inc;
-    float rx = 0, ry = 0;
-
     if(v->l == 0.f) {
-        t = inc = 0;
+        *t = *inc = 0;
     } else {
-        rx = gradient->matrix.c * (y + 0.5f) + gradient->matrix.a * (x + 0.5f) + gradient->matrix.e;
-        ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.b * (x + 0.5f) + gradient->matrix.f;
-        t = v->dx * rx + v->dy * ry + v->off;
-        inc = v->dx * gradient->matrix.a + v->dy * gradient->matrix.b;
-        t *= (COLOR_TABLE_SIZE - 1);
-        inc *= (COLOR_TABLE_SIZE - 1);
+        float rx = gradient->matrix.c * (y + 0.5f) + gradient->matrix.a * (x + 0.5f) + gradient->matrix.e;
+        float ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.b * (x + 0.5f) + gradient->matrix.f;
+        *t = (v->dx * rx + v->dy * ry + v->off) * (COLOR_TABLE_SIZE - 1);
+        *inc = (v->dx * gradient->matrix.a + v->dy * gradient->matrix.b) * (COLOR_TABLE_SIZE - 1);
     }
+}
+
+static inline bool linear_gradient_is_constant(float inc)
+{
+    return inc > -1e-5f && inc < 1e-5f;
+}
+
+// whether the whole span fits the fixed point stepping
+static inline bool linear_gradient_fits_fixed(float t, float inc, int length)
+{
+    return t + inc * length < (float)(INT_MAX >> (FIXPT_BITS + 1)) && t + inc * length > (float)(INT_MIN >> (FIXPT_BITS + 1));
+}
+
+static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    float t, inc;
+    linear_gradient_start(v, gradient, y, x, &t, &inc);
 
     const uint32_t* end = buffer + length;
-    if(inc > -1e-5f && inc < 1e-5f) {
+    if(linear_gradient_is_constant(inc)) {
         plutovg_memfill32(buffer, length, gradient_pixel_fixed(gradient, (int)(t * FIXPT_SIZE)));
     } else {
-        if(t + inc * length < (float)(INT_MAX >> (FIXPT_BITS + 1)) && t + inc * length > (float)(INT_MIN >> (FIXPT_BITS + 1))) {
+        if(linear_gradient_fits_fixed(t, inc, length)) {
             int t_fixed = (int)(t * FIXPT_SIZE);
             int inc_fixed = (int)(inc * FIXPT_SIZE);
             while(buffer < end) {
@@ -220,13 +233,17 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
     }
 }
 
-static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+// the discriminant and its forward differences along the span, so that each pixel only needs a square root
+typedef struct {
+    float det;
+    float delta_det;
+    float delta_delta_det;
+    float b;
+    float delta_b;
+} radial_gradient_step_t;
+
+static void radial_gradient_start(radial_gradient_step_t* step, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x)
 {
-    if(v->a == 0.f) {
-        plutovg_memfill32(buffer, length, 0);
-        return;
-    }
-
     float rx = gradient->matrix.c * (y + 0.5f) + gradient->matrix.e + gradient->matrix.a * (x + 0.5f);
     float ry = gradient->matrix.d * (y + 0.5f) + gradient->matrix.f + gradient->matrix.b * (x + 0.5f);
 
@@ -255,9 +272,20 @@ static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values
 
     inv_a *= inv_a;
 
-    float det = (bb - 4 * v->a * (v->sqrfr - rxrxryry)) * inv_a;
-    float delta_det = (b_delta_b + delta_bb + 4 * v->a * (rx_plus_ry + delta_rxrxryry)) * inv_a;
-    float delta_delta_det = (delta_b_delta_b + 4 * v->a * delta_rx_plus_ry) * inv_a;
+    step->det = (bb - 4 * v->a * (v->sqrfr - rxrxryry)) * inv_a;
+    step->delta_det = (b_delta_b + delta_bb + 4 * v->a * (rx_plus_ry + delta_rxrxryry)) * inv_a;
+    step->delta_delta_det = (delta_b_delta_b + 4 * v->a * delta_rx_plus_ry) * inv_a;
+    step->b = b;
+    step->delta_b = delta_b;
+}
+
+static void radial_gradient_span(uint32_t* buffer, int length, const radial_gradient_values_t* v, const gradient_data_t* gradient, const radial_gradient_step_t* step)
+{
+    float det = step->det;
+    float delta_det = step->delta_det;
+    float delta_delta_det = step->delta_delta_det;
+    float b = step->b;
+    float delta_b = step->delta_b;
 
     const uint32_t* end = buffer + length;
     if(v->extended) {
@@ -286,6 +314,18 @@ static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values
     }
 }
 
+static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.f) {
+        plutovg_memfill32(buffer, length, 0);
+        return;
+    }
+
+    radial_gradient_step_t step;
+    radial_gradient_start(&step, v, gradient, y, x);
+    radial_gradient_span(buffer, length, v, gradient, &step);
+}
+
 static void composition_solid_clear(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
 {
     if(const_alpha == 255) {
@@ -635,9 +675,553 @@ static const composition_function_t composition_table[] = {
     composition_xor
 };
 
+typedef void(*fetch_linear_gradient_function_t)(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length);
+typedef void(*fetch_radial_gradient_function_t)(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length);
+
+// the span functions that have vector versions, picked once for the cpu we run on
+typedef struct {
+    composition_solid_function_t solid_source;
+    composition_solid_function_t solid_source_over;
+    composition_function_t source;
+    composition_function_t source_over;
+    fetch_linear_gradient_function_t fetch_linear_gradient;
+    fetch_radial_gradient_function_t fetch_radial_gradient;
+} blend_kernels_t;
+
+static const blend_kernels_t blend_kernels_scalar = {
+    composition_solid_source,
+    composition_solid_source_over,
+    composition_source,
+    composition_source_over,
+    fetch_linear_gradient,
+    fetch_radial_gradient
+};
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PLUTOVG_BLEND_X86
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+
+// the vector functions are compiled for their own instruction set whatever the rest of the file is built for
+#if defined(__GNUC__) || defined(__clang__)
+#define PLUTOVG_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define PLUTOVG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PLUTOVG_TARGET_SSE41
+#define PLUTOVG_TARGET_AVX2
+#endif
+
+// the 16 bit lanes of x hold channel * factor products; divides them by 255 the same way BYTE_MUL does
+static inline PLUTOVG_TARGET_SSE41 __m128i div255_epi16_sse41(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_srli_epi16(x, 8));
+    x = _mm_add_epi16(x, _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(x, 8);
+}
+
+// BYTE_MUL for four pixels; a_lo and a_hi hold one 16 bit factor per channel of the first and last two pixels
+static inline PLUTOVG_TARGET_SSE41 __m128i byte_mul_sse41(__m128i x, __m128i a_lo, __m128i a_hi)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = div255_epi16_sse41(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), a_lo));
+    __m128i hi = div255_epi16_sse41(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), a_hi));
+    return _mm_packus_epi16(lo, hi);
+}
+
+// INTERPOLATE_PIXEL for four pixels with the same pair of factors, a + b must not exceed 255
+static inline PLUTOVG_TARGET_SSE41 __m128i interpolate_pixel_sse41(__m128i x, __m128i a, __m128i y, __m128i b)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), a), _mm_mullo_epi16(_mm_unpacklo_epi8(y, zero), b));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), a), _mm_mullo_epi16(_mm_unpackhi_epi8(y, zero), b));
+    return _mm_packus_epi16(div255_epi16_sse41(lo), div255_epi16_sse41(hi));
+}
+
+// s + BYTE_MUL(d, alpha(~s)) for four pixels
+static inline PLUTOVG_TARGET_SSE41 __m128i source_over_sse41(__m128i s, __m128i d)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i inverse = _mm_xor_si128(s, _mm_set1_epi32(-1));
+    __m128i ia_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpacklo_epi8(inverse, zero), 0xff), 0xff);
+    __m128i ia_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(_mm_unpackhi_epi8(inverse, zero), 0xff), 0xff);
+    return _mm_add_epi32(s, byte_mul_sse41(d, ia_lo, ia_hi));
+}
+
+static inline PLUTOVG_TARGET_SSE41 __m128i gradient_clamp_sse41(plutovg_spread_method_t spread, __m128i ipos)
+{
+    if(spread == PLUTOVG_SPREAD_METHOD_REPEAT)
+        return _mm_and_si128(ipos, _mm_set1_epi32(COLOR_TABLE_SIZE - 1));
+    if(spread == PLUTOVG_SPREAD_METHOD_REFLECT) {
+        ipos = _mm_and_si128(ipos, _mm_set1_epi32(COLOR_TABLE_SIZE * 2 - 1));
+        __m128i reflected = _mm_sub_epi32(_mm_set1_epi32(COLOR_TABLE_SIZE * 2 - 1), ipos);
+        return _mm_blendv_epi8(ipos, reflected, _mm_cmpgt_epi32(ipos, _mm_set1_epi32(COLOR_TABLE_SIZE - 1)));
+    }
+    return _mm_min_epi32(_mm_max_epi32(ipos, _mm_setzero_si128()), _mm_set1_epi32(COLOR_TABLE_SIZE - 1));
+}
+
+static inline PLUTOVG_TARGET_SSE41 void gradient_lookup_sse41(uint32_t* buffer, const gradient_data_t* gradient, __m128i ipos)
+{
+    buffer[0] = gradient->colortable[_mm_cvtsi128_si32(ipos)];
+    buffer[1] = gradient->colortable[_mm_extract_epi32(ipos, 1)];
+    buffer[2] = gradient->colortable[_mm_extract_epi32(ipos, 2)];
+    buffer[3] = gradient->colortable[_mm_extract_epi32(ipos, 3)];
+}
+
+// dest = color + BYTE_MUL(dest, ialpha)
+static PLUTOVG_TARGET_SSE41 void solid_span_sse41(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    __m128i c = _mm_set1_epi32((int)color);
+    __m128i a = _mm_set1_epi16((short)ialpha);
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi32(c, byte_mul_sse41(d, a, a)));
+    }
+    for(; i < length; i++) {
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+    }
+}
+
+static PLUTOVG_TARGET_SSE41 void composition_solid_source_sse41(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        plutovg_memfill32(dest, length, color);
+    } else {
+        solid_span_sse41(dest, length, BYTE_MUL(color, const_alpha), 255 - const_alpha);
+    }
+}
+
+static PLUTOVG_TARGET_SSE41 void composition_solid_source_over_sse41(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        color = BYTE_MUL(color, const_alpha);
+    solid_span_sse41(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+static PLUTOVG_TARGET_SSE41 void composition_source_sse41(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memcpy(dest, src, length * sizeof(uint32_t));
+        return;
+    }
+
+    __m128i a = _mm_set1_epi16((short)const_alpha);
+    __m128i ia = _mm_set1_epi16((short)(255 - const_alpha));
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), interpolate_pixel_sse41(s, a, d, ia));
+    }
+    composition_source(dest + i, length - i, src + i, const_alpha);
+}
+
+static PLUTOVG_TARGET_SSE41 void composition_source_over_sse41(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+    int i = 0;
+    if(const_alpha == 255) {
+        for(; i + 4 <= length; i += 4) {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            if(_mm_testz_si128(s, s))
+                continue;
+            if(_mm_testc_si128(s, alpha_mask)) {
+                _mm_storeu_si128((__m128i*)(dest + i), s);
+                continue;
+            }
+            __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+            _mm_storeu_si128((__m128i*)(dest + i), source_over_sse41(s, d));
+        }
+    } else {
+        __m128i a = _mm_set1_epi16((short)const_alpha);
+        for(; i + 4 <= length; i += 4) {
+            __m128i s = byte_mul_sse41(_mm_loadu_si128((const __m128i*)(src + i)), a, a);
+            __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+            _mm_storeu_si128((__m128i*)(dest + i), source_over_sse41(s, d));
+        }
+    }
+    composition_source_over(dest + i, length - i, src + i, const_alpha);
+}
+
+static PLUTOVG_TARGET_SSE41 void fetch_linear_gradient_sse41(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    float t, inc;
+    linear_gradient_start(v, gradient, y, x, &t, &inc);
+    if(linear_gradient_is_constant(inc) || !linear_gradient_fits_fixed(t, inc, length)) {
+        fetch_linear_gradient(buffer, v, gradient, y, x, length);
+        return;
+    }
+
+    int t_fixed = (int)(t * FIXPT_SIZE);
+    int inc_fixed = (int)(inc * FIXPT_SIZE);
+    __m128i pos = _mm_add_epi32(_mm_set1_epi32(t_fixed), _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(inc_fixed)));
+    __m128i step = _mm_set1_epi32((int)((uint32_t)inc_fixed * 4));
+    __m128i half = _mm_set1_epi32(FIXPT_SIZE / 2);
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128i ipos = _mm_srai_epi32(_mm_add_epi32(pos, half), FIXPT_BITS);
+        gradient_lookup_sse41(buffer + i, gradient, gradient_clamp_sse41(gradient->spread, ipos));
+        pos = _mm_add_epi32(pos, step);
+    }
+    for(t_fixed = _mm_cvtsi128_si32(pos); i < length; i++) {
+        buffer[i] = gradient_pixel_fixed(gradient, t_fixed);
+        t_fixed += inc_fixed;
+    }
+}
+
+static PLUTOVG_TARGET_SSE41 void fetch_radial_gradient_sse41(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.f || length < 4) {
+        fetch_radial_gradient(buffer, v, gradient, y, x, length);
+        return;
+    }
+
+    // the lanes start on four consecutive pixels and then move four pixels at a time
+    radial_gradient_step_t step;
+    radial_gradient_start(&step, v, gradient, y, x);
+    float lane_det[4], lane_delta_det[4], lane_b[4];
+    for(int k = 0; k < 4; k++) {
+        lane_det[k] = step.det;
+        lane_delta_det[k] = step.delta_det;
+        lane_b[k] = step.b;
+        step.det += step.delta_det;
+        step.delta_det += step.delta_delta_det;
+        step.b += step.delta_b;
+    }
+    __m128 det = _mm_loadu_ps(lane_det);
+    __m128 delta_det = _mm_loadu_ps(lane_delta_det);
+    __m128 b = _mm_loadu_ps(lane_b);
+    __m128 det_step = _mm_set1_ps(6 * step.delta_delta_det);
+    __m128 delta_det_step = _mm_set1_ps(4 * step.delta_delta_det);
+    __m128 b_step = _mm_set1_ps(4 * step.delta_b);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 scale = _mm_set1_ps(COLOR_TABLE_SIZE - 1);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 fr = _mm_set1_ps(gradient->values.radial.fr);
+    __m128 dr = _mm_set1_ps(v->dr);
+    int i = 0;
+    for(; i + 4 <= length; i += 4) {
+        __m128 w = _mm_sub_ps(_mm_sqrt_ps(det), b);
+        __m128i ipos = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, scale), half));
+        gradient_lookup_sse41(buffer + i, gradient, gradient_clamp_sse41(gradient->spread, ipos));
+        if(v->extended) {
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(det, zero), _mm_cmpge_ps(_mm_add_ps(fr, _mm_mul_ps(dr, w)), zero));
+            __m128i result = _mm_loadu_si128((const __m128i*)(buffer + i));
+            _mm_storeu_si128((__m128i*)(buffer + i), _mm_and_si128(result, _mm_castps_si128(inside)));
+        }
+        det = _mm_add_ps(det, _mm_add_ps(_mm_mul_ps(delta_det, _mm_set1_ps(4.f)), det_step));
+        delta_det = _mm_add_ps(delta_det, delta_det_step);
+        b = _mm_add_ps(b, b_step);
+    }
+    step.det = _mm_cvtss_f32(det);
+    step.delta_det = _mm_cvtss_f32(delta_det);
+    step.b = _mm_cvtss_f32(b);
+    radial_gradient_span(buffer + i, length - i, v, gradient, &step);
+}
+
+static const blend_kernels_t blend_kernels_sse41 = {
+    composition_solid_source_sse41,
+    composition_solid_source_over_sse41,
+    composition_source_sse41,
+    composition_source_over_sse41,
+    fetch_linear_gradient_sse41,
+    fetch_radial_gradient_sse41
+};
+
+static inline PLUTOVG_TARGET_AVX2 __m256i div255_epi16_avx2(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_srli_epi16(x, 8));
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(x, 8);
+}
+
+// unpacking works inside each 128 bit half, so a_lo covers pixels 0, 1, 4, 5 and a_hi pixels 2, 3, 6, 7
+static inline PLUTOVG_TARGET_AVX2 __m256i byte_mul_avx2(__m256i x, __m256i a_lo, __m256i a_hi)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i lo = div255_epi16_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero), a_lo));
+    __m256i hi = div255_epi16_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero), a_hi));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+static inline PLUTOVG_TARGET_AVX2 __m256i interpolate_pixel_avx2(__m256i x, __m256i a, __m256i y, __m256i b)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero), a), _mm256_mullo_epi16(_mm256_unpacklo_epi8(y, zero), b));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero), a), _mm256_mullo_epi16(_mm256_unpackhi_epi8(y, zero), b));
+    return _mm256_packus_epi16(div255_epi16_avx2(lo), div255_epi16_avx2(hi));
+}
+
+static inline PLUTOVG_TARGET_AVX2 __m256i source_over_avx2(__m256i s, __m256i d)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i inverse = _mm256_xor_si256(s, _mm256_set1_epi32(-1));
+    __m256i ia_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(_mm256_unpacklo_epi8(inverse, zero), 0xff), 0xff);
+    __m256i ia_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(_mm256_unpackhi_epi8(inverse, zero), 0xff), 0xff);
+    return _mm256_add_epi32(s, byte_mul_avx2(d, ia_lo, ia_hi));
+}
+
+static inline PLUTOVG_TARGET_AVX2 __m256i gradient_clamp_avx2(plutovg_spread_method_t spread, __m256i ipos)
+{
+    if(spread == PLUTOVG_SPREAD_METHOD_REPEAT)
+        return _mm256_and_si256(ipos, _mm256_set1_epi32(COLOR_TABLE_SIZE - 1));
+    if(spread == PLUTOVG_SPREAD_METHOD_REFLECT) {
+        ipos = _mm256_and_si256(ipos, _mm256_set1_epi32(COLOR_TABLE_SIZE * 2 - 1));
+        __m256i reflected = _mm256_sub_epi32(_mm256_set1_epi32(COLOR_TABLE_SIZE * 2 - 1), ipos);
+        return _mm256_blendv_epi8(ipos, reflected, _mm256_cmpgt_epi32(ipos, _mm256_set1_epi32(COLOR_TABLE_SIZE - 1)));
+    }
+    return _mm256_min_epi32(_mm256_max_epi32(ipos, _mm256_setzero_si256()), _mm256_set1_epi32(COLOR_TABLE_SIZE - 1));
+}
+
+static PLUTOVG_TARGET_AVX2 void solid_span_avx2(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    __m256i c = _mm256_set1_epi32((int)color);
+    __m256i a = _mm256_set1_epi16((short)ialpha);
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_add_epi32(c, byte_mul_avx2(d, a, a)));
+    }
+    for(; i < length; i++) {
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+    }
+}
+
+static PLUTOVG_TARGET_AVX2 void composition_solid_source_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        plutovg_memfill32(dest, length, color);
+    } else {
+        solid_span_avx2(dest, length, BYTE_MUL(color, const_alpha), 255 - const_alpha);
+    }
+}
+
+static PLUTOVG_TARGET_AVX2 void composition_solid_source_over_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255)
+        color = BYTE_MUL(color, const_alpha);
+    solid_span_avx2(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+static PLUTOVG_TARGET_AVX2 void composition_source_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255) {
+        memcpy(dest, src, length * sizeof(uint32_t));
+        return;
+    }
+
+    __m256i a = _mm256_set1_epi16((short)const_alpha);
+    __m256i ia = _mm256_set1_epi16((short)(255 - const_alpha));
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), interpolate_pixel_avx2(s, a, d, ia));
+    }
+    composition_source(dest + i, length - i, src + i, const_alpha);
+}
+
+static PLUTOVG_TARGET_AVX2 void composition_source_over_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+    int i = 0;
+    if(const_alpha == 255) {
+        for(; i + 8 <= length; i += 8) {
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+            if(_mm256_testz_si256(s, s))
+                continue;
+            if(_mm256_testc_si256(s, alpha_mask)) {
+                _mm256_storeu_si256((__m256i*)(dest + i), s);
+                continue;
+            }
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+            _mm256_storeu_si256((__m256i*)(dest + i), source_over_avx2(s, d));
+        }
+    } else {
+        __m256i a = _mm256_set1_epi16((short)const_alpha);
+        for(; i + 8 <= length; i += 8) {
+            __m256i s = byte_mul_avx2(_mm256_loadu_si256((const __m256i*)(src + i)), a, a);
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+            _mm256_storeu_si256((__m256i*)(dest + i), source_over_avx2(s, d));
+        }
+    }
+    composition_source_over(dest + i, length - i, src + i, const_alpha);
+}
+
+static PLUTOVG_TARGET_AVX2 void fetch_linear_gradient_avx2(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    float t, inc;
+    linear_gradient_start(v, gradient, y, x, &t, &inc);
+    if(linear_gradient_is_constant(inc) || !linear_gradient_fits_fixed(t, inc, length)) {
+        fetch_linear_gradient(buffer, v, gradient, y, x, length);
+        return;
+    }
+
+    int t_fixed = (int)(t * FIXPT_SIZE);
+    int inc_fixed = (int)(inc * FIXPT_SIZE);
+    __m256i pos = _mm256_add_epi32(_mm256_set1_epi32(t_fixed), _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(inc_fixed)));
+    __m256i step = _mm256_set1_epi32((int)((uint32_t)inc_fixed * 8));
+    __m256i half = _mm256_set1_epi32(FIXPT_SIZE / 2);
+    const int* table = (const int*)gradient->colortable;
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256i ipos = gradient_clamp_avx2(gradient->spread, _mm256_srai_epi32(_mm256_add_epi32(pos, half), FIXPT_BITS));
+        _mm256_storeu_si256((__m256i*)(buffer + i), _mm256_i32gather_epi32(table, ipos, 4));
+        pos = _mm256_add_epi32(pos, step);
+    }
+    for(t_fixed = _mm256_cvtsi256_si32(pos); i < length; i++) {
+        buffer[i] = gradient_pixel_fixed(gradient, t_fixed);
+        t_fixed += inc_fixed;
+    }
+}
+
+static PLUTOVG_TARGET_AVX2 void fetch_radial_gradient_avx2(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.f || length < 8) {
+        fetch_radial_gradient(buffer, v, gradient, y, x, length);
+        return;
+    }
+
+    radial_gradient_step_t step;
+    radial_gradient_start(&step, v, gradient, y, x);
+    float lane_det[8], lane_delta_det[8], lane_b[8];
+    for(int k = 0; k < 8; k++) {
+        lane_det[k] = step.det;
+        lane_delta_det[k] = step.delta_det;
+        lane_b[k] = step.b;
+        step.det += step.delta_det;
+        step.delta_det += step.delta_delta_det;
+        step.b += step.delta_b;
+    }
+    __m256 det = _mm256_loadu_ps(lane_det);
+    __m256 delta_det = _mm256_loadu_ps(lane_delta_det);
+    __m256 b = _mm256_loadu_ps(lane_b);
+    __m256 det_step = _mm256_set1_ps(28 * step.delta_delta_det);
+    __m256 delta_det_step = _mm256_set1_ps(8 * step.delta_delta_det);
+    __m256 b_step = _mm256_set1_ps(8 * step.delta_b);
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 scale = _mm256_set1_ps(COLOR_TABLE_SIZE - 1);
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 fr = _mm256_set1_ps(gradient->values.radial.fr);
+    __m256 dr = _mm256_set1_ps(v->dr);
+    const int* table = (const int*)gradient->colortable;
+    int i = 0;
+    for(; i + 8 <= length; i += 8) {
+        __m256 w = _mm256_sub_ps(_mm256_sqrt_ps(det), b);
+        __m256i ipos = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(w, scale), half));
+        __m256i result = _mm256_i32gather_epi32(table, gradient_clamp_avx2(gradient->spread, ipos), 4);
+        if(v->extended) {
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(det, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(fr, _mm256_mul_ps(dr, w)), zero, _CMP_GE_OQ));
+            result = _mm256_and_si256(result, _mm256_castps_si256(inside));
+        }
+        _mm256_storeu_si256((__m256i*)(buffer + i), result);
+        det = _mm256_add_ps(det, _mm256_add_ps(_mm256_mul_ps(delta_det, _mm256_set1_ps(8.f)), det_step));
+        delta_det = _mm256_add_ps(delta_det, delta_det_step);
+        b = _mm256_add_ps(b, b_step);
+    }
+    step.det = _mm256_cvtss_f32(det);
+    step.delta_det = _mm256_cvtss_f32(delta_det);
+    step.b = _mm256_cvtss_f32(b);
+    radial_gradient_span(buffer + i, length - i, v, gradient, &step);
+}
+
+static const blend_kernels_t blend_kernels_avx2 = {
+    composition_solid_source_avx2,
+    composition_solid_source_over_avx2,
+    composition_source_avx2,
+    composition_source_over_avx2,
+    fetch_linear_gradient_avx2,
+    fetch_radial_gradient_avx2
+};
+
+#if defined(_MSC_VER) && defined(__clang__)
+__attribute__((target("xsave")))
+#endif
+static const blend_kernels_t* select_blend_kernels(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    // avx also needs the os to save the ymm registers
+    bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if(avx && max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if(avx2)
+        return &blend_kernels_avx2;
+    if(sse41)
+        return &blend_kernels_sse41;
+    return &blend_kernels_scalar;
+}
+
+#endif // x86
+
+static const blend_kernels_t* blend_kernels(void)
+{
+#ifdef PLUTOVG_BLEND_X86
+    // bands are rasterized on several threads: whichever selects first, they all store the same pointer
+#if defined(_WIN32)
+    static PVOID volatile selected = NULL;
+    const blend_kernels_t* kernels = (const blend_kernels_t*)InterlockedCompareExchangePointer(&selected, NULL, NULL);
+    if(kernels == NULL) {
+        kernels = select_blend_kernels();
+        InterlockedExchangePointer(&selected, (PVOID)kernels);
+    }
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+    static _Atomic(const blend_kernels_t*) selected = NULL;
+    const blend_kernels_t* kernels = atomic_load_explicit(&selected, memory_order_relaxed);
+    if(kernels == NULL) {
+        kernels = select_blend_kernels();
+        atomic_store_explicit(&selected, kernels, memory_order_relaxed);
+    }
+#else
+    static const blend_kernels_t* selected = NULL;
+    const blend_kernels_t* kernels = selected;
+    if(kernels == NULL)
+        selected = kernels = select_blend_kernels();
+#endif
+    return kernels;
+#else
+    return &blend_kernels_scalar;
+#endif
+}
+
+static composition_solid_function_t composition_solid_function(plutovg_operator_t op)
+{
+    if(op == PLUTOVG_OPERATOR_SRC)
+        return blend_kernels()->solid_source;
+    if(op == PLUTOVG_OPERATOR_SRC_OVER)
+        return blend_kernels()->solid_source_over;
+    return composition_solid_table[op];
+}
+
+static composition_function_t composition_function(plutovg_operator_t op)
+{
+    if(op == PLUTOVG_OPERATOR_SRC)
+        return blend_kernels()->source;
+    if(op == PLUTOVG_OPERATOR_SRC_OVER)
+        return blend_kernels()->source_over;
+    return composition_table[op];
+}
+
 static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, uint32_t solid, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_solid_function_t func = composition_solid_table[op];
+    composition_solid_function_t func = composition_solid_function(op);
     int count = span_buffer->spans.size;
     const plutovg_span_t* spans = span_buffer->spans.data;
     while(count--) {
@@ -650,7 +1234,8 @@ static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, uint3
 #define BUFFER_SIZE 1024
 static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = composition_function(op);
+    fetch_linear_gradient_function_t fetch = blend_kernels()->fetch_linear_gradient;
     unsigned int buffer[BUFFER_SIZE];
 
     linear_gradient_values_t v;
@@ -671,7 +1256,7 @@ static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t
         int x = spans->x;
         while(length) {
             int l = plutovg_min(length, BUFFER_SIZE);
-            fetch_linear_gradient(buffer, &v, gradient, spans->y, x, l);
+            fetch(buffer, &v, gradient, spans->y, x, l);
             uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
             func(target, l, buffer, spans->coverage);
             x += l;
@@ -684,7 +1269,8 @@ static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t
 
 static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const gradient_data_t* gradient, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = composition_function(op);
+    fetch_radial_gradient_function_t fetch = blend_kernels()->fetch_radial_gradient;
     unsigned int buffer[BUFFER_SIZE];
 
     radial_gradient_values_t v;
@@ -702,7 +1288,7 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
         int x = spans->x;
         while(length) {
             int l = plutovg_min(length, BUFFER_SIZE);
-            fetch_radial_gradient(buffer, &v, gradient, spans->y, x, l);
+            fetch(buffer, &v, gradient, spans->y, x, l);
             uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
             func(target, l, buffer, spans->coverage);
             x += l;
@@ -715,7 +1301,7 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
 
 static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = composition_function(op);
 
     const int image_width = texture->width;
     const int image_height = texture->height;
@@ -754,7 +1340,7 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
 #define FIXED_SCALE (1 << 16)
 static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = composition_function(op);
     uint32_t buffer[BUFFER_SIZE];
 
     int image_width = texture->width;
@@ -805,7 +1391,7 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
 
 static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = composition_function(op);
 
     int image_width = texture->width;
     int image_height = texture->height;
@@ -854,7 +1440,7 @@ static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_o
 
 static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const texture_data_t* texture, const plutovg_span_buffer_t* span_buffer)
 {
-    composition_function_t func = composition_table[op];
+    composition_function_t func = composition_function(op);
     uint32_t buffer[BUFFER_SIZE];
 
     int image_width = texture->width;
@@ -1014,7 +1600,7 @@ static void plutovg_blend_subpx_texture(plutovg_canvas_t* canvas, const plutovg_
 
         // perform blend
 
-        composition_function_t func = composition_table[state->op];
+        composition_function_t func = composition_function(state->op);
         uint32_t buffer[BUFFER_SIZE];
 
         int count = span_buffer->spans.size;
@@ -176,6 +176,7 @@ PVG_FT_END_STMNT
 
     PVG_FT_Outline  outline;
     PVG_FT_BBox     clip_box;
+    TPos            min_row, max_row;
 
     int clip_flags;
     int clipping;
@@ -1698,6 +1699,18 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
     clip->xMax = (ras.max_ex + 1) * ONE_PIXEL;
     clip->yMax = (ras.max_ey + 1) * ONE_PIXEL;
 
+    /* only keep the cells of the wanted rows; this is the same row  */
+    /* restriction the bands below rely on, so it changes nothing on */
+    /* the rows that remain, unlike narrowing the clipping box       */
+    if ( ras.min_ey < ras.min_row )
+      ras.min_ey = ras.min_row;
+
+    if ( ras.max_ey > ras.max_row )
+      ras.max_ey = ras.max_row;
+
+    if ( ras.min_ey >= ras.max_ey )
+      return 0;
+
     ras.count_ex = ras.max_ex - ras.min_ex;
     ras.count_ey = ras.max_ey - ras.min_ey;
 
@@ -1855,6 +1868,17 @@ void PVG_FT_Outline_Get_CBox(const PVG_FT_Outline* outline, PVG_FT_BBox* acbox)
       ras.clip_box.yMax =  (1 << 23) - 1;
     }
 
+    if ( params->flags & PVG_FT_RASTER_FLAG_ROWS )
+    {
+      ras.min_row = params->min_row;
+      ras.max_row = params->max_row;
+    }
+    else
+    {
+      ras.min_row = -(1 << 23);
+      ras.max_row =  (1 << 23) - 1;
+    }
+
     gray_init_cells( RAS_VAR_ buffer, buffer_size );
 
     ras.outline   = *outline;
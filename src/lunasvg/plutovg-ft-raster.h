@@ -347,10 +347,18 @@ typedef void
 /*                              in direct rendering mode where all spans */
 /*                              are generated if no clipping box is set. */
 /*                                                                       */
+/*    PVG_FT_RASTER_FLAG_ROWS    :: This flag is set to indicate that only   */
+/*                              spans on the rows `min_row' up to        */
+/*                              `max_row' - 1 are wanted.  Unlike the    */
+/*                              clipping box it leaves the outline       */
+/*                              untouched, so those rows come out        */
+/*                              exactly as they would without it.        */
+/*                                                                       */
 #define PVG_FT_RASTER_FLAG_DEFAULT  0x0
 #define PVG_FT_RASTER_FLAG_AA       0x1
 #define PVG_FT_RASTER_FLAG_DIRECT   0x2
 #define PVG_FT_RASTER_FLAG_CLIP     0x4
+#define PVG_FT_RASTER_FLAG_ROWS     0x8
 
 
 /*************************************************************************/
@@ -386,6 +394,10 @@ typedef void
 /*                   should be expressed in _integer_ pixels (and not in */
 /*                   26.6 fixed-point units).                            */
 /*                                                                       */
+/*    min_row     :: The first row wanted, with PVG_FT_RASTER_FLAG_ROWS.  */
+/*                                                                       */
+/*    max_row     :: One past the last row wanted.                       */
+/*                                                                       */
 /* <Note>                                                                */
 /*    An anti-aliased glyph bitmap is drawn if the @PVG_FT_RASTER_FLAG_AA    */
 /*    bit flag is set in the `flags' field, otherwise a monochrome       */
@@ -410,6 +422,8 @@ typedef struct  PVG_FT_Raster_Params_
     PVG_FT_SpanFunc          gray_spans;
     void*                   user;
     PVG_FT_BBox              clip_box;
+    PVG_FT_Pos               min_row;
+    PVG_FT_Pos               max_row;
 
 } PVG_FT_Raster_Params;
 
@@ -359,7 +359,7 @@ static void spans_generation_callback(int count, const PVG_FT_Span* spans, void*
     plutovg_array_append_data_span(span_buffer->spans, spans, count);
 }
 
-void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding)
+void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip_rect, const plutovg_span_buffer_t* clip_spans, const plutovg_stroke_data_t* stroke_data, plutovg_fill_rule_t winding)
 {
     PVG_FT_Outline* outline = ft_outline_convert(path, matrix, stroke_data);
     if(stroke_data) {
@@ -388,6 +388,16 @@ void plutovg_rasterize(plutovg_span_buffer_t* span_buffer, const plutovg_path_t*
         params.clip_box.yMax = (PVG_FT_Pos)(clip_rect->y + clip_rect->h);
     }
 
+    if(clip_spans) {
+        params.flags |= PVG_FT_RASTER_FLAG_ROWS;
+        params.min_row = 0;
+        params.max_row = 0;
+        if(clip_spans->spans.size > 0) {
+            params.min_row = clip_spans->spans.data[0].y;
+            params.max_row = clip_spans->spans.data[clip_spans->spans.size - 1].y + 1;
+        }
+    }
+
     plutovg_span_buffer_reset(span_buffer);
     PVG_FT_Raster_Render(&params);
     ft_outline_destroy(outline);
@@ -1063,6 +1063,7 @@ void SVGClipPathElement::applyClipMask(SVGRenderState& state) const
     if(state.hasCycleReference(this))
         return;
     auto maskImage = Canvas::create(state.currentTransform().mapRect(state.paintBoundingBox()));
+    maskImage->inheritBand(*state.canvas());
     auto currentTransform = state.currentTransform() * localTransform();
     if(m_clipPathUnits.value() == Units::ObjectBoundingBox) {
         auto bbox = state.fillBoundingBox();
@@ -1204,6 +1205,7 @@ void SVGMaskElement::applyMask(SVGRenderState& state) const
     if(state.hasCycleReference(this))
         return;
     auto maskImage = Canvas::create(state.currentTransform().mapRect(state.paintBoundingBox()));
+    maskImage->inheritBand(*state.canvas());
     maskImage->clipRect(maskRect(state.element()), FillRule::NonZero, state.currentTransform());
 
     auto currentTransform = state.currentTransform();
@@ -31,7 +31,9 @@ void SVGRenderState::beginGroup(const SVGBlendInfo& blendInfo)
     if(requiresCompositing) {
         auto boundingBox = m_currentTransform.mapRect(m_element->paintBoundingBox());
         boundingBox.intersect(m_canvas->extents());
-        m_canvas = Canvas::create(boundingBox);
+        auto canvas = Canvas::create(boundingBox);
+        canvas->inheritBand(*m_canvas);
+        m_canvas = std::move(canvas);
     } else {
         m_canvas->save();
     }
@@ -2,6 +2,7 @@
 #include "hb.h"
 #include "hb-ft.h"
 #include "freetype/ftoutln.h"
+#include "freetype/ftmodapi.h"
 #include "fonts.hpp"
 #include "parsers.hpp"
 #include "simple_fs.hpp"
@@ -144,6 +145,9 @@ float font_manager::line_height(font_id f, uint16_t size, float ui_scale) {
 
 font_manager::font_manager() {
 	FT_Init_FreeType(&ft_library);
+	FT_Int spread = sdf_spread;
+	FT_Property_Set(ft_library, "sdf", "spread", &spread);
+	FT_Property_Set(ft_library, "bsdf", "spread", &spread);
 }
 font_manager::~font_manager() {
 	//FT_Done_FreeType(ft_library);
@@ -160,15 +164,131 @@ void font_at_size::reset() {
 	hb_buf = nullptr;
 	font_face = nullptr;
 
-	internal_tx_line_height = 0;
-	internal_tx_line_xpos = 1024;
-	internal_tx_line_ypos = 1024;
+	glyph_positions.clear();
+}
 
-	for(auto& t : textures) {
-		glDeleteTextures(1, &t);
+void glyph_atlas::grow() {
+	auto new_layers = allocated_layers == 0 ? initial_layers : std::min(allocated_layers * 2, max_texture_layers);
+
+	GLuint new_texture = 0;
+	glGenTextures(1, &new_texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, new_texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8, layer_size, layer_size, new_layers);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	uint32_t clearvalue = 0;
+	glClearTexImage(new_texture, 0, GL_RED, GL_UNSIGNED_BYTE, &clearvalue);
+
+	if(texture) {
+		glCopyImageSubData(texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, new_texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, layer_size, layer_size, used_layers);
+		glDeleteTextures(1, &texture);
 	}
-	glyph_positions.clear();
-	textures.clear();
+	texture = new_texture;
+	allocated_layers = new_layers;
+}
+
+void glyph_atlas::clear() {
+	uint32_t clearvalue = 0;
+	glClearTexImage(texture, 0, GL_RED, GL_UNSIGNED_BYTE, &clearvalue);
+	used_layers = 0;
+	line_height = 0;
+	line_xpos = layer_size;
+	line_ypos = layer_size;
+	clear_pending = false;
+	++generation;
+}
+
+void glyph_atlas::new_frame() {
+	if(clear_pending)
+		clear();
+}
+
+bool glyph_atlas::place(uint32_t width, uint32_t height, glyph_sub_offset& gso) {
+	if(height > layer_size || width > layer_size) // too large to render
+		return false;
+	if(clear_pending)
+		return false;
+
+	if(width + line_xpos >= layer_size) { // new line
+		line_xpos = 0;
+		line_ypos += line_height;
+		line_height = 0;
+	}
+	if(height + line_ypos >= layer_size) { // new layer
+		line_xpos = 0;
+		line_ypos = 0;
+		line_height = 0;
+
+		if(used_layers == allocated_layers) {
+			if(allocated_layers == max_texture_layers) {
+				// clearing now would blank glyphs already queued this frame; the ones that don't fit stay empty until the next frame
+				clear_pending = true;
+				return false;
+			}
+			grow();
+		}
+		++used_layers;
+	}
+
+	gso.x = uint16_t(line_xpos);
+	gso.y = uint16_t(line_ypos);
+	gso.width = uint16_t(width);
+	gso.height = uint16_t(height);
+	gso.tx_sheet = uint16_t(used_layers - 1);
+
+	line_xpos += width + 1;
+	line_height = std::max(line_height, height + 1);
+	return true;
+}
+
+void glyph_atlas::upload(glyph_sub_offset const& gso, uint8_t const* data, int32_t pitch) {
+	uint32_t size = uint32_t(gso.width) * uint32_t(gso.height);
+	if(size == 0)
+		return;
+
+	if(staging_buffer == 0) {
+		glGenBuffers(1, &staging_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, staging_size, nullptr, GL_STREAM_DRAW);
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+	}
+	if(staging_offset + size > staging_size) { // orphan the buffer instead of waiting on uploads still in flight
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, staging_size, nullptr, GL_STREAM_DRAW);
+		staging_offset = 0;
+	}
+
+	auto dest = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, staging_offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if(dest) {
+		for(uint32_t j = 0; j < gso.height; ++j)
+			memcpy(dest + j * gso.width, data + j * pitch, gso.width);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, int32_t(gso.x), int32_t(gso.y), int32_t(gso.tx_sheet), gso.width, gso.height, 1, GL_RED, GL_UNSIGNED_BYTE, reinterpret_cast<void const*>(uintptr_t(staging_offset)));
+		staging_offset += size;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void glyph_atlas::reset() {
+	if(texture)
+		glDeleteTextures(1, &texture);
+	if(staging_buffer)
+		glDeleteBuffers(1, &staging_buffer);
+	texture = 0;
+	staging_buffer = 0;
+	staging_offset = 0;
+	allocated_layers = 0;
+	used_layers = 0;
+	line_height = 0;
+	line_xpos = layer_size;
+	line_ypos = layer_size;
+	clear_pending = false;
+	++generation;
 }
 
 font::~font() {
@@ -184,6 +304,8 @@ void font::reset_instances() {
 void font_manager::reset_fonts() {
 	for(auto& f : font_array)
 		f.reset_instances();
+	glyphs.reset();
+	shaping.clear();
 }
 void font_manager::resolve_locale(dcon::data_container& data, simple_fs::file_system& fs, dcon::locale_id l) {
 	uint32_t end_language = 0;
@@ -312,6 +434,77 @@ void font_manager::resolve_locale(dcon::data_container& data, simple_fs::file_sy
 
 		ubrk_close(ch_it);
 	}
+	++break_rules_generation;
+}
+
+// icu objects kept per thread and reset to new text, instead of being opened and closed for every piece of text
+struct reusable_icu_objects {
+	font_manager const* owner = nullptr;
+	uint32_t generation = 0;
+	UBreakIterator* line = nullptr;
+	UBreakIterator* character = nullptr;
+	UBreakIterator* word = nullptr;
+	UBiDi* bidi = nullptr;
+
+	void close_iterators() {
+		if(line)
+			ubrk_close(line);
+		if(character)
+			ubrk_close(character);
+		if(word)
+			ubrk_close(word);
+		line = nullptr;
+		character = nullptr;
+		word = nullptr;
+	}
+	~reusable_icu_objects() {
+		close_iterators();
+		if(bidi)
+			ubidi_close(bidi);
+	}
+};
+static thread_local reusable_icu_objects thread_icu_objects;
+
+static UBreakIterator* reusable_break_iterator(font_manager const& fm, UBreakIterator* reusable_icu_objects::* slot, std::vector<uint8_t> const& rules, uint16_t const* text, int32_t length) {
+	auto& objects = thread_icu_objects;
+	if(objects.owner != &fm || objects.generation != fm.break_rules_generation) { // the rules were recompiled
+		objects.close_iterators();
+		objects.owner = &fm;
+		objects.generation = fm.break_rules_generation;
+	}
+
+	UErrorCode errorCode = U_ZERO_ERROR;
+	auto& it = objects.*slot;
+	if(!it) {
+		it = ubrk_openBinaryRules(rules.data(), int32_t(rules.size()), nullptr, 0, &errorCode);
+		if(!it || !U_SUCCESS(errorCode)) {
+			std::abort(); // couldn't create iterator
+		}
+	}
+	ubrk_setText(it, (UChar const*)text, length, &errorCode);
+	if(!U_SUCCESS(errorCode)) {
+		std::abort(); // couldn't set text
+	}
+	return it;
+}
+
+UBreakIterator* font_manager::line_break_iterator(uint16_t const* text, int32_t length) const {
+	return reusable_break_iterator(*this, &reusable_icu_objects::line, compiled_ubrk_rules, text, length);
+}
+UBreakIterator* font_manager::character_break_iterator(uint16_t const* text, int32_t length) const {
+	return reusable_break_iterator(*this, &reusable_icu_objects::character, compiled_char_ubrk_rules, text, length);
+}
+UBreakIterator* font_manager::word_break_iterator(uint16_t const* text, int32_t length) const {
+	return reusable_break_iterator(*this, &reusable_icu_objects::word, compiled_word_ubrk_rules, text, length);
+}
+UBiDi* font_manager::reusable_bidi() const {
+	auto& objects = thread_icu_objects;
+	if(!objects.bidi) {
+		objects.bidi = ubidi_open();
+		if(!objects.bidi)
+			std::abort();
+	}
+	return objects.bidi;
 }
 
 font& font_manager::get_font(font_id f) {
@@ -323,20 +516,33 @@ font_at_size& font::retrieve_instance(text::font_manager& font_collection, int32
 		return it->second;
 	}
 	auto t = sized_fonts.insert_or_assign(int32_t(base_size * ui_scale), font_at_size{});
-	t.first->second.create(font_collection.ft_library, file_data.get(), file_size, int32_t(base_size * ui_scale));
+	t.first->second.create(font_collection.ft_library, font_collection.glyphs, file_data.get(), file_size, int32_t(base_size * ui_scale));
 	return t.first->second;
 }
 
-font_at_size& font::retrieve_stateless_instance(FT_Library lib, int32_t base_size) {
+font_at_size& font::retrieve_stateless_instance(FT_Library lib, glyph_atlas& glyphs, int32_t base_size) {
 	if(auto it = sized_fonts.find(base_size); it != sized_fonts.end()) {
 		return it->second;
 	}
 	auto t = sized_fonts.insert_or_assign(base_size , font_at_size{});
-	t.first->second.create(lib, file_data.get(), file_size, base_size);
+	t.first->second.create(lib, glyphs, file_data.get(), file_size, base_size);
+	return t.first->second;
+}
+
+font_at_size& font::retrieve_sdf_instance(FT_Library lib, glyph_atlas& glyphs) {
+	// keyed by a negative size so that it never collides with a bitmap instance of the reference size
+	if(auto it = sized_fonts.find(-sdf_reference_size); it != sized_fonts.end()) {
+		return it->second;
+	}
+	auto t = sized_fonts.insert_or_assign(-sdf_reference_size, font_at_size{});
+	t.first->second.create(lib, glyphs, file_data.get(), file_size, sdf_reference_size);
+	t.first->second.sdf = true;
 	return t.first->second;
 }
 
-void font_at_size::create(FT_Library lib, FT_Byte* file_data, size_t file_size, int32_t real_size) {
+void font_at_size::create(FT_Library lib, glyph_atlas& glyphs, FT_Byte* file_data, size_t file_size, int32_t real_size) {
+	atlas = &glyphs;
+	atlas_generation = glyphs.generation;
 	FT_New_Memory_Face(lib, file_data, FT_Long(file_size), 0, &font_face);
 	FT_Select_Charmap(font_face, FT_ENCODING_UNICODE);
 	FT_Set_Pixel_Sizes(font_face, real_size, real_size);
@@ -376,15 +582,24 @@ bool font::can_display(char32_t ch_in) const {
 }
 
 glyph_sub_offset& font_at_size:: get_glyph(uint16_t glyph_in, int32_t subpixel) {
+	if(sdf)
+		subpixel = 0;
 	return glyph_positions[(uint32_t(glyph_in) << 2) | uint32_t(subpixel & 3)];
 }
 void font_at_size::make_glyph(uint16_t glyph_in, int32_t subpixel) {
+	if(atlas_generation != atlas->generation) { // the atlas was cleared, all glyphs have to be made again
+		glyph_positions.clear();
+		atlas_generation = atlas->generation;
+	}
+	if(sdf)
+		subpixel = 0;
 	if(glyph_positions.find((uint32_t(glyph_in) << 2) | uint32_t(subpixel & 3)) != glyph_positions.end())
 		return;
 
 	// load all glyph metrics
 	if(glyph_in) {
-		FT_Load_Glyph(font_face, glyph_in, FT_LOAD_TARGET_LIGHT);
+		// distance fields are scaled to every size, so hinting for the reference size would only distort them
+		FT_Load_Glyph(font_face, glyph_in, sdf ? FT_LOAD_NO_HINTING : FT_LOAD_TARGET_LIGHT);
 		glyph_sub_offset gso;
 
 		if(subpixel == 1) {
@@ -395,7 +610,7 @@ void font_at_size::make_glyph(uint16_t glyph_in, int32_t subpixel) {
 			FT_Outline_Translate(&(font_face->glyph->outline), 48, 0);
 		}
 
-		FT_Render_Glyph(font_face->glyph, FT_RENDER_MODE_NORMAL);
+		FT_Render_Glyph(font_face->glyph, sdf ? FT_RENDER_MODE_SDF : FT_RENDER_MODE_NORMAL);
 
 		FT_Glyph g_result;
 		auto err = FT_Get_Glyph(font_face->glyph, &g_result);
@@ -406,61 +621,17 @@ void font_at_size::make_glyph(uint16_t glyph_in, int32_t subpixel) {
 
 		FT_Bitmap const& bitmap = ((FT_BitmapGlyphRec*)g_result)->bitmap;
 
-		assert(bitmap.rows <= 1024 && bitmap.width <= 1024);
-		if(bitmap.rows > 1024 || bitmap.width > 1024) { // too large to render
+		assert(bitmap.rows <= glyph_atlas::layer_size && bitmap.width <= glyph_atlas::layer_size);
+		if(!atlas->place(bitmap.width, bitmap.rows, gso)) { // too large to render, or the atlas is full until the next frame
 			FT_Done_Glyph(g_result);
 			glyph_positions.insert_or_assign((uint32_t(glyph_in) << 2) | uint32_t(subpixel & 3), gso);
 			return;
 		}
-		if(bitmap.width + internal_tx_line_xpos >= 1024) { // new line
-			internal_tx_line_xpos = 0;
-			internal_tx_line_ypos += internal_tx_line_height;
-			internal_tx_line_height = 0;
-		}
-		GLuint texid = 0;
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		if(bitmap.rows + internal_tx_line_ypos >= 1024) { // new bitmap
-			internal_tx_line_xpos = 0;
-			internal_tx_line_ypos = 0;
-			internal_tx_line_height = 0;
-
-			glGenTextures(1, &texid);
-			glBindTexture(GL_TEXTURE_2D, texid);
-			glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, 1024, 1024);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-			textures.push_back(texid);
-			uint32_t clearvalue = 0;
-			glClearTexImage(texid, 0, GL_RED, GL_UNSIGNED_BYTE, &clearvalue);
-		} else {
-			texid = textures.back();
-			glBindTexture(GL_TEXTURE_2D, texid);
-		}
-		gso.x = uint16_t(internal_tx_line_xpos);
-		gso.y = uint16_t(internal_tx_line_ypos );
-		gso.width = uint16_t(bitmap.width);
-		gso.height = uint16_t(bitmap.rows);
-		gso.tx_sheet = uint16_t(textures.size() - 1);
 		gso.bitmap_left = int16_t(((FT_BitmapGlyphRec*)g_result)->left);
 		gso.bitmap_top = int16_t(((FT_BitmapGlyphRec*)g_result)->top);
 
-		internal_tx_line_xpos += bitmap.width + 1;
-		internal_tx_line_height = std::max(internal_tx_line_height, bitmap.rows + 1);
+		atlas->upload(gso, bitmap.buffer, bitmap.pitch);
 
-		if(bitmap.pitch == int32_t(bitmap.width)) {
-			glTexSubImage2D(GL_TEXTURE_2D, 0, int32_t(gso.x), int32_t(gso.y), bitmap.width, bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, bitmap.buffer);
-		} else {
-			uint8_t* temp = new uint8_t[bitmap.width * bitmap.rows];
-			for(uint32_t j = 0; j < bitmap.rows; ++j) {
-				for(uint32_t i = 0; i < bitmap.width; ++i) {
-					temp[i + j * bitmap.width] = uint8_t(bitmap.buffer[i + j * bitmap.pitch]);
-				}
-			}
-			glTexSubImage2D(GL_TEXTURE_2D, 0, int32_t(gso.x), int32_t(gso.y), bitmap.width, bitmap.rows, GL_RED, GL_UNSIGNED_BYTE, temp);
-			delete[] temp;
-		}
 		FT_Done_Glyph(g_result);
 		glyph_positions.insert_or_assign((uint32_t(glyph_in) << 2) | uint32_t(subpixel & 3), gso);
 	}
@@ -479,6 +650,32 @@ stored_glyphs::stored_glyphs(
 	bool rtl,
 	float ui_scale
 ) {
+	// grapheme placement belongs to the layout being built, so text with details is always shaped
+	if(d) {
+		font_collection
+			.get_font(f)
+			.retrieve_instance(font_collection, size, ui_scale)
+			.remake_cache(
+				font_collection,
+				*this,
+				s,
+				d,
+				details_offset,
+				f,
+				features,
+				hb_script,
+				language,
+				rtl,
+				ui_scale
+			);
+		return;
+	}
+
+	auto& key = font_collection.shaping.make_key(s, true, size, ui_scale, f, features, hb_script, language, rtl);
+	if(auto cached = font_collection.shaping.find(key)) {
+		set_run(std::move(cached));
+		return;
+	}
 	font_collection
 		.get_font(f)
 		.retrieve_instance(font_collection, size, ui_scale)
@@ -495,6 +692,7 @@ stored_glyphs::stored_glyphs(
 			rtl,
 			ui_scale
 		);
+	font_collection.shaping.insert(key, run);
 }
 
 stored_glyphs::stored_glyphs(
@@ -509,6 +707,11 @@ stored_glyphs::stored_glyphs(
 	bool rtl,
 	float ui_scale
 ) {
+	auto& key = font_collection.shaping.make_key(source, false, size, ui_scale, f, features, hb_script, language, rtl);
+	if(auto cached = font_collection.shaping.find(key)) {
+		set_run(std::move(cached));
+		return;
+	}
 	font_collection
 		.get_font(f)
 		.retrieve_instance(font_collection, size, ui_scale)
@@ -523,11 +726,71 @@ stored_glyphs::stored_glyphs(
 			rtl,
 			ui_scale
 		);
+	font_collection.shaping.insert(key, run);
 }
 
-stored_glyphs::stored_glyphs(stored_glyphs& other, uint32_t offset, uint32_t count) {
-	glyph_info.resize(count);
-	std::copy_n(other.glyph_info.data() + offset, count, glyph_info.data());
+stored_glyphs::stored_glyphs(stored_glyphs const& other, uint32_t offset, uint32_t count) : run(other.run), glyph_info(other.glyph_info.subspan(offset, count)) {
+}
+
+std::string const& shaping_cache::make_key(
+	std::span<uint16_t const> source,
+	bool bidi,
+	int32_t size,
+	float ui_scale,
+	font_id f,
+	dcon::dcon_vv_fat_id<uint32_t> features,
+	hb_script_t hb_script,
+	hb_language_t language,
+	bool rtl
+) {
+	key_buffer.clear();
+	auto append = [&](auto const& v) {
+		key_buffer.append(reinterpret_cast<char const*>(&v), sizeof(v));
+	};
+	append(bidi);
+	append(rtl);
+	append(size);
+	append(ui_scale);
+	append(f);
+	append(hb_script);
+	append(language); // languages are interned by harfbuzz
+	append(features.size());
+	for(uint32_t i = 0; i < features.size(); ++i)
+		append(features[i]);
+	key_buffer.append(reinterpret_cast<char const*>(source.data()), source.size() * sizeof(uint16_t));
+	return key_buffer;
+}
+
+shaped_run shaping_cache::find(std::string const& key) {
+	auto it = entries.find(key);
+	if(it == entries.end()) {
+		++misses;
+		return nullptr;
+	}
+	++hits;
+	recent.splice(recent.begin(), recent, it->second);
+	return it->second->run;
+}
+
+void shaping_cache::insert(std::string const& key, shaped_run run) {
+	if(!run)
+		return;
+	if(auto it = entries.find(key); it != entries.end()) {
+		it->second->run = std::move(run);
+		recent.splice(recent.begin(), recent, it->second);
+		return;
+	}
+	if(recent.size() >= capacity) {
+		entries.erase(recent.back().key);
+		recent.pop_back();
+	}
+	recent.push_front(entry{ key, std::move(run) });
+	entries.insert_or_assign(key, recent.begin());
+}
+
+void shaping_cache::clear() {
+	entries.clear();
+	recent.clear();
 }
 
 void font_at_size::remake_cache(
@@ -543,18 +806,17 @@ void font_at_size::remake_cache(
 	bool rtl,
 	float ui_scale
 ) {
-	txt.glyph_info.clear();
+	txt.clear();
 
 	if(source.size() == 0)
 		return;
 
+	auto glyphs = std::make_shared<std::vector<stored_glyph>>();
+
 	UBiDi* para;
 	UErrorCode errorCode = U_ZERO_ERROR;
 
-	para = ubidi_open();
-	//para = ubidi_openSized(int32_t(temp_text.size()), 64, pErrorCode);
-	if(!para)
-		std::abort();
+	para = font_collection.reusable_bidi();
 
 	hb_feature_t feature_buffer[10];
 	for(uint32_t i = 0; i < uint32_t(std::extent_v<decltype(feature_buffer)>) && i < features.size(); ++i) {
@@ -603,17 +865,7 @@ void font_at_size::remake_cache(
 				hb_glyph_position_t* glyph_pos = hb_buffer_get_glyph_positions(hb_buf, &gcount);
 
 				if(d) {
-					UBreakIterator* cb_it = ubrk_openBinaryRules(
-						font_collection.compiled_char_ubrk_rules.data(),
-						int32_t(font_collection.compiled_char_ubrk_rules.size()),
-						(UChar const*)(source.data() + logical_start),
-						int32_t(length),
-						&errorCode
-					);
-
-					if(!cb_it || !U_SUCCESS(errorCode)) {
-						std::abort(); // couldn't create iterator
-					}
+					UBreakIterator* cb_it = font_collection.character_break_iterator(source.data() + logical_start, int32_t(length));
 
 					ubrk_first(cb_it);
 					int32_t start_cluster_position = 0;
@@ -680,20 +932,9 @@ void font_at_size::remake_cache(
 					} while(next_cluster_position != UBRK_DONE);
 
 					last_run_rightmost = previous_rightmost_in_run;
-					ubrk_close(cb_it);
 
 					// find word breaks
-					UBreakIterator* wb_it = ubrk_openBinaryRules(
-						font_collection.compiled_word_ubrk_rules.data(),
-						int32_t(font_collection.compiled_word_ubrk_rules.size()),
-						(UChar const*)(source.data() + logical_start),
-						int32_t(length),
-						&errorCode
-					);
-
-					if(!wb_it || !U_SUCCESS(errorCode)) {
-						std::abort(); // couldn't create iterator
-					}
+					UBreakIterator* wb_it = font_collection.word_break_iterator(source.data() + logical_start, int32_t(length));
 					ubrk_first(wb_it);
 
 					int32_t start_wb_position = 0;
@@ -725,7 +966,6 @@ void font_at_size::remake_cache(
 
 						start_wb_position = next_wb_position;
 					} while(next_wb_position != UBRK_DONE);
-					ubrk_close(wb_it);
 
 					// find visual location of graphemes
 					for(auto k = start_of_new_entries; k < d->grapheme_placement.size(); ++k) {
@@ -798,7 +1038,7 @@ void font_at_size::remake_cache(
 				for(unsigned int j = 0; j < gcount; j++) { // Preload glyphs
 					total_x_advance += glyph_pos[j].x_advance / (text::fixed_to_fp * ui_scale);
 					//make_glyph(uint16_t(glyph_info[j].codepoint));
-					txt.glyph_info.emplace_back(glyph_info[j], glyph_pos[j]);
+					glyphs->emplace_back(glyph_info[j], glyph_pos[j]);
 				}
 			}
 		} else {
@@ -810,7 +1050,7 @@ void font_at_size::remake_cache(
 		std::abort();
 	}
 
-	ubidi_close(para);
+	txt.set_run(std::move(glyphs));
 }
 
 void font_at_size::remake_bidiless_cache(
@@ -824,10 +1064,12 @@ void font_at_size::remake_bidiless_cache(
 	bool rtl,
 	float ui_scale
 ) {
-	txt.glyph_info.clear();
+	txt.clear();
 	if(source.size() == 0)
 		return;
 
+	auto glyphs = std::make_shared<std::vector<stored_glyph>>();
+
 	hb_feature_t feature_buffer[10];
 	for(uint32_t i = 0; i < uint32_t(std::extent_v<decltype(feature_buffer)>) && i < features.size(); ++i) {
 		feature_buffer[i].tag = features[i];
@@ -853,12 +1095,13 @@ void font_at_size::remake_bidiless_cache(
 
 	for(unsigned int j = 0; j < gcount; j++) { // Preload glyphs
 		//make_glyph(uint16_t(glyph_info[j].codepoint));
-		txt.glyph_info.emplace_back(glyph_info[j], glyph_pos[j]);
+		glyphs->emplace_back(glyph_info[j], glyph_pos[j]);
 	}
 
 	if(rtl) {
-		std::reverse(txt.glyph_info.begin(), txt.glyph_info.end());
+		std::reverse(glyphs->begin(), glyphs->end());
 	}
+	txt.set_run(std::move(glyphs));
 }
 
 
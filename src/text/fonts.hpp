@@ -6,6 +6,8 @@
 #include "hb.h"
 #include <common_types.hpp>
 #include <span>
+#include <list>
+#include <memory>
 #include "data_ids.hpp"
 #include "simple_fs.hpp"
 
@@ -13,6 +15,9 @@ namespace dcon {
 struct data_container;
 }
 
+struct UBreakIterator;
+struct UBiDi;
+
 namespace text {
 
 using font_id = uint16_t;
@@ -21,6 +26,8 @@ using font_id = uint16_t;
 inline constexpr uint32_t max_texture_layers = 256;
 inline constexpr int magnification_factor = 4;
 inline constexpr int dr_size = 64 * magnification_factor;
+inline constexpr int32_t sdf_reference_size = 64; // pixel size that signed distance field glyphs are rendered at
+inline constexpr int32_t sdf_spread = 8; // in pixels of the reference size
 
 enum class font_selection {
 	body_font,
@@ -43,6 +50,36 @@ struct glyph_sub_offset {
 
 class font_manager;
 
+// glyphs of every font and size are packed into shelves of the layers of one GL_TEXTURE_2D_ARRAY
+// the array starts small and is reallocated with twice the layers until max_texture_layers; when
+// even that is full everything is cleared and generation is bumped so that fonts drop their glyphs
+class glyph_atlas {
+public:
+	static constexpr uint32_t layer_size = 1024;
+	static constexpr uint32_t initial_layers = 4;
+	static constexpr uint32_t staging_size = layer_size * layer_size;
+
+	uint32_t texture = 0;
+	uint32_t staging_buffer = 0; // pixel unpack buffer that glyph bitmaps are written into before the upload
+	uint32_t staging_offset = 0;
+	uint32_t allocated_layers = 0;
+	uint32_t used_layers = 0;
+	uint32_t generation = 0;
+	bool clear_pending = false; // every layer is full; cleared by the next new_frame
+
+	uint32_t line_height = 0;
+	uint32_t line_xpos = layer_size;
+	uint32_t line_ypos = layer_size;
+
+	bool place(uint32_t width, uint32_t height, glyph_sub_offset& gso);
+	void upload(glyph_sub_offset const& gso, uint8_t const* data, int32_t pitch);
+	void reset();
+	void new_frame(); // once per frame, before anything is drawn
+private:
+	void grow();
+	void clear();
+};
+
 enum class font_feature {
 	none, small_caps
 };
@@ -72,8 +109,8 @@ struct ex_grapheme_cluster_info {
 	int16_t visual_left = -1; // index of grapheme cluster to the left, or -1 if none
 	int16_t visual_right = -1; // index of grapheme cluster to the right, or -1 if none
 
+	uint16_t line = 0; // which line in the layout, starting at 0
 	uint8_t flags = 0;
-	uint8_t line = 0; // which line in the layout, starting at 0
 	uint8_t unit_length = 0; // how many utf16 codepoints the cluster consists of
 
 	constexpr static uint8_t f_is_word_start = 0x01;
@@ -112,18 +149,22 @@ struct stored_glyph {
 
 struct layout_details {
 	std::vector<ex_grapheme_cluster_info> grapheme_placement;
-	uint8_t total_lines = 0;
+	uint16_t total_lines = 0;
 };
 
+// the glyphs of one shaping result; never modified once made, so it is shared instead of copied
+using shaped_run = std::shared_ptr<std::vector<stored_glyph> const>;
+
 struct stored_glyphs {
-	std::vector<stored_glyph> glyph_info;
+	shaped_run run;
+	std::span<stored_glyph const> glyph_info; // view into run
 
 	struct no_bidi { };
 
 	stored_glyphs() = default;
 	stored_glyphs(stored_glyphs const& other) noexcept = default;
 	stored_glyphs(stored_glyphs&& other) noexcept = default;
-	stored_glyphs(stored_glyphs& other, uint32_t offset, uint32_t count);
+	stored_glyphs(stored_glyphs const& other, uint32_t offset, uint32_t count);
 	stored_glyphs(
 		font_manager& font_collection,
 		int32_t size,
@@ -151,11 +192,47 @@ struct stored_glyphs {
 	);
 
 	//void set_text(sys::state& state, font_selection type, std::string const& s);
+	void set_run(shaped_run r) {
+		run = std::move(r);
+		glyph_info = run ? std::span<stored_glyph const>(*run) : std::span<stored_glyph const>{};
+	}
 	void clear() {
-		glyph_info.clear();
+		set_run(nullptr);
 	}
 };
 
+// least recently used cache of shaped text, keyed by the utf16 source together with everything that affects shaping
+class shaping_cache {
+public:
+	static constexpr size_t capacity = 4096;
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+
+	std::string const& make_key(
+		std::span<uint16_t const> source,
+		bool bidi,
+		int32_t size,
+		float ui_scale,
+		font_id f,
+		dcon::dcon_vv_fat_id<uint32_t> features,
+		hb_script_t hb_script,
+		hb_language_t language,
+		bool rtl
+	);
+	shaped_run find(std::string const& key);
+	void insert(std::string const& key, shaped_run run);
+	void clear();
+private:
+	struct entry {
+		std::string key;
+		shaped_run run;
+	};
+	std::list<entry> recent; // most recently used first
+	ankerl::unordered_dense::map<std::string, std::list<entry>::iterator> entries;
+	std::string key_buffer;
+};
+
 class font_at_size {
 private:
 	float internal_line_height = 0.0f;
@@ -163,23 +240,20 @@ private:
 	float internal_descender = 0.0f;
 	float internal_top_adj = 0.0f;
 
-	uint32_t internal_tx_line_height = 0;
-	uint32_t internal_tx_line_xpos = 1024;
-	uint32_t internal_tx_line_ypos = 1024;
+	uint32_t atlas_generation = 0;
 	int32_t px_size = 0;
 	ankerl::unordered_dense::map<uint32_t, glyph_sub_offset> glyph_positions{};
 public:
 	FT_Face font_face = nullptr;
 	hb_font_t* hb_font_face = nullptr;
 	hb_buffer_t* hb_buf = nullptr;
-
-
-	std::vector<uint32_t> textures;
+	glyph_atlas* atlas = nullptr;
+	bool sdf = false; // glyphs are signed distance fields, drawn at any size; subpixel offsets are ignored
 
 	void make_glyph(uint16_t glyph_in, int32_t subpixel);
 	glyph_sub_offset& get_glyph(uint16_t glyph_in, int32_t subpixel);
 	void reset();
-	void create(FT_Library lib, FT_Byte* file_data, size_t file_size, int32_t real_size);
+	void create(FT_Library lib, glyph_atlas& glyphs, FT_Byte* file_data, size_t file_size, int32_t real_size);
 	void remake_cache(
 		font_manager& font_collection,
 		stored_glyphs& txt,
@@ -212,7 +286,7 @@ public:
 	float text_extent(char const* codepoints, uint32_t count, float ui_scale);
 
 	font_at_size() = default;
-	font_at_size(font_at_size&& o) noexcept : glyph_positions(std::move(o.glyph_positions)), textures(o.textures) {
+	font_at_size(font_at_size&& o) noexcept : glyph_positions(std::move(o.glyph_positions)) {
 		font_face = o.font_face;
 		o.font_face = nullptr;
 		hb_font_face = o.hb_font_face;
@@ -223,13 +297,12 @@ public:
 		internal_ascender = o.internal_ascender;
 		internal_descender = o.internal_descender;
 		internal_top_adj = o.internal_top_adj;
-		internal_tx_line_height = o.internal_tx_line_height;
-		internal_tx_line_xpos = o.internal_tx_line_xpos;
-		internal_tx_line_ypos = o.internal_tx_line_ypos;
+		atlas = o.atlas;
+		atlas_generation = o.atlas_generation;
+		sdf = o.sdf;
 	}
 	font_at_size& operator=(font_at_size&& o) noexcept {
 		glyph_positions = std::move(o.glyph_positions);
-		textures = std::move(o.textures);
 		font_face = o.font_face;
 		o.font_face = nullptr;
 		hb_font_face = o.hb_font_face;
@@ -240,9 +313,9 @@ public:
 		internal_ascender = o.internal_ascender;
 		internal_descender = o.internal_descender;
 		internal_top_adj = o.internal_top_adj;
-		internal_tx_line_height = o.internal_tx_line_height;
-		internal_tx_line_xpos = o.internal_tx_line_xpos;
-		internal_tx_line_ypos = o.internal_tx_line_ypos;
+		atlas = o.atlas;
+		atlas_generation = o.atlas_generation;
+		sdf = o.sdf;
 		return *this;
 	}
 };
@@ -264,7 +337,8 @@ public:
 
 	bool can_display(char32_t ch_in) const;
 	font_at_size& retrieve_instance(text::font_manager& font_collection, int32_t base_size, float ui_scale);
-	font_at_size& retrieve_stateless_instance(FT_Library lib, int32_t base_size);
+	font_at_size& retrieve_stateless_instance(FT_Library lib, glyph_atlas& glyphs, int32_t base_size);
+	font_at_size& retrieve_sdf_instance(FT_Library lib, glyph_atlas& glyphs);
 	void reset_instances();
 
 	friend class font_manager;
@@ -289,6 +363,9 @@ public:
 
 	ankerl::unordered_dense::map<uint16_t, dcon::text_key> font_names;
 	FT_Library ft_library;
+	glyph_atlas glyphs;
+	shaping_cache shaping;
+	bool sdf_glyphs = false; // text is drawn from one signed distance field per glyph instead of a bitmap per pixel size
 private:
 	std::vector<font> font_array;
 	font_manager(font_manager const&) = delete;
@@ -297,11 +374,19 @@ public:
 	std::vector<uint8_t> compiled_ubrk_rules;
 	std::vector<uint8_t> compiled_char_ubrk_rules;
 	std::vector<uint8_t> compiled_word_ubrk_rules;
+	uint32_t break_rules_generation = 0; // changes whenever the compiled rules do
 	bool map_font_is_black = false;
 
 	// dcon::locale_id current_locale;
 	void resolve_locale(dcon::data_container& data, simple_fs::file_system& fs, dcon::locale_id l);
 
+	// iterators over the compiled rules, reset to the given text; each is shared by all callers on the same thread,
+	// so it is only valid until the next request for the same kind of iterator
+	UBreakIterator* line_break_iterator(uint16_t const* text, int32_t length) const;
+	UBreakIterator* character_break_iterator(uint16_t const* text, int32_t length) const;
+	UBreakIterator* word_break_iterator(uint16_t const* text, int32_t length) const;
+	UBiDi* reusable_bidi() const; // per thread, reset it with ubidi_setPara
+
 	void reset_fonts();
 	font& get_font(font_id f);
 	void load_font(font& fnt, char const* file_data, uint32_t file_size);
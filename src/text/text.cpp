@@ -112,18 +112,7 @@ void add_to_layout_box(
 	bool first_in_line = true;
 
 
-	UErrorCode errorCode = U_ZERO_ERROR;
-	UBreakIterator* lb_it = ubrk_openBinaryRules(
-		font_collection.compiled_ubrk_rules.data(),
-		int32_t(font_collection.compiled_ubrk_rules.size()),
-		(UChar const*)text.data(),
-		int32_t(text.size()),
-		&errorCode
-	);
-
-	if(!lb_it || !U_SUCCESS(errorCode)) {
-		std::abort(); // couldn't create iterator
-	}
+	UBreakIterator* lb_it = font_collection.line_break_iterator((uint16_t const*)text.data(), int32_t(text.size()));
 
 	ubrk_first(lb_it);
 
@@ -471,8 +460,6 @@ void add_to_layout_box(
 			}
 		}
 	}
-
-	ubrk_close(lb_it);
 }
 
 
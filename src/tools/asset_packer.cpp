@@ -0,0 +1,57 @@
+// packs a directory into a single archive that simple_fs can mount as a root
+// usage: AssetPacker <source directory> <output archive> [zstd level, 0 to store uncompressed]
+// paths are stored relative to the parent of the source directory, so packing "assets" produces entries "assets/..."
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "asset_archive_format.hpp"
+
+int main(int argc, char* argv[]) {
+	if(argc < 3) {
+		std::fprintf(stderr, "usage: %s <source directory> <output archive> [compression level]\n", argv[0]);
+		return 1;
+	}
+	std::filesystem::path source = std::filesystem::path(argv[1]).lexically_normal();
+	if(!source.has_filename())
+		source = source.parent_path();
+	int32_t compression_level = argc > 3 ? std::atoi(argv[3]) : 19;
+
+	std::error_code ec;
+	if(!std::filesystem::is_directory(source, ec)) {
+		std::fprintf(stderr, "%s is not a directory\n", argv[1]);
+		return 1;
+	}
+	auto const base = source.parent_path();
+
+	std::vector<simple_fs::archive_input> inputs;
+	uint64_t raw_bytes = 0;
+	for(auto const& item : std::filesystem::recursive_directory_iterator(source)) {
+		if(!item.is_regular_file())
+			continue;
+		std::ifstream in(item.path(), std::ios::binary);
+		if(!in) {
+			std::fprintf(stderr, "could not read %s\n", item.path().string().c_str());
+			return 1;
+		}
+		simple_fs::archive_input input;
+		auto relative = item.path().lexically_relative(base).generic_u8string();
+		input.path.assign(relative.begin(), relative.end());
+		input.contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		raw_bytes += input.contents.size();
+		inputs.push_back(std::move(input));
+	}
+
+	auto archive = simple_fs::build_archive(inputs, compression_level);
+	std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+	out.write(archive.data(), std::streamsize(archive.size()));
+	if(!out) {
+		std::fprintf(stderr, "could not write %s\n", argv[2]);
+		return 1;
+	}
+	std::printf("%zu entries, %llu bytes -> %zu bytes\n", inputs.size(), (unsigned long long)raw_bytes, archive.size());
+	return 0;
+}
@@ -0,0 +1,122 @@
+// times opening and closing ICU objects for every piece of text against resetting objects kept around, as text::font_manager does
+// usage: IcuBench [iterations] [locale]
+// line break iterators are opened from binary rules, the way the font manager compiles them once per locale
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <icu.h>
+#pragma comment(lib, "icu.lib")
+#else
+#include <unicode/ubrk.h>
+#include <unicode/utypes.h>
+#include <unicode/ubidi.h>
+#endif
+
+namespace {
+
+// a typical ui string: mostly latin, with a right-to-left run so that the bidi algorithm has work to do
+constexpr std::u16string_view sample_text = u"Population growth: +2.4% this month, אוכלוסייה of 12,340";
+
+template<typename F>
+double microseconds_per_call(int32_t iterations, F&& f) {
+	auto start = std::chrono::steady_clock::now();
+	for(int32_t i = 0; i < iterations; ++i)
+		f();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / double(iterations);
+}
+
+bool check(UErrorCode code, char const* what) {
+	if(U_FAILURE(code)) {
+		std::fprintf(stderr, "%s failed: %s\n", what, u_errorName(code));
+		return false;
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+	int32_t iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+	char const* locale = argc > 2 ? argv[2] : "en-US";
+	if(iterations <= 0) {
+		std::fprintf(stderr, "usage: IcuBench [iterations] [locale]\n");
+		return 1;
+	}
+
+	auto text = (UChar const*)sample_text.data();
+	auto length = int32_t(sample_text.size());
+	UErrorCode errorCode = U_ZERO_ERROR;
+
+	UBreakIterator* compiler = ubrk_open(UBRK_LINE, locale, nullptr, 0, &errorCode);
+	if(!check(errorCode, "ubrk_open"))
+		return 1;
+	auto rule_size = ubrk_getBinaryRules(compiler, nullptr, 0, &errorCode);
+	if(!check(errorCode, "ubrk_getBinaryRules"))
+		return 1;
+	std::vector<uint8_t> rules(static_cast<size_t>(rule_size));
+	ubrk_getBinaryRules(compiler, rules.data(), rule_size, &errorCode);
+	ubrk_close(compiler);
+	if(!check(errorCode, "ubrk_getBinaryRules"))
+		return 1;
+
+	int32_t breaks = 0; // consumed below, so that the walks are not optimized away
+	auto walk = [&](UBreakIterator* it) {
+		for(auto pos = ubrk_first(it); pos != UBRK_DONE; pos = ubrk_next(it))
+			++breaks;
+	};
+
+	auto open_close = microseconds_per_call(iterations, [&]() {
+		UErrorCode code = U_ZERO_ERROR;
+		auto it = ubrk_openBinaryRules(rules.data(), int32_t(rules.size()), text, length, &code);
+		ubrk_close(it);
+	});
+	auto open_walk_close = microseconds_per_call(iterations, [&]() {
+		UErrorCode code = U_ZERO_ERROR;
+		auto it = ubrk_openBinaryRules(rules.data(), int32_t(rules.size()), text, length, &code);
+		walk(it);
+		ubrk_close(it);
+	});
+	UBreakIterator* reused = ubrk_openBinaryRules(rules.data(), int32_t(rules.size()), nullptr, 0, &errorCode);
+	if(!check(errorCode, "ubrk_openBinaryRules"))
+		return 1;
+	auto set_text = microseconds_per_call(iterations, [&]() {
+		UErrorCode code = U_ZERO_ERROR;
+		ubrk_setText(reused, text, length, &code);
+	});
+	auto set_text_walk = microseconds_per_call(iterations, [&]() {
+		UErrorCode code = U_ZERO_ERROR;
+		ubrk_setText(reused, text, length, &code);
+		walk(reused);
+	});
+	ubrk_close(reused);
+
+	int32_t runs = 0;
+	auto bidi_open_close = microseconds_per_call(iterations, [&]() {
+		UErrorCode code = U_ZERO_ERROR;
+		auto para = ubidi_open();
+		ubidi_setPara(para, text, length, UBIDI_DEFAULT_LTR, nullptr, &code);
+		runs += ubidi_countRuns(para, &code);
+		ubidi_close(para);
+	});
+	UBiDi* reused_para = ubidi_open();
+	auto bidi_reused = microseconds_per_call(iterations, [&]() {
+		UErrorCode code = U_ZERO_ERROR;
+		ubidi_setPara(reused_para, text, length, UBIDI_DEFAULT_LTR, nullptr, &code);
+		runs += ubidi_countRuns(reused_para, &code);
+	});
+	ubidi_close(reused_para);
+
+	std::printf("%d utf16 units, %d iterations, locale %s (%d breaks, %d runs seen)\n", int32_t(length), int32_t(iterations), locale, int32_t(breaks), int32_t(runs));
+	std::printf("%-52s %8.3f us\n", "ubrk_openBinaryRules + ubrk_close", open_close);
+	std::printf("%-52s %8.3f us\n", "ubrk_setText on a kept iterator", set_text);
+	std::printf("%-52s %8.3f us\n", "ubrk_openBinaryRules + walk + ubrk_close", open_walk_close);
+	std::printf("%-52s %8.3f us\n", "ubrk_setText + walk on a kept iterator", set_text_walk);
+	std::printf("%-52s %8.3f us\n", "ubidi_open + ubidi_setPara + ubidi_close", bidi_open_close);
+	std::printf("%-52s %8.3f us\n", "ubidi_setPara on a kept UBiDi", bidi_reused);
+	return 0;
+}
@@ -0,0 +1,94 @@
+// renders every .svg under a directory with lunasvg at a few sizes and reports the throughput in Mpx/s
+// usage: RasterBench <directory> [--hashes]
+// with --hashes, also prints a hash of every 256 px render, so two builds of the blend kernels can be diffed for exactness
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION 1
+#include "stb_image.h"
+#include "lunasvg.h"
+
+namespace {
+
+struct document {
+	std::string name;
+	std::unique_ptr<lunasvg::Document> svg;
+};
+
+uint64_t hash_bitmap(lunasvg::Bitmap const& bmp) {
+	uint64_t h = 0xcbf29ce484222325ull;
+	for(int32_t y = 0; y < bmp.height(); ++y) {
+		auto row = bmp.data() + size_t(y) * size_t(bmp.stride());
+		for(int32_t x = 0; x < bmp.width() * 4; ++x) {
+			h ^= row[x];
+			h *= 0x100000001b3ull;
+		}
+	}
+	return h;
+}
+
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		std::fprintf(stderr, "usage: RasterBench <directory> [--hashes]\n");
+		return 1;
+	}
+	bool hashes = argc > 2 && std::strcmp(argv[2], "--hashes") == 0;
+
+	// external images are not resolved; the ui assets do not reference any
+	auto loader = [](std::string_view) { return std::pair<void const*, int>(nullptr, 0); };
+
+	std::vector<document> documents;
+	for(auto& entry : std::filesystem::recursive_directory_iterator(argv[1])) {
+		if(!entry.is_regular_file() || entry.path().extension() != ".svg")
+			continue;
+		std::ifstream file(entry.path(), std::ios::binary);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		auto text = contents.str();
+		auto svg = lunasvg::Document::loadFromData(text.data(), text.size(), loader);
+		if(!svg) {
+			std::fprintf(stderr, "failed to parse %s\n", entry.path().string().c_str());
+			continue;
+		}
+		documents.push_back(document{ entry.path().filename().string(), std::move(svg) });
+	}
+	if(documents.empty()) {
+		std::fprintf(stderr, "no .svg files under %s\n", argv[1]);
+		return 1;
+	}
+
+	if(hashes) {
+		for(auto& d : documents) {
+			auto bmp = d.svg->renderToBitmap(256, 256);
+			std::printf("%s %016llx\n", d.name.c_str(), (unsigned long long)hash_bitmap(bmp));
+		}
+	}
+
+	for(int32_t size : { 64, 256, 1024 }) {
+		int32_t repetitions = size >= 1024 ? 3 : 20;
+		double pixels = 0.0;
+		auto start = std::chrono::steady_clock::now();
+		for(int32_t r = 0; r < repetitions; ++r) {
+			for(auto& d : documents) {
+				auto bmp = d.svg->renderToBitmap(size, size);
+				pixels += double(size) * double(size);
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("%d documents at %d px: %.1f Mpx/s\n", int32_t(documents.size()), size, pixels / 1e6 / seconds);
+	}
+	return 0;
+}
@@ -0,0 +1,313 @@
+// writes a block compressed .dds next to every .png under a directory; load_file_and_return_handle already prefers the dds
+// opaque images become BC1 (DXT1), images with any transparency BC3 (DXT5), both with a full box filtered mip chain
+// usage: TextureCompressor <directory> [--force]
+// without --force, a png whose dds is newer is skipped
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION 1
+#define STBI_ONLY_PNG 1
+#include "stb_image.h"
+
+namespace {
+
+struct image {
+	std::vector<uint8_t> rgba;
+	int32_t size_x = 0;
+	int32_t size_y = 0;
+};
+
+image half_size(image const& source) {
+	image result;
+	result.size_x = std::max(source.size_x / 2, 1);
+	result.size_y = std::max(source.size_y / 2, 1);
+	result.rgba.resize(size_t(result.size_x) * size_t(result.size_y) * 4);
+	for(int32_t y = 0; y < result.size_y; ++y) {
+		for(int32_t x = 0; x < result.size_x; ++x) {
+			int32_t x0 = std::min(x * 2, source.size_x - 1);
+			int32_t x1 = std::min(x * 2 + 1, source.size_x - 1);
+			int32_t y0 = std::min(y * 2, source.size_y - 1);
+			int32_t y1 = std::min(y * 2 + 1, source.size_y - 1);
+			for(int32_t c = 0; c < 4; ++c) {
+				uint32_t sum = source.rgba[(size_t(y0) * source.size_x + x0) * 4 + c] + source.rgba[(size_t(y0) * source.size_x + x1) * 4 + c]
+					+ source.rgba[(size_t(y1) * source.size_x + x0) * 4 + c] + source.rgba[(size_t(y1) * source.size_x + x1) * 4 + c];
+				result.rgba[(size_t(y) * result.size_x + x) * 4 + c] = uint8_t((sum + 2) / 4);
+			}
+		}
+	}
+	return result;
+}
+
+uint16_t to_565(float r, float g, float b) {
+	auto q = [](float v, int32_t max) { return uint16_t(std::clamp(int32_t(std::lround(v / 255.0f * float(max))), 0, max)); };
+	return uint16_t((q(r, 31) << 11) | (q(g, 63) << 5) | q(b, 31));
+}
+
+void from_565(uint16_t c, float out[3]) {
+	out[0] = float((c >> 11) & 31) * 255.0f / 31.0f;
+	out[1] = float((c >> 5) & 63) * 255.0f / 63.0f;
+	out[2] = float(c & 31) * 255.0f / 31.0f;
+}
+
+// endpoints are the extremes of the pixels along their principal axis, inset slightly, then every pixel takes the nearest palette entry
+void encode_color_block(uint8_t const pixels[16][4], uint8_t out[8]) {
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for(int32_t i = 0; i < 16; ++i)
+		for(int32_t c = 0; c < 3; ++c)
+			mean[c] += float(pixels[i][c]) / 16.0f;
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for(int32_t i = 0; i < 16; ++i) {
+		auto p = pixels[i];
+		float d[3] = { float(p[0]) - mean[0], float(p[1]) - mean[1], float(p[2]) - mean[2] };
+		cov[0] += d[0] * d[0];
+		cov[1] += d[0] * d[1];
+		cov[2] += d[0] * d[2];
+		cov[3] += d[1] * d[1];
+		cov[4] += d[1] * d[2];
+		cov[5] += d[2] * d[2];
+	}
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for(int32_t i = 0; i < 8; ++i) {
+		float next[3] = {
+			cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+			cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+			cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2] };
+		float length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+		if(length < 1e-6f)
+			break;
+		for(int32_t c = 0; c < 3; ++c)
+			axis[c] = next[c] / length;
+	}
+	float lowest = 0.0f;
+	float highest = 0.0f;
+	for(int32_t i = 0; i < 16; ++i) {
+		auto p = pixels[i];
+		float t = (float(p[0]) - mean[0]) * axis[0] + (float(p[1]) - mean[1]) * axis[1] + (float(p[2]) - mean[2]) * axis[2];
+		lowest = std::min(lowest, t);
+		highest = std::max(highest, t);
+	}
+	float axis_length_squared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float inset = (highest - lowest) / 32.0f;
+	lowest = (lowest + inset) / axis_length_squared;
+	highest = (highest - inset) / axis_length_squared;
+	uint16_t c0 = to_565(mean[0] + axis[0] * highest, mean[1] + axis[1] * highest, mean[2] + axis[2] * highest);
+	uint16_t c1 = to_565(mean[0] + axis[0] * lowest, mean[1] + axis[1] * lowest, mean[2] + axis[2] * lowest);
+	if(c0 < c1)
+		std::swap(c0, c1);
+
+	uint32_t indices = 0;
+	if(c0 != c1) {
+		float palette[4][3];
+		from_565(c0, palette[0]);
+		from_565(c1, palette[1]);
+		for(int32_t c = 0; c < 3; ++c) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+		for(int32_t i = 0; i < 16; ++i) {
+			uint32_t best = 0;
+			float best_distance = 1e30f;
+			for(uint32_t j = 0; j < 4; ++j) {
+				float dr = float(pixels[i][0]) - palette[j][0];
+				float dg = float(pixels[i][1]) - palette[j][1];
+				float db = float(pixels[i][2]) - palette[j][2];
+				float distance = dr * dr + dg * dg + db * db;
+				if(distance < best_distance) {
+					best_distance = distance;
+					best = j;
+				}
+			}
+			indices |= best << (2 * i);
+		}
+	}
+	out[0] = uint8_t(c0 & 0xFF);
+	out[1] = uint8_t(c0 >> 8);
+	out[2] = uint8_t(c1 & 0xFF);
+	out[3] = uint8_t(c1 >> 8);
+	std::memcpy(out + 4, &indices, 4);
+}
+
+// eight interpolated alpha values between the block's extremes
+void encode_alpha_block(uint8_t const pixels[16][4], uint8_t out[8]) {
+	uint8_t a0 = 0;
+	uint8_t a1 = 255;
+	for(int32_t i = 0; i < 16; ++i) {
+		a0 = std::max(a0, pixels[i][3]);
+		a1 = std::min(a1, pixels[i][3]);
+	}
+	uint64_t indices = 0;
+	if(a0 != a1) {
+		float palette[8];
+		palette[0] = float(a0);
+		palette[1] = float(a1);
+		for(int32_t j = 1; j < 7; ++j)
+			palette[j + 1] = (float(7 - j) * float(a0) + float(j) * float(a1)) / 7.0f;
+		for(int32_t i = 0; i < 16; ++i) {
+			uint64_t best = 0;
+			float best_distance = 1e30f;
+			for(uint64_t j = 0; j < 8; ++j) {
+				float distance = std::abs(float(pixels[i][3]) - palette[j]);
+				if(distance < best_distance) {
+					best_distance = distance;
+					best = j;
+				}
+			}
+			indices |= best << (3 * i);
+		}
+	}
+	out[0] = a0;
+	out[1] = a1;
+	for(int32_t i = 0; i < 6; ++i)
+		out[2 + i] = uint8_t(indices >> (8 * i));
+}
+
+void encode_level(image const& level, bool with_alpha, std::vector<uint8_t>& out) {
+	for(int32_t by = 0; by < level.size_y; by += 4) {
+		for(int32_t bx = 0; bx < level.size_x; bx += 4) {
+			uint8_t pixels[16][4];
+			for(int32_t i = 0; i < 16; ++i) {
+				// blocks hanging over the edge repeat the last row and column
+				int32_t x = std::min(bx + (i & 3), level.size_x - 1);
+				int32_t y = std::min(by + (i >> 2), level.size_y - 1);
+				std::memcpy(pixels[i], level.rgba.data() + (size_t(y) * level.size_x + x) * 4, 4);
+			}
+			uint8_t block[16];
+			if(with_alpha) {
+				encode_alpha_block(pixels, block);
+				encode_color_block(pixels, block + 8);
+				out.insert(out.end(), block, block + 16);
+			} else {
+				encode_color_block(pixels, block);
+				out.insert(out.end(), block, block + 8);
+			}
+		}
+	}
+}
+
+void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+	for(int32_t i = 0; i < 4; ++i)
+		out.push_back(uint8_t(v >> (8 * i)));
+}
+
+std::vector<uint8_t> make_dds(image const& source, bool with_alpha, uint32_t& mip_count) {
+	std::vector<uint8_t> blocks;
+	image level = source;
+	mip_count = 1;
+	encode_level(level, with_alpha, blocks);
+	while(level.size_x > 1 || level.size_y > 1) {
+		level = half_size(level);
+		encode_level(level, with_alpha, blocks);
+		++mip_count;
+	}
+
+	constexpr uint32_t ddsd_caps = 0x1, ddsd_height = 0x2, ddsd_width = 0x4, ddsd_pixelformat = 0x1000, ddsd_mipmapcount = 0x20000, ddsd_linearsize = 0x80000;
+	constexpr uint32_t ddpf_fourcc = 0x4;
+	constexpr uint32_t ddscaps_complex = 0x8, ddscaps_texture = 0x1000, ddscaps_mipmap = 0x400000;
+	uint32_t block_bytes = with_alpha ? 16 : 8;
+
+	std::vector<uint8_t> out;
+	out.reserve(128 + blocks.size());
+	put_u32(out, 0x20534444); // "DDS "
+	put_u32(out, 124);
+	put_u32(out, ddsd_caps | ddsd_height | ddsd_width | ddsd_pixelformat | ddsd_mipmapcount | ddsd_linearsize);
+	put_u32(out, uint32_t(source.size_y));
+	put_u32(out, uint32_t(source.size_x));
+	put_u32(out, uint32_t((source.size_x + 3) / 4) * uint32_t((source.size_y + 3) / 4) * block_bytes);
+	put_u32(out, 0);
+	put_u32(out, mip_count);
+	for(int32_t i = 0; i < 11; ++i)
+		put_u32(out, 0);
+	put_u32(out, 32);
+	put_u32(out, ddpf_fourcc);
+	put_u32(out, with_alpha ? 0x35545844 : 0x31545844); // "DXT5" : "DXT1"
+	for(int32_t i = 0; i < 5; ++i)
+		put_u32(out, 0);
+	put_u32(out, ddscaps_texture | ddscaps_complex | ddscaps_mipmap);
+	for(int32_t i = 0; i < 4; ++i)
+		put_u32(out, 0);
+	out.insert(out.end(), blocks.begin(), blocks.end());
+	return out;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::fprintf(stderr, "usage: %s <directory> [--force]\n", argv[0]);
+		return 1;
+	}
+	bool force = argc > 2 && std::strcmp(argv[2], "--force") == 0;
+
+	std::error_code ec;
+	if(!std::filesystem::is_directory(argv[1], ec)) {
+		std::fprintf(stderr, "%s is not a directory\n", argv[1]);
+		return 1;
+	}
+
+	uint32_t converted = 0;
+	uint32_t skipped = 0;
+	uint32_t failed = 0;
+	uint64_t rgba8_bytes = 0;
+	uint64_t compressed_bytes = 0;
+	for(auto const& item : std::filesystem::recursive_directory_iterator(argv[1])) {
+		if(!item.is_regular_file() || item.path().extension() != ".png")
+			continue;
+		auto target = item.path();
+		target.replace_extension(".dds");
+		if(!force && std::filesystem::exists(target, ec) && std::filesystem::last_write_time(target, ec) >= item.last_write_time(ec)) {
+			++skipped;
+			continue;
+		}
+
+		std::ifstream in(item.path(), std::ios::binary);
+		std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		image source;
+		int32_t channels = 4;
+		auto pixels = stbi_load_from_memory(reinterpret_cast<uint8_t const*>(contents.data()), int32_t(contents.size()), &source.size_x, &source.size_y, &channels, 4);
+		if(!pixels) {
+			std::fprintf(stderr, "could not decode %s\n", item.path().string().c_str());
+			++failed;
+			continue;
+		}
+		source.rgba.assign(pixels, pixels + size_t(source.size_x) * size_t(source.size_y) * 4);
+		stbi_image_free(pixels);
+
+		bool with_alpha = false;
+		for(size_t i = 3; i < source.rgba.size(); i += 4) {
+			if(source.rgba[i] != 255) {
+				with_alpha = true;
+				break;
+			}
+		}
+		uint32_t mip_count = 0;
+		auto dds = make_dds(source, with_alpha, mip_count);
+		std::ofstream out(target, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<char const*>(dds.data()), std::streamsize(dds.size()));
+		if(!out) {
+			std::fprintf(stderr, "could not write %s\n", target.string().c_str());
+			++failed;
+			continue;
+		}
+
+		// same mip chain as GL_RGBA8 for comparison
+		uint64_t uncompressed = 0;
+		for(int32_t x = source.size_x, y = source.size_y;; x = std::max(x / 2, 1), y = std::max(y / 2, 1)) {
+			uncompressed += uint64_t(x) * uint64_t(y) * 4;
+			if(x == 1 && y == 1)
+				break;
+		}
+		rgba8_bytes += uncompressed;
+		compressed_bytes += dds.size() - 128;
+		++converted;
+	}
+	std::printf("%u converted, %u up to date, %u failed; %llu bytes as rgba8 -> %llu bytes compressed\n", converted, skipped, failed,
+		(unsigned long long)rgba8_bytes, (unsigned long long)compressed_bytes);
+	return failed == 0 ? 0 : 1;
+}
@@ -112,6 +112,7 @@ enum class cursor_type : uint8_t {
 	text
 };
 void change_cursor(sys::state& state, cursor_type type);
+void present_frame(sys::state& game_state); // shows what was drawn outside of the window loop, such as the progress bar of on_create
 
 void get_window_size(sys::state const& game_state, int& width, int& height);
 int32_t cursor_blink_ms();
@@ -363,6 +363,10 @@ void change_cursor(sys::state& state, cursor_type type) {
 	//TODO: Implement on linux
 }
 
+void present_frame(sys::state& game_state) {
+	glfwSwapBuffers(game_state.win_ptr->window);
+}
+
 void emit_error_message(std::string const& content, bool fatal) {
 	std::fprintf(stderr, "%s", content.c_str());
 	if(fatal) {
@@ -121,6 +121,10 @@ void change_cursor(HWND hwnd, simple_fs::file_system common_fs, cursor_type type
 	SetClassLongPtr(hwnd, GCLP_HCURSOR, reinterpret_cast<LONG_PTR>(cursors[uint8_t(type)]));
 }
 
+void present_frame(sys::state& game_state) {
+	SwapBuffers(game_state.win_ptr->opengl_window_dc);
+}
+
 int32_t cursor_blink_ms() {
 	static int32_t ms = []() {auto t = GetCaretBlinkTime(); return t == INFINITE ? 0 : t * 2; }();
 	return ms;